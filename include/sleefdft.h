@@ -18,12 +18,34 @@ extern "C"
 #define SLEEF_MODE_ALT         (1 <<  2)
 #define SLEEF_MODE_FFTWCOMPAT  (1 <<  3)
 
+#define SLEEF_MODE_DCT         (1 <<  4)
+#define SLEEF_MODE_DST         (1 <<  5)
+
+#define SLEEF_MODE_SPLIT_IN    (1 <<  6)
+#define SLEEF_MODE_SPLIT_OUT   (1 <<  7)
+#define SLEEF_MODE_CORRELATE   (1 <<  8)
+// Six-step plans made with SLEEF_MODE_LARGE do nothing when executed in place
+#define SLEEF_MODE_LARGE       (1 <<  9)
+
 #define SLEEF_MODE_DEBUG       (1 << 10)
 #define SLEEF_MODE_VERBOSE     (1 << 11)
 #define SLEEF_MODE_NO_MT       (1 << 12)
+#define SLEEF_MODE_NO_SCRATCH  (1 << 13)
+#define SLEEF_MODE_ASYNC       (1 << 14)
+#define SLEEF_MODE_LOW_MEMORY  (1 << 15)
+#define SLEEF_MODE_FP16_IN     (1 << 16)
+#define SLEEF_MODE_FP16_OUT    (1 << 17)
+#define SLEEF_MODE_BF16_IN     (1 << 18)
+#define SLEEF_MODE_BF16_OUT    (1 << 19)
 
 #define SLEEF_MODE_ESTIMATE    (1 << 20)
 #define SLEEF_MODE_MEASURE     (2 << 20)
+#define SLEEF_MODE_INT16_IN    (1 << 22)
+#define SLEEF_MODE_INT16_OUT   (1 << 23)
+// An int32 input of a float plan is rounded to 24 significant bits
+#define SLEEF_MODE_INT32_IN    (1 << 24)
+#define SLEEF_MODE_INT32_OUT   (1 << 25)
+#define SLEEF_MODE_REALTIME    (1 << 26)
 
 #if (defined(__MINGW32__) || defined(__MINGW64__) || defined(__CYGWIN__) || defined(_MSC_VER)) && !defined(SLEEF_STATIC_LIBS)
 #ifdef IMPORT_IS_EXPORT
@@ -40,19 +62,68 @@ extern "C"
 
 IMPORT struct SleefDFT *SleefDFT_double_init1d(uint32_t n, const double *in, double *out, uint64_t mode);
 IMPORT struct SleefDFT *SleefDFT_double_init2d(uint32_t n, uint32_t m, const double *in, double *out, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init3d(uint32_t n0, uint32_t n1, uint32_t n2, const double *in, double *out, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_initnd(uint32_t rank, const uint32_t *dims, const double *in, double *out, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init1dConv(uint32_t klen, const double *kernel, uint32_t blen, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init1dSTFT(uint32_t n, uint32_t hop, uint32_t ringLen, uint32_t odist, const double *window, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init1dPruned(uint32_t n, uint32_t nIn, uint32_t outStart, uint32_t outCount, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init1dGoertzel(uint32_t n, uint32_t nBins, const uint32_t *bins, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init1dChirpZ(uint32_t n, uint32_t m, double f0, double df, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_double_init1dBatch(uint32_t n, uint32_t howmany, uint32_t istride, uint32_t idist, uint32_t ostride, uint32_t odist, const double *in, double *out, uint64_t mode);
 IMPORT void SleefDFT_double_execute(struct SleefDFT *ptr, const double *in, double *out);
+IMPORT void SleefDFT_double_execute_ws(struct SleefDFT *ptr, const double *in, double *out, void *workspace);
+IMPORT void SleefDFT_double_execute_split(struct SleefDFT *ptr, const double *inRe, const double *inIm, double *outRe, double *outIm);
+IMPORT void SleefDFT_double_execute_half(struct SleefDFT *ptr, const void *in, void *out);
+IMPORT int SleefDFT_double_execute_fixed(struct SleefDFT *ptr, const void *in, void *out);
+IMPORT void SleefDFT_double_execute_stft(struct SleefDFT *ptr, const double *ring, uint32_t pos, uint32_t nframes, double *out);
+IMPORT void SleefDFT_double_execute_slide(struct SleefDFT *ptr, const double *in, uint32_t count, double *bins);
+// setScale returns -1 for convolution, STFT, six-step, pruned,
+// Goertzel, chirp-z and real 2D plans, which cannot be scaled
+IMPORT int SleefDFT_double_setScale(struct SleefDFT *ptr, double scale);
+IMPORT int SleefDFT_double_setWindow(struct SleefDFT *ptr, const double *window);
+IMPORT size_t SleefDFT_double_getWorkspaceSize(struct SleefDFT *ptr);
 
 IMPORT struct SleefDFT *SleefDFT_float_init1d(uint32_t n, const float *in, float *out, uint64_t mode);
 IMPORT struct SleefDFT *SleefDFT_float_init2d(uint32_t n, uint32_t m, const float *in, float *out, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init3d(uint32_t n0, uint32_t n1, uint32_t n2, const float *in, float *out, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_initnd(uint32_t rank, const uint32_t *dims, const float *in, float *out, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init1dConv(uint32_t klen, const float *kernel, uint32_t blen, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init1dSTFT(uint32_t n, uint32_t hop, uint32_t ringLen, uint32_t odist, const float *window, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init1dPruned(uint32_t n, uint32_t nIn, uint32_t outStart, uint32_t outCount, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init1dGoertzel(uint32_t n, uint32_t nBins, const uint32_t *bins, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init1dChirpZ(uint32_t n, uint32_t m, float f0, float df, uint64_t mode);
+IMPORT struct SleefDFT *SleefDFT_float_init1dBatch(uint32_t n, uint32_t howmany, uint32_t istride, uint32_t idist, uint32_t ostride, uint32_t odist, const float *in, float *out, uint64_t mode);
 IMPORT void SleefDFT_float_execute(struct SleefDFT *ptr, const float *in, float *out);
+IMPORT void SleefDFT_float_execute_ws(struct SleefDFT *ptr, const float *in, float *out, void *workspace);
+IMPORT void SleefDFT_float_execute_split(struct SleefDFT *ptr, const float *inRe, const float *inIm, float *outRe, float *outIm);
+IMPORT void SleefDFT_float_execute_half(struct SleefDFT *ptr, const void *in, void *out);
+IMPORT int SleefDFT_float_execute_fixed(struct SleefDFT *ptr, const void *in, void *out);
+IMPORT void SleefDFT_float_execute_stft(struct SleefDFT *ptr, const float *ring, uint32_t pos, uint32_t nframes, float *out);
+IMPORT void SleefDFT_float_execute_slide(struct SleefDFT *ptr, const float *in, uint32_t count, float *bins);
+IMPORT int SleefDFT_float_setScale(struct SleefDFT *ptr, float scale);
+IMPORT int SleefDFT_float_setWindow(struct SleefDFT *ptr, const float *window);
+IMPORT size_t SleefDFT_float_getWorkspaceSize(struct SleefDFT *ptr);
 
 IMPORT void SleefDFT_dispose(struct SleefDFT *ptr);
+IMPORT void SleefDFT_resetStream(struct SleefDFT *ptr);
+IMPORT int SleefDFT_executeFile(struct SleefDFT *ptr, const char *inPath, const char *outPath);
 
 IMPORT void SleefDFT_setPath(struct SleefDFT *ptr, char *pathStr);
+IMPORT void SleefDFT_waitPlan(struct SleefDFT *ptr);
+// SleefDFT_dispose unlocks the pages that only the plan uses
+IMPORT int SleefDFT_lockMemory(struct SleefDFT *ptr);
 
 //
 
 IMPORT void SleefDFT_setPlanFilePath(const char *path, const char *arch, uint64_t mode);
+IMPORT void SleefDFT_setPlanTimeLimit(uint64_t milliseconds);
+// The thread backend must not be changed while any plan is executing
+IMPORT int SleefDFT_setThreadPool(int nThread);
+IMPORT void SleefDFT_setExecutor(void (*run)(void (*task)(void *, int), void *taskArg, int nTask, void *arg), void *arg, int nThread);
+IMPORT size_t SleefDFT_exportPlans(char **buf);
+IMPORT int SleefDFT_importPlans(const char *buf);
+IMPORT int SleefDFT_saveBinaryPlanFile(const char *path);
+IMPORT int SleefDFT_loadBinaryPlanFile(const char *path);
 
 #define SLEEF_PLAN_AUTOMATIC 0
 #define SLEEF_PLAN_READONLY (1 << 0)
@@ -345,3 +345,82 @@ int ArrayMap_save(ArrayMap *thiz, const char *fn, const char *prefix, const char
   free(line);
   return 0;
 }
+
+// The functions below use the same format as ArrayMap_save and
+// ArrayMap_load, with a string in memory instead of a file
+
+static char *makePrefix2(const char *prefix) {
+  char *prefix2 = malloc(strlen(prefix)+10);
+  strcpy(prefix2, prefix);
+  String_trim(prefix2);
+  for(char *p = prefix2;*p != '\0';p++) {
+    if (*p == ':') *p = ';';
+    if (*p == ' ') *p = '_';
+  }
+  strcat(prefix2, " : ");
+  return prefix2;
+}
+
+char *ArrayMap_saveToString(ArrayMap *thiz, const char *prefix, const char *idstr) {
+  assert(thiz != NULL && thiz->magic == MAGIC_ARRAYMAP);
+
+  char *prefix2 = makePrefix2(prefix);
+  const size_t prefixLen = strlen(prefix2);
+
+  uint64_t *keys = ArrayMap_keyArray(thiz);
+  int s = ArrayMap_size(thiz);
+
+  size_t len = strlen(idstr) + 1;
+  for(int i=0;i<s;i++) len += prefixLen + strlen(ArrayMap_get(thiz, keys[i])) + 24;
+
+  char *buf = malloc(len), *p = buf;
+  p += sprintf(p, "%s", idstr);
+
+  for(int i=0;i<s;i++) {
+    p += sprintf(p, "%s %" PRIx64 " : %s\n", prefix2, keys[i], (char *)ArrayMap_get(thiz, keys[i]));
+  }
+
+  free(keys);
+  free(prefix2);
+
+  return buf;
+}
+
+int ArrayMap_loadFromString(ArrayMap *thiz, const char *buf, const char *prefix, const char *idstr) {
+  assert(thiz != NULL && thiz->magic == MAGIC_ARRAYMAP);
+
+  const size_t idstrlen = strlen(idstr);
+  if (strncmp(buf, idstr, idstrlen) != 0) return -1;
+
+  char *prefix2 = makePrefix2(prefix);
+  const size_t prefixLen = strlen(prefix2);
+  int n = 0;
+
+  for(const char *line = buf + idstrlen;*line != '\0';) {
+    const char *next = strchr(line, '\n');
+    size_t len = next == NULL ? strlen(line) : (size_t)(next - line);
+
+    if (len > prefixLen && strncmp(line, prefix2, prefixLen) == 0) {
+      char *l = malloc(len+1), *value = malloc(len+1);
+      memcpy(l, line, len);
+      l[len] = '\0';
+
+      uint64_t key;
+      if (sscanf(l + prefixLen, "%" SCNx64 " : %s", &key, value) == 2) {
+	char *old = ArrayMap_put(thiz, key, value);
+	if (old != NULL) free(old);
+	n++;
+      } else {
+	free(value);
+      }
+      free(l);
+    }
+
+    if (next == NULL) break;
+    line = next + 1;
+  }
+
+  free(prefix2);
+
+  return n;
+}
@@ -18,4 +18,6 @@ uint64_t *ArrayMap_keyArray(ArrayMap *thiz);
 void **ArrayMap_valueArray(ArrayMap *thiz);
 int ArrayMap_save(ArrayMap *thiz, const char *fn, const char *prefix, const char *idstr);
 ArrayMap *ArrayMap_load(const char *fn, const char *prefix, const char *idstr, int doLock);
+char *ArrayMap_saveToString(ArrayMap *thiz, const char *prefix, const char *idstr);
+int ArrayMap_loadFromString(ArrayMap *thiz, const char *buf, const char *prefix, const char *idstr);
 #endif
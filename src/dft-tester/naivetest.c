@@ -6,12 +6,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 
 #include <math.h>
 #include <complex.h>
 
+#ifdef ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include "sleef.h"
 #include "sleefdft.h"
 #include "misc.h"
@@ -24,7 +29,22 @@
 
 #if BASETYPEID == 1
 #define SleefDFT_init SleefDFT_double_init1d
+#define SleefDFT_initBatch SleefDFT_double_init1dBatch
+#define SleefDFT_initConv SleefDFT_double_init1dConv
+#define SleefDFT_initSTFT SleefDFT_double_init1dSTFT
+#define SleefDFT_initPruned SleefDFT_double_init1dPruned
+#define SleefDFT_initGoertzel SleefDFT_double_init1dGoertzel
+#define SleefDFT_initChirpZ SleefDFT_double_init1dChirpZ
 #define SleefDFT_execute SleefDFT_double_execute
+#define SleefDFT_execute_ws SleefDFT_double_execute_ws
+#define SleefDFT_execute_split SleefDFT_double_execute_split
+#define SleefDFT_execute_half SleefDFT_double_execute_half
+#define SleefDFT_execute_fixed SleefDFT_double_execute_fixed
+#define SleefDFT_execute_stft SleefDFT_double_execute_stft
+#define SleefDFT_execute_slide SleefDFT_double_execute_slide
+#define SleefDFT_setScale SleefDFT_double_setScale
+#define SleefDFT_setWindow SleefDFT_double_setWindow
+#define SleefDFT_getWorkspaceSize SleefDFT_double_getWorkspaceSize
 typedef double real;
 
 typedef double complex cmpl;
@@ -34,7 +54,22 @@ cmpl omega(double n, double kn) {
 }
 #elif BASETYPEID == 2
 #define SleefDFT_init SleefDFT_float_init1d
+#define SleefDFT_initBatch SleefDFT_float_init1dBatch
+#define SleefDFT_initConv SleefDFT_float_init1dConv
+#define SleefDFT_initSTFT SleefDFT_float_init1dSTFT
+#define SleefDFT_initPruned SleefDFT_float_init1dPruned
+#define SleefDFT_initGoertzel SleefDFT_float_init1dGoertzel
+#define SleefDFT_initChirpZ SleefDFT_float_init1dChirpZ
 #define SleefDFT_execute SleefDFT_float_execute
+#define SleefDFT_execute_ws SleefDFT_float_execute_ws
+#define SleefDFT_execute_split SleefDFT_float_execute_split
+#define SleefDFT_execute_half SleefDFT_float_execute_half
+#define SleefDFT_execute_fixed SleefDFT_float_execute_fixed
+#define SleefDFT_execute_stft SleefDFT_float_execute_stft
+#define SleefDFT_execute_slide SleefDFT_float_execute_slide
+#define SleefDFT_setScale SleefDFT_float_setScale
+#define SleefDFT_setWindow SleefDFT_float_setWindow
+#define SleefDFT_getWorkspaceSize SleefDFT_float_getWorkspaceSize
 typedef float real;
 
 typedef double complex cmpl;
@@ -44,7 +79,22 @@ cmpl omega(double n, double kn) {
 }
 #elif BASETYPEID == 3
 #define SleefDFT_init SleefDFT_longdouble_init1d
+#define SleefDFT_initBatch SleefDFT_longdouble_init1dBatch
+#define SleefDFT_initConv SleefDFT_longdouble_init1dConv
+#define SleefDFT_initSTFT SleefDFT_longdouble_init1dSTFT
+#define SleefDFT_initPruned SleefDFT_longdouble_init1dPruned
+#define SleefDFT_initGoertzel SleefDFT_longdouble_init1dGoertzel
+#define SleefDFT_initChirpZ SleefDFT_longdouble_init1dChirpZ
 #define SleefDFT_execute SleefDFT_longdouble_execute
+#define SleefDFT_execute_ws SleefDFT_longdouble_execute_ws
+#define SleefDFT_execute_split SleefDFT_longdouble_execute_split
+#define SleefDFT_execute_half SleefDFT_longdouble_execute_half
+#define SleefDFT_execute_fixed SleefDFT_longdouble_execute_fixed
+#define SleefDFT_execute_stft SleefDFT_longdouble_execute_stft
+#define SleefDFT_execute_slide SleefDFT_longdouble_execute_slide
+#define SleefDFT_setScale SleefDFT_longdouble_setScale
+#define SleefDFT_setWindow SleefDFT_longdouble_setWindow
+#define SleefDFT_getWorkspaceSize SleefDFT_longdouble_getWorkspaceSize
 typedef double real;
 
 typedef double complex cmpl;
@@ -56,7 +106,20 @@ cmpl omega(double n, double kn) {
 #include <quadmath.h>
 
 #define SleefDFT_init SleefDFT_quad_init1d
+#define SleefDFT_initBatch SleefDFT_quad_init1dBatch
+#define SleefDFT_initConv SleefDFT_quad_init1dConv
+#define SleefDFT_initSTFT SleefDFT_quad_init1dSTFT
+#define SleefDFT_initPruned SleefDFT_quad_init1dPruned
+#define SleefDFT_initGoertzel SleefDFT_quad_init1dGoertzel
+#define SleefDFT_initChirpZ SleefDFT_quad_init1dChirpZ
 #define SleefDFT_execute SleefDFT_quad_execute
+#define SleefDFT_execute_ws SleefDFT_quad_execute_ws
+#define SleefDFT_execute_split SleefDFT_quad_execute_split
+#define SleefDFT_execute_stft SleefDFT_quad_execute_stft
+#define SleefDFT_execute_slide SleefDFT_quad_execute_slide
+#define SleefDFT_setScale SleefDFT_quad_setScale
+#define SleefDFT_setWindow SleefDFT_quad_setWindow
+#define SleefDFT_getWorkspaceSize SleefDFT_quad_getWorkspaceSize
 typedef Sleef_quad real;
 
 typedef double complex cmpl;
@@ -457,28 +520,1287 @@ int check_arb(int n) {
   return success;
 }
 
-int main(int argc, char **argv) {
-  if (argc != 2) {
-    fprintf(stderr, "%s <log2n>\n", argv[0]);
-    exit(-1);
+// DCT-II/III and DST-II/III, compared with the definitions
+int check_r2r(int n, uint64_t kind) {
+  int i, k;
+
+  real *sx = (real *)Sleef_malloc(n * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n * sizeof(real));
+
+  double *tx = (double *)malloc(sizeof(double)*n);
+  double *ty = (double *)malloc(sizeof(double)*n);
+
+  for(i=0;i<n;i++) {
+    tx[i] = 2.0 * (rand() / (double)RAND_MAX) - 1;
+    sx[i] = tx[i];
   }
 
-  const int n = 1 << atoi(argv[1]);
+  for(k=0;k<n;k++) {
+    ty[k] = 0;
+    for(i=0;i<n;i++) {
+      if (kind == (SLEEF_MODE_DCT | SLEEF_MODE_FORWARD)) {
+	ty[k] += 2 * tx[i] * cos(M_PIl * k * (2*i+1) / (2.0*n));
+      } else if (kind == (SLEEF_MODE_DCT | SLEEF_MODE_BACKWARD)) {
+	ty[k] += i == 0 ? tx[0] : 2 * tx[i] * cos(M_PIl * i * (2*k+1) / (2.0*n));
+      } else if (kind == (SLEEF_MODE_DST | SLEEF_MODE_FORWARD)) {
+	ty[k] += 2 * tx[i] * sin(M_PIl * (k+1) * (2*i+1) / (2.0*n));
+      } else {
+	ty[k] += i == n-1 ? ((k & 1) ? -tx[i] : tx[i]) : 2 * tx[i] * sin(M_PIl * (i+1) * (2*k+1) / (2.0*n));
+      }
+    }
+  }
 
-  srand((unsigned int)time(NULL));
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, kind | MODE | SLEEF_MODE_VERBOSE);
 
-  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
 
-  //
+  SleefDFT_execute(p, sx, sy);
 
   int success = 1;
-  
-  printf("complex  forward   : %s\n", (success &= check_cf(n))  ? "OK" : "NG");
-  printf("complex  backward  : %s\n", (success &= check_cb(n))  ? "OK" : "NG");
-  printf("real     forward   : %s\n", (success &= check_rf(n))  ? "OK" : "NG");
-  printf("real     backward  : %s\n", (success &= check_rb(n))  ? "OK" : "NG");
-  printf("real alt forward   : %s\n", (success &= check_arf(n)) ? "OK" : "NG");
-  printf("real alt backward  : %s\n", (success &= check_arb(n)) ? "OK" : "NG");
+
+  for(k=0;k<n;k++) {
+    if (fabs(sy[k] - ty[k]) > THRES) success = 0;
+  }
+
+  free(tx);
+  free(ty);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// complex forward with a caller-supplied workspace
+int check_ws(int n) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, MODE | SLEEF_MODE_NO_SCRATCH);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  void *ws = Sleef_malloc(SleefDFT_getWorkspaceSize(p));
+
+  SleefDFT_execute_ws(p, sx, sy, ws);
+  SleefDFT_execute(p, sx, sz);
+
+  int success = 1;
+
+  for(i=0;i<n;i++) {
+    if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES) ||
+	sy[(i*2+0)] != sz[(i*2+0)] || sy[(i*2+1)] != sz[(i*2+1)]) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(ws);
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// complex forward with split input and output, with a planar input
+// followed by an interleaved output, and with an interleaved input
+// followed by a scaled planar output
+int check_split(int n) {
+  int i;
+
+  real *sr = (real *)Sleef_malloc(n * sizeof(real));
+  real *si = (real *)Sleef_malloc(n * sizeof(real));
+  real *dr = (real *)Sleef_malloc(n * sizeof(real));
+  real *di = (real *)Sleef_malloc(n * sizeof(real));
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *er = (real *)Sleef_malloc(n * sizeof(real));
+  real *ei = (real *)Sleef_malloc(n * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sr[i] = sx[i  ] = creal(ts[i]);
+    si[i] = sx[n+i] = cimag(ts[i]);
+    sz[i*2+0] = creal(ts[i]);
+    sz[i*2+1] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, MODE | SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT);
+  struct SleefDFT *q = SleefDFT_init(n, NULL, NULL, MODE | SLEEF_MODE_SPLIT_IN);
+  struct SleefDFT *r = SleefDFT_init(n, NULL, NULL, MODE | SLEEF_MODE_SPLIT_OUT);
+
+  if (p == NULL || q == NULL || r == NULL || SleefDFT_setScale(r, 0.5) != 0) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute_split(p, sr, si, dr, di);
+  SleefDFT_execute(q, sx, sy);
+  SleefDFT_execute_split(r, sz, NULL, er, ei);
+
+  int success = 1;
+
+  for(i=0;i<n;i++) {
+    if ((fabs(dr[i] - creal(fs[i])) > THRES) ||
+	(fabs(di[i] - cimag(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES) ||
+	(fabs(er[i] - 0.5 * creal(fs[i])) > THRES) ||
+	(fabs(ei[i] - 0.5 * cimag(fs[i])) > THRES)) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sr);
+  Sleef_free(si);
+  Sleef_free(dr);
+  Sleef_free(di);
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+  Sleef_free(er);
+  Sleef_free(ei);
+  SleefDFT_dispose(p);
+  SleefDFT_dispose(q);
+  SleefDFT_dispose(r);
+
+  return success;
+}
+
+static double fromHalf(uint16_t h, int bf) {
+  if (bf) {
+    int e = (h >> 7) & 0xff;
+    double x = e == 0 ? ldexp(h & 0x7f, -133) : ldexp((h & 0x7f) | 0x80, e - 134);
+    return (h & 0x8000) ? -x : x;
+  }
+  int e = (h >> 10) & 0x1f;
+  double x = e == 0 ? ldexp(h & 0x3ff, -24) : ldexp((h & 0x3ff) | 0x400, e - 25);
+  return (h & 0x8000) ? -x : x;
+}
+
+// random 16-bit value between 1/16 and 1 in magnitude
+static uint16_t randHalf(int bf) {
+  if (bf) return (uint16_t)(((rand() & 1) << 15) | ((123 + rand() % 4) << 7) | (rand() & 0x7f));
+  return (uint16_t)(((rand() & 1) << 15) | ((11 + rand() % 4) << 10) | (rand() & 0x3ff));
+}
+
+// complex transform with 16-bit input, output or both. A 16-bit
+// output is compared with a tolerance of a few units in its last
+// place.
+int check_half(int n, uint64_t mode) {
+  const int halfIn = (mode & (SLEEF_MODE_FP16_IN | SLEEF_MODE_BF16_IN)) != 0, bfIn = (mode & SLEEF_MODE_BF16_IN) != 0;
+  const int halfOut = (mode & (SLEEF_MODE_FP16_OUT | SLEEF_MODE_BF16_OUT)) != 0, bfOut = (mode & SLEEF_MODE_BF16_OUT) != 0;
+  int i;
+
+  uint16_t *hx = (uint16_t *)Sleef_malloc(n*2 * sizeof(uint16_t));
+  uint16_t *hy = (uint16_t *)Sleef_malloc(n*2 * sizeof(uint16_t));
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n*2;i++) {
+    hx[i] = randHalf(bfIn);
+    sx[i] = (real)fromHalf(hx[i], bfIn);
+  }
+
+  for(i=0;i<n;i++) ts[i] = sx[i*2+0] + sx[i*2+1] * _Complex_I;
+
+  if ((mode & SLEEF_MODE_BACKWARD) == 0) forward(ts, fs, n); else backward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, MODE | mode);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute_half(p, halfIn ? (void *)hx : (void *)sx, halfOut ? (void *)hy : (void *)sy);
+
+  int success = 1;
+  const double ulp = halfOut ? (bfOut ? 1.0 / 128 : 1.0 / 1024) : 0;
+
+  for(i=0;i<n;i++) {
+    double re = halfOut ? fromHalf(hy[i*2+0], bfOut) : sy[i*2+0];
+    double im = halfOut ? fromHalf(hy[i*2+1], bfOut) : sy[i*2+1];
+    if ((fabs(re - creal(fs[i])) > THRES + ulp * fabs(creal(fs[i]))) ||
+	(fabs(im - cimag(fs[i])) > THRES + ulp * fabs(cimag(fs[i])))) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(hx);
+  Sleef_free(hy);
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// complex transform with fixed-point input, output or both. A
+// fixed-point output carries a block exponent, and is compared with a
+// tolerance of one unit in its last place.
+int check_fixed(int n, uint64_t mode) {
+  const int int16In = (mode & SLEEF_MODE_INT16_IN) != 0, int32In = (mode & SLEEF_MODE_INT32_IN) != 0;
+  const int int16Out = (mode & SLEEF_MODE_INT16_OUT) != 0, int32Out = (mode & SLEEF_MODE_INT32_OUT) != 0;
+  const double amp = 16384;
+  int i;
+
+  int16_t *ix16 = (int16_t *)Sleef_malloc(n*2 * sizeof(int16_t));
+  int16_t *iy16 = (int16_t *)Sleef_malloc(n*2 * sizeof(int16_t));
+  int32_t *ix32 = (int32_t *)Sleef_malloc(n*2 * sizeof(int32_t));
+  int32_t *iy32 = (int32_t *)Sleef_malloc(n*2 * sizeof(int32_t));
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n*2;i++) {
+    ix32[i] = ix16[i] = (int16_t)((2.0 * (rand() / (double)RAND_MAX) - 1) * amp);
+    sx[i] = ix16[i];
+  }
+
+  for(i=0;i<n;i++) ts[i] = sx[i*2+0] + sx[i*2+1] * _Complex_I;
+
+  if ((mode & SLEEF_MODE_BACKWARD) == 0) forward(ts, fs, n); else backward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, MODE | mode);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  int e = SleefDFT_execute_fixed(p, int16In ? (void *)ix16 : int32In ? (void *)ix32 : (void *)sx,
+				 int16Out ? (void *)iy16 : int32Out ? (void *)iy32 : (void *)sy);
+
+  int success = int16Out || int32Out || e == 0;
+  const double tol = THRES * amp + ((int16Out || int32Out) ? ldexp(1, e) : 0);
+
+  for(i=0;i<n;i++) {
+    double re = int16Out ? ldexp(iy16[i*2+0], e) : int32Out ? ldexp(iy32[i*2+0], e) : sy[i*2+0];
+    double im = int16Out ? ldexp(iy16[i*2+1], e) : int32Out ? ldexp(iy32[i*2+1], e) : sy[i*2+1];
+    if ((fabs(re - creal(fs[i])) > tol) || (fabs(im - cimag(fs[i])) > tol)) success = 0;
+  }
+
+  if (int16Out) {
+    int peak = 0;
+    for(i=0;i<n*2;i++) peak = peak > abs(iy16[i]) ? peak : abs(iy16[i]);
+    if (peak < 16384) success = 0;
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(ix16);
+  Sleef_free(iy16);
+  Sleef_free(ix32);
+  Sleef_free(iy32);
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// complex or real forward with a window applied to the input and a
+// scale factor applied to the output
+int check_scalewin(int n, uint64_t mode) {
+  int i;
+  const int isReal = (mode & SLEEF_MODE_REAL) != 0, m = isReal ? n/2+1 : n;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc((n+2)*2 * sizeof(real));
+  real *sw = (real *)Sleef_malloc(n * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    sw[i] = 0.5 - 0.5 * cos(2 * M_PI * i / n);
+    if (isReal) {
+      sx[i] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+      ts[i] = sx[i] * sw[i];
+    } else {
+      sx[i*2+0] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+      sx[i*2+1] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+      ts[i] = (sx[i*2+0] + _Complex_I * sx[i*2+1]) * sw[i];
+    }
+  }
+
+  forward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, mode | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  const double scale = 1.0 / n;
+  int success = SleefDFT_setScale(p, scale) == 0 && SleefDFT_setWindow(p, sw) == 0;
+
+  SleefDFT_execute(p, sx, sy);
+
+  for(i=0;i<m;i++) {
+    if ((fabs(sy[(i*2+0)] - creal(fs[i]) * scale) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i]) * scale) > THRES)) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sw);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// streamed convolution and correlation of three blocks, compared with
+// the direct sums
+int check_conv(int n, uint64_t mode) {
+  const int klen = (n < 64 ? n : 64)/2 + 3, blen = n + 5, nb = 3, len = nb * blen;
+  const int c = (mode & SLEEF_MODE_REAL) != 0 ? 1 : 2, corr = (mode & SLEEF_MODE_CORRELATE) != 0;
+
+  real *sh = (real *)Sleef_malloc(klen*c * sizeof(real));
+  real *sx = (real *)Sleef_malloc(len*c * sizeof(real));
+  real *sy = (real *)Sleef_malloc(len*c * sizeof(real));
+
+  for(int i=0;i<klen*c;i++) sh[i] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+  for(int i=0;i<len*c;i++) sx[i] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+
+  struct SleefDFT *p = SleefDFT_initConv(klen, sh, blen, mode | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  for(int b=0;b<nb;b++) SleefDFT_execute(p, &sx[b*blen*c], &sy[b*blen*c]);
+
+  // y[i] = sum_k h[k] x[i-k], or sum_k conj(h[k]) x[i-(klen-1)+k]
+
+  int success = 1;
+
+  for(int i=0;i<len;i++) {
+    cmpl y = 0;
+    for(int k=0;k<klen;k++) {
+      int j = corr ? i-(klen-1)+k : i-k;
+      if (j < 0) continue;
+      cmpl h = c == 1 ? sh[k] : sh[k*2+0] + _Complex_I * sh[k*2+1];
+      cmpl x = c == 1 ? sx[j] : sx[j*2+0] + _Complex_I * sx[j*2+1];
+      y += (corr ? conj(h) : h) * x;
+    }
+    if (fabs(sy[i*c] - creal(y)) > THRES) success = 0;
+    if (c == 2 && fabs(sy[i*2+1] - cimag(y)) > THRES) success = 0;
+  }
+
+  Sleef_free(sh);
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// STFT of frames of a ring buffer with a Hann window, once from the
+// start of the ring and once across its end, compared with the real
+// forward transforms of the windowed frames. Short frames are many,
+// so that some are computed in blocks.
+int check_stft(int n) {
+  const int hop = n/2 > 0 ? n/2 : 1, ringLen = (n <= 16 ? 80 : 3)*n + 7, nf = (ringLen - n) / hop + 1, odist = n/2 + 3;
+  const int pos = ringLen - n/2 - 1;
+
+  real *sx = (real *)Sleef_malloc(ringLen * sizeof(real));
+  real *sy = (real *)Sleef_malloc(nf*odist*2 * sizeof(real));
+  real *sw = (real *)Sleef_malloc(n * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(int i=0;i<ringLen;i++) sx[i] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+  for(int i=0;i<n;i++) sw[i] = 0.5 - 0.5 * cos(2 * M_PI * i / n);
+
+  struct SleefDFT *p = SleefDFT_initSTFT(n, hop, ringLen, odist, sw, MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  int success = 1;
+
+  for(int k=0;k<2;k++) {
+    const int start = k == 0 ? 0 : pos;
+
+    if (k == 0) {
+      SleefDFT_execute(p, sx, sy);
+    } else {
+      SleefDFT_execute_stft(p, sx, start, nf, sy);
+    }
+
+    for(int f=0;f<nf;f++) {
+      for(int i=0;i<n;i++) ts[i] = sx[(start + f*hop + i) % ringLen] * sw[i];
+
+      forward(ts, fs, n);
+
+      for(int i=0;i<n/2+1;i++) {
+	if ((fabs(sy[(f*odist+i)*2+0] - creal(fs[i])) > THRES) ||
+	    (fabs(sy[(f*odist+i)*2+1] - cimag(fs[i])) > THRES)) {
+	  success = 0;
+	}
+      }
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sw);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// complex transforms with the six-step plan, in memory and between
+// files
+int check_large(int n, uint64_t mode) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = (2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I;
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  if ((mode & SLEEF_MODE_BACKWARD) != 0) backward(ts, fs, n); else forward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, mode | SLEEF_MODE_LARGE | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute(p, sx, sy);
+
+  int success = 1;
+
+  for(i=0;i<n;i++) {
+    if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES)) {
+      success = 0;
+    }
+  }
+
+  // Executed in place, a six-step plan leaves the buffer as it is. A
+  // length too short for one gets an ordinary plan, which transforms
+  // the buffer.
+
+  memcpy(sy, sx, n*2 * sizeof(real));
+  SleefDFT_execute(p, sy, sy);
+
+  int transformed = 1;
+  for(i=0;i<n;i++) {
+    if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES)) {
+      transformed = 0;
+    }
+  }
+  if (!transformed && memcmp(sy, sx, n*2 * sizeof(real)) != 0) success = 0;
+
+#if !(defined(__MINGW32__) || defined(__MINGW64__) || defined(_MSC_VER))
+  if (n >= 256) {
+    char fin[64], fout[64];
+    sprintf(fin, "naivetest%d_%d.in", BASETYPEID, n);
+    sprintf(fout, "naivetest%d_%d.out", BASETYPEID, n);
+
+    FILE *fp = fopen(fin, "wb");
+    success = success && fp != NULL && fwrite(sx, sizeof(real), n*2, fp) == (size_t)n*2;
+    if (fp != NULL) fclose(fp);
+
+    success = success && SleefDFT_executeFile(p, fin, fout) == 0;
+
+    memset(sy, 0, n*2 * sizeof(real));
+    fp = fopen(fout, "rb");
+    success = success && fp != NULL && fread(sy, sizeof(real), n*2, fp) == (size_t)n*2;
+    if (fp != NULL) fclose(fp);
+
+    remove(fin);
+    remove(fout);
+
+    for(i=0;i<n;i++) {
+      if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	  (fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES)) {
+	success = 0;
+      }
+    }
+  }
+#endif
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// pruned transforms, compared with the bins outStart, ...,
+// outStart + outCount - 1 (mod n) of the transform of the first nIn
+// inputs padded with zeros
+int check_pruned(int n, int nIn, int outStart, int outCount, uint64_t mode) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(nIn*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(outCount*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0;
+    if (i >= nIn) continue;
+    ts[i] = (2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I;
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  if ((mode & SLEEF_MODE_BACKWARD) != 0) backward(ts, fs, n); else forward(ts, fs, n);
+
+  struct SleefDFT *p = SleefDFT_initPruned(n, nIn, outStart, outCount, mode | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute(p, sx, sy);
+
+  int success = 1;
+
+  for(i=0;i<outCount;i++) {
+    cmpl f = fs[(outStart + i) % n];
+    if ((fabs(sy[(i*2+0)] - creal(f)) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(f)) > THRES)) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// Goertzel evaluation of a few bins, compared with the transform of
+// the first n samples, and then slid by a few samples and compared
+// with the transform of the shifted window.
+int check_goertzel(int n, uint64_t mode) {
+  const int nBins = 9, shift = 5, cplx = (mode & SLEEF_MODE_REAL) == 0;
+  int i, s;
+
+  uint32_t bins[9];
+  for(i=0;i<nBins-2;i++) bins[i] = (uint32_t)(((int64_t)i * n / 7 + i) % n);
+  bins[nBins-2] = n/2;
+  bins[nBins-1] = n-1;
+
+  real *sx = (real *)Sleef_malloc((n+shift)*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(nBins*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*(n+shift));
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n+shift;i++) {
+    ts[i] = (2.0 * (rand() / (double)RAND_MAX) - 1);
+    if (cplx) {
+      ts[i] += (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I;
+      sx[(i*2+0)] = creal(ts[i]);
+      sx[(i*2+1)] = cimag(ts[i]);
+    } else {
+      sx[i] = creal(ts[i]);
+    }
+  }
+
+  struct SleefDFT *p = SleefDFT_initGoertzel(n, nBins, bins, mode | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  int success = 1;
+
+  for(s=0;s<=shift;s+=shift) {
+    if (s == 0) {
+      SleefDFT_execute(p, sx, sy);
+    } else {
+      SleefDFT_execute_slide(p, sx, shift, sy);
+    }
+
+    if ((mode & SLEEF_MODE_BACKWARD) != 0) backward(ts + s, fs, n); else forward(ts + s, fs, n);
+
+    for(i=0;i<nBins;i++) {
+      cmpl f = fs[bins[i]];
+      if ((fabs(sy[(i*2+0)] - creal(f)) > THRES) ||
+	  (fabs(sy[(i*2+1)] - cimag(f)) > THRES)) {
+	success = 0;
+      }
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// chirp-z transforms, compared with the sums over the n inputs at the
+// m frequencies f0 + k df
+int check_chirpz(int n, int m, double f0, double df, uint64_t mode) {
+  int i, k;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(m*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = (2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I;
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  struct SleefDFT *p = SleefDFT_initChirpZ(n, m, (real)f0, (real)df, mode | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute(p, sx, sy);
+
+  int success = 1;
+  const double sign = (mode & SLEEF_MODE_BACKWARD) != 0 ? 1 : -1;
+
+  for(k=0;k<m;k++) {
+    cmpl f = 0;
+    for(i=0;i<n;i++) f += ts[i] * cexp(sign * 2 * M_PIl * _Complex_I * ((double)(real)f0 + k * (double)(real)df) * i);
+    if ((fabs(sy[(k*2+0)] - creal(f)) > THRES) ||
+	(fabs(sy[(k*2+1)] - cimag(f)) > THRES)) {
+      success = 0;
+    }
+  }
+
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// complex forward, planned in the background under a time limit
+int check_async(int n) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  SleefDFT_setPlanTimeLimit(100);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_MEASURE | SLEEF_MODE_ASYNC);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute(p, sx, sy);
+  SleefDFT_waitPlan(p);
+  SleefDFT_execute(p, sx, sz);
+
+  SleefDFT_setPlanTimeLimit(0);
+
+  int success = 1;
+
+  for(i=0;i<n;i++) {
+    if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES) ||
+	(fabs(sz[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sz[(i*2+1)] - cimag(fs[i])) > THRES)) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+#ifdef ENABLE_PTHREAD
+typedef struct AsyncExecArg {
+  struct SleefDFT *p;
+  real *sx, *sy;
+  cmpl *fs;
+  int n, count, success;
+  volatile int stop;
+} AsyncExecArg;
+
+static void *asyncExecThread(void *ptr) {
+  AsyncExecArg *a = (AsyncExecArg *)ptr;
+
+  // Keeps executing until some time after SleefDFT_waitPlan returns,
+  // so that executes run before, during and after the refined path
+  // is adopted
+
+  for(int after = 0;after < 16;a->count++) {
+    if (a->stop) after++;
+    SleefDFT_execute(a->p, a->sx, a->sy);
+    for(int i=0;i<a->n;i++) {
+      if ((fabs(a->sy[(i*2+0)] - creal(a->fs[i])) > THRES) ||
+	  (fabs(a->sy[(i*2+1)] - cimag(a->fs[i])) > THRES)) {
+	a->success = 0;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// complex forward executed from another thread while the background
+// planner finishes
+int check_async_concurrent(int n) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  SleefDFT_setPlanTimeLimit(100);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_MEASURE | SLEEF_MODE_ASYNC | SLEEF_MODE_NO_MT);
+
+  int success = 0;
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+  } else {
+    AsyncExecArg a = { p, sx, sy, fs, n, 0, 1, 0 };
+    pthread_t th;
+
+    if (pthread_create(&th, NULL, asyncExecThread, &a) == 0) {
+      SleefDFT_waitPlan(p);
+      a.stop = 1;
+      pthread_join(th, NULL);
+      success = a.success && a.count > 0;
+    }
+
+    SleefDFT_dispose(p);
+  }
+
+  SleefDFT_setPlanTimeLimit(0);
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+
+  return success;
+}
+#endif
+
+// runs the tasks in the calling thread in reverse order
+static void reverseExecutor(void (*task)(void *, int), void *taskArg, int nTask, void *arg) {
+  for(int t=nTask-1;t>=0;t--) (*task)(taskArg, t);
+}
+
+// complex forward, with the thread pool and with a caller-provided
+// executor
+int check_executor(int n) {
+  int i, success = 1;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  for(int backend=0;backend<2;backend++) {
+    if (backend == 0) {
+      if (SleefDFT_setThreadPool(3) < 0) continue;
+    } else {
+      SleefDFT_setExecutor(reverseExecutor, NULL, 3);
+    }
+
+    struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_DEBUG);
+
+    if (p == NULL) {
+      printf("SleefDFT initialization failed\n");
+      return 0;
+    }
+
+    SleefDFT_execute(p, sx, sy);
+    SleefDFT_dispose(p);
+
+    for(i=0;i<n;i++) {
+      if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	  (fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES)) {
+	success = 0;
+      }
+    }
+  }
+
+  SleefDFT_setExecutor(NULL, NULL, 0);
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+
+  return success;
+}
+
+// complex forward, with the measured plan exported and imported again
+// into an empty plan map. The measurement is not time-limited, so that it
+// always completes and is exported. The plan map starts and ends in
+// the state main sets up, so that neither earlier measurements nor the
+// imported plan affect the result or the later tests.
+int check_plans(int n) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+  SleefDFT_setPlanTimeLimit(0);
+
+  int success = 0;
+  char *buf0 = NULL, *buf1 = NULL;
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_MEASURE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+  } else {
+    SleefDFT_dispose(p);
+
+    SleefDFT_exportPlans(&buf0);
+    SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+
+    success = SleefDFT_importPlans(buf0) > 0;
+
+    SleefDFT_exportPlans(&buf1);
+    success = success && strcmp(buf0, buf1) == 0;
+
+    p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_MEASURE);
+
+    if (p == NULL) {
+      printf("SleefDFT initialization failed\n");
+      success = 0;
+    } else {
+      SleefDFT_execute(p, sx, sy);
+      SleefDFT_dispose(p);
+
+      for(i=0;i<n;i++) {
+	if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	    (fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES)) {
+	  success = 0;
+	}
+      }
+    }
+  }
+
+  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+
+  free(buf0);
+  free(buf1);
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+
+  return success;
+}
+
+int check_binplans(int n) {
+  int i;
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n);
+
+  for(i=0;i<n;i++) {
+    ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+    sx[(i*2+0)] = creal(ts[i]);
+    sx[(i*2+1)] = cimag(ts[i]);
+  }
+
+  forward(ts, fs, n);
+
+  char fn[64];
+  sprintf(fn, "naivetest%d_%d.plan", BASETYPEID, n);
+
+  SleefDFT_setPlanTimeLimit(100);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_MEASURE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  int success = SleefDFT_saveBinaryPlanFile(fn) > 0;
+  SleefDFT_dispose(p);
+
+  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+  success = success && SleefDFT_loadBinaryPlanFile(fn) >= 0;
+  remove(fn);
+
+  p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_MEASURE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  SleefDFT_execute(p, sx, sy);
+
+  SleefDFT_setPlanTimeLimit(0);
+
+  for(i=0;i<n;i++) {
+    if ((fabs(sy[(i*2+0)] - creal(fs[i])) > THRES) ||
+	(fabs(sy[(i*2+1)] - cimag(fs[i])) > THRES)) {
+      success = 0;
+    }
+  }
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  return success;
+}
+
+// A binary plan file whose permutation tables have been altered must
+// be refused. The header is found by its magic number, and the index
+// of the tables follows it.
+int check_binplans_corrupt(int n) {
+  char fn[64];
+  sprintf(fn, "naivetest%d_%d_corrupt.plan", BASETYPEID, n);
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_ESTIMATE);
+  if (p == NULL) return 0;
+  int success = SleefDFT_saveBinaryPlanFile(fn) > 0;
+  SleefDFT_dispose(p);
+
+  FILE *fp = fopen(fn, "r+b");
+  if (fp == NULL) return 0;
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  uint64_t *buf = (uint64_t *)calloc(size / 8 + 1, 8);
+  fseek(fp, 0, SEEK_SET);
+  success = success && fread(buf, 1, size, fp) == (size_t)size;
+
+  int altered = 0;
+  for(long i=0;success && !altered && i + 4 <= size / 8;i++) {
+    if (buf[i] != 0x5346445442303031ULL) continue;
+    uint64_t *index = &buf[i+4];
+    for(uint64_t t=0;t<buf[i+1] && (char *)&index[t*3+3] <= (char *)buf + size;t++) {
+      if ((index[t*3+0] & 1) == 0 || index[t*3+1] + 4 > (uint64_t)size) continue;
+      uint32_t v = 0xfffffff0;
+      fseek(fp, (long)index[t*3+1], SEEK_SET);
+      altered = fwrite(&v, sizeof(v), 1, fp) == 1;
+      break;
+    }
+  }
+  success = fclose(fp) == 0 && success;
+
+  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+  if (altered) success = success && SleefDFT_loadBinaryPlanFile(fn) < 0;
+  remove(fn);
+  free(buf);
+
+  return success;
+}
+
+// batched transform, interleaved input and contiguous output, scaled
+// unless scale is 1
+int check_batch(int n, int howmany, uint64_t mode, double scale) {
+  int i, b, c;
+
+  const int isReal = (mode & SLEEF_MODE_REAL) != 0, isBackward = (mode & SLEEF_MODE_BACKWARD) != 0;
+  const int ni = isReal && isBackward  ? n/2+1 : n, isz = isReal && !isBackward ? 1 : 2;
+  const int no = isReal && !isBackward ? n/2+1 : n, osz = isReal && isBackward  ? 1 : 2;
+
+  real *sx = (real *)Sleef_malloc(ni*isz*howmany * sizeof(real));
+  real *sy = (real *)Sleef_malloc(no*osz*howmany * sizeof(real));
+
+  cmpl *ts = (cmpl *)malloc(sizeof(cmpl)*n);
+  cmpl *fs = (cmpl *)malloc(sizeof(cmpl)*n*howmany);
+
+  //
+
+  for(b=0;b<howmany;b++) {
+    for(i=0;i<n;i++) {
+      ts[i] = 0.5 * ((2.0 * (rand() / (double)RAND_MAX) - 1) + (2.0 * (rand() / (double)RAND_MAX) - 1) * _Complex_I);
+      if (isReal && !isBackward) ts[i] = creal(ts[i]);
+    }
+
+    if (isReal && isBackward) {
+      ts[0] = creal(ts[0]);
+      ts[n/2] = creal(ts[n/2]);
+      for(i=1;i<n/2;i++) ts[n-i] = conj(ts[i]);
+    }
+
+    for(i=0;i<ni;i++) {
+      for(c=0;c<isz;c++) sx[(i*howmany+b)*isz+c] = c == 0 ? creal(ts[i]) : cimag(ts[i]);
+    }
+
+    if (isBackward) {
+      backward(ts, fs + b*n, n);
+    } else {
+      forward(ts, fs + b*n, n);
+    }
+  }
+
+  //
+
+  struct SleefDFT *p = SleefDFT_initBatch(n, howmany, howmany, 1, 1, no, NULL, NULL, mode | MODE | SLEEF_MODE_VERBOSE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    free(fs);
+    free(ts);
+    Sleef_free(sx);
+    Sleef_free(sy);
+    return 0;
+  }
+
+  int success = scale == 1 || SleefDFT_setScale(p, scale) == 0;
+
+  SleefDFT_execute(p, sx, sy);
+
+  //
+
+  for(b=0;b<howmany;b++) {
+    for(i=0;i<no;i++) {
+      if (fabs(sy[(b*no+i)*osz] - creal(fs[b*n+i]) * scale) > THRES) success = 0;
+      if (osz == 2 && fabs(sy[(b*no+i)*osz+1] - cimag(fs[b*n+i]) * scale) > THRES) success = 0;
+      if (osz == 1 && fabs(cimag(fs[b*n+i])) > THRES) success = 0;
+    }
+  }
+
+  //
+
+  free(fs);
+  free(ts);
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  SleefDFT_dispose(p);
+
+  //
+
+  return success;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2 && argc != 3) {
+    fprintf(stderr, "%s <log2n> [<odd factor>]\n", argv[0]);
+    exit(-1);
+  }
+
+  const int n = (argc == 3 ? atoi(argv[2]) : 1) << atoi(argv[1]);
+
+  srand((unsigned int)time(NULL));
+
+  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+
+  //
+
+  int success = 1;
+  
+  printf("complex  forward   : %s\n", (success &= check_cf(n))  ? "OK" : "NG");
+  printf("complex  backward  : %s\n", (success &= check_cb(n))  ? "OK" : "NG");
+  printf("batched  forward   : %s\n", (success &= check_batch(n, n <= 64 ? 37 : 3, 0, 1)) ? "OK" : "NG");
+  printf("batched  backward  : %s\n", (success &= check_batch(n, n <= 64 ? 37 : 3, SLEEF_MODE_BACKWARD, 0.5)) ? "OK" : "NG");
+  printf("workspace forward  : %s\n", (success &= check_ws(n)) ? "OK" : "NG");
+  printf("split    forward   : %s\n", (success &= check_split(n)) ? "OK" : "NG");
+  printf("fp16     forward   : %s\n", (success &= check_half(n, SLEEF_MODE_FP16_IN | SLEEF_MODE_FP16_OUT)) ? "OK" : "NG");
+  printf("bf16     backward  : %s\n", (success &= check_half(n, SLEEF_MODE_BF16_IN | SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+  printf("bf16     output    : %s\n", (success &= check_half(n, SLEEF_MODE_BF16_OUT)) ? "OK" : "NG");
+  printf("int16    forward   : %s\n", (success &= check_fixed(n, SLEEF_MODE_INT16_IN | SLEEF_MODE_INT16_OUT)) ? "OK" : "NG");
+  printf("int32    backward  : %s\n", (success &= check_fixed(n, SLEEF_MODE_INT32_IN | SLEEF_MODE_INT32_OUT | SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+  printf("int16    input     : %s\n", (success &= check_fixed(n, SLEEF_MODE_INT16_IN)) ? "OK" : "NG");
+  printf("async    forward   : %s\n", (success &= check_async(n)) ? "OK" : "NG");
+#ifdef ENABLE_PTHREAD
+  printf("async    concurrent: %s\n", (success &= check_async_concurrent(n)) ? "OK" : "NG");
+#endif
+  printf("executor forward   : %s\n", (success &= check_executor(n)) ? "OK" : "NG");
+  printf("convolution        : %s\n", (success &= check_conv(n, 0)) ? "OK" : "NG");
+  printf("real convolution   : %s\n", (success &= check_conv(n, SLEEF_MODE_REAL)) ? "OK" : "NG");
+  printf("correlation        : %s\n", (success &= check_conv(n, SLEEF_MODE_CORRELATE)) ? "OK" : "NG");
+  printf("Goertzel forward   : %s\n", (success &= check_goertzel(n, 0)) ? "OK" : "NG");
+  printf("Goertzel backward  : %s\n", (success &= check_goertzel(n, SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+  printf("Goertzel real      : %s\n", (success &= check_goertzel(n, SLEEF_MODE_REAL)) ? "OK" : "NG");
+  printf("chirp-z  zoom      : %s\n", (success &= check_chirpz(n, n/2+3, 0.1234, 0.37 / n, 0)) ? "OK" : "NG");
+  printf("chirp-z  backward  : %s\n", (success &= check_chirpz(n, 2*n+1, -0.75, 1.0 / (2*n), SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+
+  if ((n & (n - 1)) == 0) {
+    printf("real     forward   : %s\n", (success &= check_rf(n))  ? "OK" : "NG");
+    printf("real     backward  : %s\n", (success &= check_rb(n))  ? "OK" : "NG");
+    printf("real alt forward   : %s\n", (success &= check_arf(n)) ? "OK" : "NG");
+    printf("real alt backward  : %s\n", (success &= check_arb(n)) ? "OK" : "NG");
+    printf("batched  real fwd  : %s\n", (success &= check_batch(n, 5, SLEEF_MODE_REAL, 1)) ? "OK" : "NG");
+    printf("batched  real bwd  : %s\n", (success &= check_batch(n, 5, SLEEF_MODE_REAL | SLEEF_MODE_BACKWARD, 0.5)) ? "OK" : "NG");
+    printf("scaled   forward   : %s\n", (success &= check_scalewin(n, 0)) ? "OK" : "NG");
+    printf("scaled   real      : %s\n", (success &= check_scalewin(n, SLEEF_MODE_REAL)) ? "OK" : "NG");
+    printf("low mem  forward   : %s\n", (success &= check_scalewin(n, SLEEF_MODE_LOW_MEMORY)) ? "OK" : "NG");
+    printf("low mem  real      : %s\n", (success &= check_scalewin(n, SLEEF_MODE_REAL | SLEEF_MODE_LOW_MEMORY)) ? "OK" : "NG");
+    printf("STFT               : %s\n", (success &= check_stft(n)) ? "OK" : "NG");
+    printf("six-step forward   : %s\n", (success &= check_large(n, 0)) ? "OK" : "NG");
+    printf("six-step backward  : %s\n", (success &= check_large(n, SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+    printf("pruned   input     : %s\n", (success &= check_pruned(n, (n+7)/8, 0, n, 0)) ? "OK" : "NG");
+
+    if (n >= 4) {
+      printf("pruned   output    : %s\n", (success &= check_pruned(n, n, n/3, n/8+1, 0)) ? "OK" : "NG");
+      printf("pruned   zero-pad  : %s\n", (success &= check_pruned(n, (n+7)/8, n/5, n/4, 0)) ? "OK" : "NG");
+      printf("pruned   backward  : %s\n", (success &= check_pruned(n, (n+3)/4, n-1, n/4+1, SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+    }
+
+    if (n >= 4) {
+      printf("imported plan      : %s\n", (success &= check_plans(n)) ? "OK" : "NG");
+      printf("binary plan file   : %s\n", (success &= check_binplans(n)) ? "OK" : "NG");
+      printf("corrupt plan file  : %s\n", (success &= check_binplans_corrupt(n)) ? "OK" : "NG");
+    }
+
+    if (n >= 2) {
+      printf("DCT-II             : %s\n", (success &= check_r2r(n, SLEEF_MODE_DCT | SLEEF_MODE_FORWARD )) ? "OK" : "NG");
+      printf("DCT-III            : %s\n", (success &= check_r2r(n, SLEEF_MODE_DCT | SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+      printf("DST-II             : %s\n", (success &= check_r2r(n, SLEEF_MODE_DST | SLEEF_MODE_FORWARD )) ? "OK" : "NG");
+      printf("DST-III            : %s\n", (success &= check_r2r(n, SLEEF_MODE_DST | SLEEF_MODE_BACKWARD)) ? "OK" : "NG");
+    }
+  }
   
   exit(!success);
 }
@@ -0,0 +1,208 @@
+//   Copyright Naoki Shibata and contributors 2010 - 2021.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// Checks that executing a real-time plan does not allocate. The
+// allocators of the process are replaced in this executable only, and
+// forward to the next definition found by the dynamic linker, so that
+// any allocator the process uses is counted.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#include <math.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "sleef.h"
+#include "sleefdft.h"
+
+#if BASETYPEID == 1
+#define THRES 1e-30
+#define SleefDFT_init SleefDFT_double_init1d
+#define SleefDFT_execute SleefDFT_double_execute
+typedef double real;
+#elif BASETYPEID == 2
+#define THRES 1e-13
+#define SleefDFT_init SleefDFT_float_init1d
+#define SleefDFT_execute SleefDFT_float_execute
+typedef float real;
+#else
+#error BASETYPEID not set
+#endif
+
+static void *(*nextMalloc)(size_t), *(*nextCalloc)(size_t, size_t), *(*nextRealloc)(void *, size_t);
+static int (*nextPosixMemalign)(void **, size_t, size_t);
+static void (*nextFree)(void *);
+
+static int allocCount = 0, resolved = 0;
+
+// dlsym may allocate before the next allocators are known. These
+// allocations are served from a static buffer and are never freed.
+static char bootBuf[1 << 14] __attribute__((aligned(64)));
+static size_t bootUsed = 0;
+
+static void *bootAlloc(size_t z) {
+  z = (z + 63) & ~(size_t)63;
+  if (z > sizeof(bootBuf) - bootUsed) return NULL;
+  void *ptr = bootBuf + bootUsed;
+  bootUsed += z;
+  return ptr;
+}
+
+static int isBoot(void *ptr) { return (char *)ptr >= bootBuf && (char *)ptr < bootBuf + sizeof(bootBuf); }
+
+static void resolve() {
+  static int resolving = 0;
+  if (resolved || resolving) return;
+  resolving = 1;
+  nextMalloc = (void *(*)(size_t))dlsym(RTLD_NEXT, "malloc");
+  nextCalloc = (void *(*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+  nextRealloc = (void *(*)(void *, size_t))dlsym(RTLD_NEXT, "realloc");
+  nextPosixMemalign = (int (*)(void **, size_t, size_t))dlsym(RTLD_NEXT, "posix_memalign");
+  nextFree = (void (*)(void *))dlsym(RTLD_NEXT, "free");
+  resolved = nextMalloc != NULL && nextCalloc != NULL && nextRealloc != NULL &&
+    nextPosixMemalign != NULL && nextFree != NULL;
+  resolving = 0;
+}
+
+void *malloc(size_t z) {
+  __atomic_add_fetch(&allocCount, 1, __ATOMIC_RELAXED);
+  resolve();
+  return resolved ? nextMalloc(z) : bootAlloc(z);
+}
+
+void *calloc(size_t n, size_t z) {
+  __atomic_add_fetch(&allocCount, 1, __ATOMIC_RELAXED);
+  resolve();
+  return resolved ? nextCalloc(n, z) : z == 0 || n <= SIZE_MAX / z ? bootAlloc(n * z) : NULL;
+}
+
+void *realloc(void *ptr, size_t z) {
+  __atomic_add_fetch(&allocCount, 1, __ATOMIC_RELAXED);
+  resolve();
+  if (!isBoot(ptr)) return resolved ? nextRealloc(ptr, z) : bootAlloc(z);
+  void *q = resolved ? nextMalloc(z) : bootAlloc(z);
+  const size_t avail = (size_t)(bootBuf + bootUsed - (char *)ptr);
+  if (q != NULL) memcpy(q, ptr, z < avail ? z : avail);
+  return q;
+}
+
+int posix_memalign(void **ptr, size_t align, size_t z) {
+  __atomic_add_fetch(&allocCount, 1, __ATOMIC_RELAXED);
+  resolve();
+  if (resolved) return nextPosixMemalign(ptr, align, z);
+  *ptr = NULL;
+  return ENOMEM;
+}
+
+void free(void *ptr) {
+  if (ptr == NULL || isBoot(ptr)) return;
+  resolve();
+  if (resolved) nextFree(ptr);
+}
+
+static double squ(double x) { return x * x; }
+
+// complex forward with a real-time plan, compared with an ordinary
+// plan. Its memory has to be locked unless RLIMIT_MEMLOCK is below 8
+// MiB, and executing it must not allocate.
+int check_realtime(int n) {
+  struct SleefDFT *q = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_REALTIME | SLEEF_MODE_NO_SCRATCH);
+  if (q != NULL) {
+    printf("A real-time plan without scratch space was accepted\n");
+    SleefDFT_dispose(q);
+    return 0;
+  }
+
+  struct SleefDFT *p = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_REALTIME | SLEEF_MODE_ASYNC | SLEEF_MODE_DEBUG);
+  q = SleefDFT_init(n, NULL, NULL, SLEEF_MODE_DEBUG);
+
+  if (p == NULL || q == NULL) {
+    printf("SleefDFT initialization failed\n");
+    return 0;
+  }
+
+  real *sx = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(n*2 * sizeof(real));
+
+  for(int i=0;i<n*2;i++) sx[i] = (real)(2.0 * (rand() / (double)RAND_MAX) - 1);
+
+  int success = 1, lockRequired = 0;
+
+#ifdef __linux__
+  struct rlimit rl;
+  lockRequired = getrlimit(RLIMIT_MEMLOCK, &rl) == 0 && (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur >= (1 << 23));
+#endif
+
+  if (SleefDFT_lockMemory(p) != 0 && lockRequired) {
+    printf("Locking the memory of the plan failed\n");
+    success = 0;
+  }
+
+  const int count = __atomic_load_n(&allocCount, __ATOMIC_RELAXED);
+  SleefDFT_execute(p, sx, sy);
+  const int nAlloc = __atomic_load_n(&allocCount, __ATOMIC_RELAXED) - count;
+
+  if (nAlloc != 0) {
+    printf("Executing the plan allocated %d times\n", nAlloc);
+    success = 0;
+  }
+
+  SleefDFT_execute(q, sx, sz);
+
+  double rmsn = 0, rmsd = 0;
+  for(int i=0;i<n*2;i++) {
+    rmsn += squ(sy[i] - sz[i]);
+    rmsd += squ(sz[i]);
+  }
+
+  if (rmsn / rmsd > THRES) success = 0;
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+  SleefDFT_dispose(p);
+  SleefDFT_dispose(q);
+
+  return success;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "%s <log2n>\n", argv[0]);
+    exit(-1);
+  }
+
+  const int n = 1 << atoi(argv[1]);
+
+  srand((unsigned int)time(NULL));
+
+  SleefDFT_setPlanFilePath(NULL, NULL, SLEEF_PLAN_RESET | SLEEF_PLAN_READONLY);
+
+  // Allocations made by the allocators that this executable replaces
+  // are counted only if the replacement took effect
+  const int count = __atomic_load_n(&allocCount, __ATOMIC_RELAXED);
+  void *volatile probe = malloc(1);
+  free(probe);
+  if (__atomic_load_n(&allocCount, __ATOMIC_RELAXED) == count) {
+    printf("Allocations cannot be counted\n");
+    exit(-1);
+  }
+
+  int success = check_realtime(n);
+  printf("real-time forward  : %s\n", success ? "OK" : "NG");
+
+  exit(success ? 0 : -1);
+}
@@ -19,15 +19,24 @@
 #define MODE (SLEEF_MODE_DEBUG | SLEEF_MODE_VERBOSE)
 #endif
 
+// A binary16 value has an 11-bit significand
+#define HALF_THRES 1e-6
+
 #if BASETYPEID == 1
 #define THRES 1e-30
 #define SleefDFT_init2d SleefDFT_double_init2d
+#define SleefDFT_init3d SleefDFT_double_init3d
 #define SleefDFT_execute SleefDFT_double_execute
+#define SleefDFT_execute_split SleefDFT_double_execute_split
+#define SleefDFT_execute_half SleefDFT_double_execute_half
 typedef double real;
 #elif BASETYPEID == 2
 #define THRES 1e-13
 #define SleefDFT_init2d SleefDFT_float_init2d
+#define SleefDFT_init3d SleefDFT_float_init3d
 #define SleefDFT_execute SleefDFT_float_execute
+#define SleefDFT_execute_split SleefDFT_float_execute_split
+#define SleefDFT_execute_half SleefDFT_float_execute_half
 typedef float real;
 #else
 #error BASETYPEID not set
@@ -89,6 +98,311 @@ double check_c(int n, int m) {
   return rmsn / rmsd;
 }
 
+// real transforms, compared with the complex transform of the same
+// input, and then transformed back
+double check_r(int n, int m) {
+  struct SleefDFT *p;
+  const int mc = m/2+1;
+
+  real *sx = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+
+  for(int i=0;i<n*m;i++) {
+    sx[i] = (real)(2.0 * (rand() / (double)RAND_MAX) - 1);
+    sz[i*2+0] = sx[i];
+    sz[i*2+1] = 0;
+  }
+
+  //
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sz, sz);
+  SleefDFT_dispose(p);
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, SLEEF_MODE_REAL | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sx, sy);
+  SleefDFT_dispose(p);
+
+  double rmsn = 0, rmsd = 0;
+
+  for(int y=0;y<n;y++) {
+    for(int x=0;x<mc;x++) {
+      rmsn += squ(sy[(y*mc+x)*2+0] - sz[(y*m+x)*2+0]) + squ(sy[(y*mc+x)*2+1] - sz[(y*m+x)*2+1]);
+      rmsd += squ(sz[(y*m+x)*2+0]) + squ(sz[(y*m+x)*2+1]);
+    }
+  }
+
+  //
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, SLEEF_MODE_REAL | SLEEF_MODE_BACKWARD | MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sy, sz);
+  SleefDFT_dispose(p);
+
+  double scale = 1 / (n*(double)m);
+
+  for(int i=0;i<n*m;i++) {
+    rmsn += squ(scale * sz[i] - sx[i]);
+    rmsd += squ(sx[i]);
+  }
+
+  //
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+
+  //
+
+  return rmsn / rmsd;
+}
+
+// complex transforms with split planes, compared with the interleaved
+// transform, and then transformed back
+double check_split(int n, int m) {
+  struct SleefDFT *p;
+
+  real *sx = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  real *sr = (real *)Sleef_malloc(n*m * sizeof(real));
+  real *si = (real *)Sleef_malloc(n*m * sizeof(real));
+  real *dr = (real *)Sleef_malloc(n*m * sizeof(real));
+  real *di = (real *)Sleef_malloc(n*m * sizeof(real));
+
+  for(int i=0;i<n*m;i++) {
+    sr[i] = sx[i*2+0] = (real)(2.0 * (rand() / (double)RAND_MAX) - 1);
+    si[i] = sx[i*2+1] = (real)(2.0 * (rand() / (double)RAND_MAX) - 1);
+  }
+
+  //
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sx, sy);
+  SleefDFT_dispose(p);
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE | SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute_split(p, sr, si, dr, di);
+  SleefDFT_dispose(p);
+
+  double rmsn = 0, rmsd = 0;
+
+  for(int i=0;i<n*m;i++) {
+    rmsn += squ(dr[i] - sy[i*2+0]) + squ(di[i] - sy[i*2+1]);
+    rmsd += squ(sy[i*2+0]) + squ(sy[i*2+1]);
+  }
+
+  //
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE | SLEEF_MODE_BACKWARD | SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute_split(p, dr, di, dr, di);
+  SleefDFT_dispose(p);
+
+  double scale = 1 / (n*(double)m);
+
+  for(int i=0;i<n*m;i++) {
+    rmsn += squ(scale * dr[i] - sr[i]) + squ(scale * di[i] - si[i]);
+    rmsd += squ(sr[i]) + squ(si[i]);
+  }
+
+  //
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sr);
+  Sleef_free(si);
+  Sleef_free(dr);
+  Sleef_free(di);
+
+  //
+
+  return rmsn / rmsd;
+}
+
+static double fromFp16(uint16_t h) {
+  int e = (h >> 10) & 0x1f;
+  double x = e == 0 ? ldexp(h & 0x3ff, -24) : ldexp((h & 0x3ff) | 0x400, e - 25);
+  return (h & 0x8000) ? -x : x;
+}
+
+// complex transforms with a binary16 output, compared with the
+// transform in real, and then transformed back from binary16
+double check_half(int n, int m) {
+  struct SleefDFT *p;
+
+  real *sx = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(n*m*2 * sizeof(real));
+  uint16_t *hy = (uint16_t *)Sleef_malloc(n*m*2 * sizeof(uint16_t));
+
+  for(int i=0;i<n*m*2;i++) sx[i] = (real)(2.0 * (rand() / (double)RAND_MAX) - 1);
+
+  //
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sx, sy);
+  SleefDFT_dispose(p);
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE | SLEEF_MODE_FP16_OUT);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute_half(p, sx, hy);
+  SleefDFT_dispose(p);
+
+  double rmsn = 0, rmsd = 0;
+
+  for(int i=0;i<n*m*2;i++) {
+    rmsn += squ(fromFp16(hy[i]) - sy[i]);
+    rmsd += squ(sy[i]);
+  }
+
+  //
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE | SLEEF_MODE_BACKWARD | SLEEF_MODE_FP16_IN);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute_half(p, hy, sz);
+  SleefDFT_dispose(p);
+
+  double scale = 1 / (n*(double)m);
+
+  for(int i=0;i<n*m*2;i++) {
+    rmsn += squ(scale * sz[i] - sx[i]);
+    rmsd += squ(sx[i]);
+  }
+
+  //
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+  Sleef_free(hy);
+
+  //
+
+  return rmsn / rmsd;
+}
+
+// 3D complex transforms of size 2 x n x m, compared with a length-2
+// butterfly over two 2D transforms, and then transformed back
+double check_3d(int n, int m) {
+  struct SleefDFT *p;
+
+  real *sx = (real *)Sleef_malloc(2*n*m*2 * sizeof(real));
+  real *sy = (real *)Sleef_malloc(2*n*m*2 * sizeof(real));
+  real *sz = (real *)Sleef_malloc(2*n*m*2 * sizeof(real));
+
+  for(int i=0;i<2*n*m*2;i++) sx[i] = (real)(2.0 * (rand() / (double)RAND_MAX) - 1);
+
+  //
+
+  p = SleefDFT_init3d(2, n, m, NULL, NULL, MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sx, sy);
+  SleefDFT_dispose(p);
+
+  p = SleefDFT_init2d(n, m, NULL, NULL, MODE);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, &sx[0], &sz[0]);
+  SleefDFT_execute(p, &sx[n*m*2], &sz[n*m*2]);
+  SleefDFT_dispose(p);
+
+  double rmsn = 0, rmsd = 0;
+
+  for(int i=0;i<n*m*2;i++) {
+    rmsn += squ(sy[i] - (sz[i] + sz[n*m*2+i])) + squ(sy[n*m*2+i] - (sz[i] - sz[n*m*2+i]));
+    rmsd += squ(sy[i]) + squ(sy[n*m*2+i]);
+  }
+
+  //
+
+  p = SleefDFT_init3d(2, n, m, NULL, NULL, MODE | SLEEF_MODE_BACKWARD);
+
+  if (p == NULL) {
+    printf("SleefDFT initialization failed\n");
+    exit(-1);
+  }
+
+  SleefDFT_execute(p, sy, sz);
+  SleefDFT_dispose(p);
+
+  double scale = 1 / (2*n*(double)m);
+
+  for(int i=0;i<2*n*m*2;i++) {
+    rmsn += squ(scale * sz[i] - sx[i]);
+    rmsd += squ(sx[i]);
+  }
+
+  //
+
+  Sleef_free(sx);
+  Sleef_free(sy);
+  Sleef_free(sz);
+
+  //
+
+  return rmsn / rmsd;
+}
+
 int main(int argc, char **argv) {
   if (argc < 3) {
     fprintf(stderr, "%s <log2n> <log2m> [<nloop>]\n", argv[0]);
@@ -112,6 +426,22 @@ int main(int argc, char **argv) {
     e = check_c(n, m);
     success = success && e < THRES;
     printf("complex : %s (%g)\n", e < THRES ? "OK" : "NG", e);
+
+    e = check_r(n, m);
+    success = success && e < THRES;
+    printf("real    : %s (%g)\n", e < THRES ? "OK" : "NG", e);
+
+    e = check_split(n, m);
+    success = success && e < THRES;
+    printf("split   : %s (%g)\n", e < THRES ? "OK" : "NG", e);
+
+    e = check_half(n, m);
+    success = success && e < HALF_THRES;
+    printf("fp16    : %s (%g)\n", e < HALF_THRES ? "OK" : "NG", e);
+
+    e = check_3d(n, m);
+    success = success && e < THRES;
+    printf("3D      : %s (%g)\n", e < THRES ? "OK" : "NG", e);
   }
 
   exit(!success);
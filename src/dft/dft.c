@@ -15,14 +15,15 @@
 
 #include "sleef.h"
 
+#ifdef ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include "misc.h"
 #include "common.h"
 #include "arraymap.h"
 #include "dftcommon.h"
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include "dftformat.h"
 
 #if BASETYPEID == 1
 typedef double real;
@@ -30,21 +31,67 @@ typedef Sleef_double2 sc_t;
 #define BASETYPESTRING "double"
 #define MAGIC 0x27182818
 #define MAGIC2D 0x17320508
+#define MAGICMR 0x14142135
+#define MAGICBS 0x22912878
+#define MAGICBT 0x23606797
+#define MAGICND 0x33166247
+#define MAGICR2D 0x41231056
+#define MAGICRR 0x47958315
+#define MAGICSP 0x55677643
+#define MAGICCV 0x57735026
+#define MAGICST 0x62996052
+#define MAGICLG 0x72710986
+#define MAGICPR 0x69314718
+#define MAGICGZ 0x30102999
+#define MAGICCZ 0x14422495
+#define MAGICFM 0x12599210
 #define INIT SleefDFT_double_init1d
 #define EXECUTE SleefDFT_double_execute
+#define EXECUTEWS SleefDFT_double_execute_ws
+#define EXECUTESPLIT SleefDFT_double_execute_split
+#define EXECUTEHALF SleefDFT_double_execute_half
+#define EXECUTEFIXED SleefDFT_double_execute_fixed
+#define EXECUTESTFT SleefDFT_double_execute_stft
+#define EXECUTESLIDE SleefDFT_double_execute_slide
+#define SETSCALE SleefDFT_double_setScale
+#define SETWINDOW SleefDFT_double_setWindow
+#define WSSIZE SleefDFT_double_getWorkspaceSize
+#define BINDPATH bindPathTables_double
 #define INIT2D SleefDFT_double_init2d
+#define INITBATCH SleefDFT_double_init1dBatch
+#define INIT3D SleefDFT_double_init3d
+#define INITND SleefDFT_double_initnd
+#define INITCONV SleefDFT_double_init1dConv
+#define INITSTFT SleefDFT_double_init1dSTFT
+#define INITPRUNED SleefDFT_double_init1dPruned
+#define INITGOERTZEL SleefDFT_double_init1dGoertzel
+#define INITCHIRPZ SleefDFT_double_init1dChirpZ
 #define CTBL ctbl_double
 #define REALSUB0 realSub0_double
 #define REALSUB1 realSub1_double
+#define GOERTZEL goertzel_double
+#define SLIDE slide_double
+#define TWIDDLEROW twiddleRow_double
 #define GETINT getInt_double
 #define GETPTR getPtr_double
 #define DFTF dftf_double
 #define DFTB dftb_double
 #define TBUTF tbutf_double
 #define TBUTB tbutb_double
+#define SBUTF sbutf_double
+#define SBUTB sbutb_double
+#define STBUTF stbutf_double
+#define STBUTB stbutb_double
+#define IOTBUTF iotbutf_double
+#define IOTBUTB iotbutb_double
+#define IODFTF iodftf_double
+#define IODFTB iodftb_double
 #define BUTF butf_double
 #define BUTB butb_double
+#define MRBUTF mrbutf_double
+#define MRBUTB mrbutb_double
 #define SINCOSPI Sleef_sincospi_u05
+#define GOERTZEL_ANCHOR 2048
 #include "dispatchdp.h"
 #elif BASETYPEID == 2
 typedef float real;
@@ -52,21 +99,67 @@ typedef Sleef_float2 sc_t;
 #define BASETYPESTRING "float"
 #define MAGIC 0x31415926
 #define MAGIC2D 0x22360679
+#define MAGICMR 0x16180339
+#define MAGICBS 0x26457513
+#define MAGICBT 0x24494897
+#define MAGICND 0x36055512
+#define MAGICR2D 0x43588989
+#define MAGICRR 0x53851648
+#define MAGICSP 0x60827625
+#define MAGICCV 0x64807406
+#define MAGICST 0x68556546
+#define MAGICLG 0x79336154
+#define MAGICPR 0x86602540
+#define MAGICGZ 0x47712125
+#define MAGICCZ 0x17099759
+#define MAGICFM 0x23025850
 #define INIT SleefDFT_float_init1d
 #define EXECUTE SleefDFT_float_execute
+#define EXECUTEWS SleefDFT_float_execute_ws
+#define EXECUTESPLIT SleefDFT_float_execute_split
+#define EXECUTEHALF SleefDFT_float_execute_half
+#define EXECUTEFIXED SleefDFT_float_execute_fixed
+#define EXECUTESTFT SleefDFT_float_execute_stft
+#define EXECUTESLIDE SleefDFT_float_execute_slide
+#define SETSCALE SleefDFT_float_setScale
+#define SETWINDOW SleefDFT_float_setWindow
+#define WSSIZE SleefDFT_float_getWorkspaceSize
+#define BINDPATH bindPathTables_float
 #define INIT2D SleefDFT_float_init2d
+#define INITBATCH SleefDFT_float_init1dBatch
+#define INIT3D SleefDFT_float_init3d
+#define INITND SleefDFT_float_initnd
+#define INITCONV SleefDFT_float_init1dConv
+#define INITSTFT SleefDFT_float_init1dSTFT
+#define INITPRUNED SleefDFT_float_init1dPruned
+#define INITGOERTZEL SleefDFT_float_init1dGoertzel
+#define INITCHIRPZ SleefDFT_float_init1dChirpZ
 #define CTBL ctbl_float
 #define REALSUB0 realSub0_float
 #define REALSUB1 realSub1_float
+#define GOERTZEL goertzel_float
+#define SLIDE slide_float
+#define TWIDDLEROW twiddleRow_float
 #define GETINT getInt_float
 #define GETPTR getPtr_float
 #define DFTF dftf_float
 #define DFTB dftb_float
 #define TBUTF tbutf_float
 #define TBUTB tbutb_float
+#define SBUTF sbutf_float
+#define SBUTB sbutb_float
+#define STBUTF stbutf_float
+#define STBUTB stbutb_float
+#define IOTBUTF iotbutf_float
+#define IOTBUTB iotbutb_float
+#define IODFTF iodftf_float
+#define IODFTB iodftb_float
 #define BUTF butf_float
 #define BUTB butb_float
+#define MRBUTF mrbutf_float
+#define MRBUTB mrbutb_float
 #define SINCOSPI Sleef_sincospif_u05
+#define GOERTZEL_ANCHOR 64
 #include "dispatchsp.h"
 #else
 #error No BASETYPEID specified
@@ -126,6 +219,7 @@ static const int constK[] = { 0, 2, 6, 14, 38, 94, 230, 542, 1254 };
 extern const char *configStr[];
 
 extern int planFilePathSet;
+extern uint64_t planTimeLimit;
 
 // Utility functions
 
@@ -154,37 +248,50 @@ static int checkISAAvailability(int isa) {
   return 0;
 }
 
-#ifdef _OPENMP
-static int omp_thread_count() {
-  int n = 0;
-#pragma omp parallel reduction(+:n)
-  n += 1;
-  return n;
-}
-#endif
+static void idleTask(void *arg, int t) {}
 
+// Wakes up the threads of the backend before timing
 static void startAllThreads(const int nth) {
-#ifdef _OPENMP
-  volatile int8_t *state = calloc(nth, 1);
-  int th=0;
-#pragma omp parallel for
-  for(th=0;th<nth;th++) {
-    state[th] = 1;
-    for(;;) {
-      int i;
-      for(i=0;i<nth;i++) if (state[i] == 0) break;
-      if (i == nth) break;
-    }
-  }
-  free((void *)state);
-#endif
+  Executor_run(idleTask, NULL, MIN(nth, Executor_threadCount()));
 }
 
+// The input of the first stage and the output of the last stage of a
+// plan that is executed by executeIO. s0 and s1, or d0 and d1, are
+// the planes of a split array, and s0 or d0 alone an array in another
+// format. A fixed-point output is written as reals into d0, and d1
+// takes the largest magnitudes, 2*vecwidth reals per task, see storeio
+// in vectortype.h.
+
+typedef struct KernelIO {
+  const void *s0, *s1;
+  void *d0, *d1;
+  int fmtIn, fmtOut;
+} KernelIO;
+
+static int isFixed(int fmt) { return fmt == FORMAT_INT16 || fmt == FORMAT_INT32; }
+
 // Dispatcher
 
-static void dispatch(SleefDFT *p, const int N, real *d, const real *s, const int level, const int config) {
+// If win is not NULL, the first stage multiplies its input by the
+// weights, see loadiow in vectortype.h. If scale is not NULL, the last
+// stage multiplies its output by *scale. A stage that is both the
+// first and the last takes no weights. If config has CONFIG_STOCKHAM,
+// a butterfly stage runs the Stockham kernel, which takes no
+// permutation table. If io is not NULL, the first stage reads the
+// input in io instead of s, and the last stage writes the output in io
+// instead of d.
+
+static void dispatchKernel(SleefDFT *p, const int N, real *d, const real *s, const int level, const int config0, const real *win, const int winReal, const real *scale, const KernelIO *io) {
   const int K = constK[N], log2len = p->log2len;
-  if (level == N) {
+  const int config = config0 & (CONFIGMAX-1), stockham = (config0 & CONFIG_STOCKHAM) != 0;
+  if (level == N && (io != NULL || scale != NULL)) {
+    const int first = io != NULL && level == log2len;
+    void (*func)(void *, void *, const int, const void *, const void *, const int, const int, const real) =
+      ((p->mode & SLEEF_MODE_BACKWARD) == 0 ? IODFTF : IODFTB)[config][p->isa][N];
+    (*func)(io != NULL ? io->d0 : d, io != NULL ? io->d1 : NULL, io != NULL ? io->fmtOut : FORMAT_REAL,
+	    first ? io->s0 : s, first ? io->s1 : NULL, first ? io->fmtIn : FORMAT_REAL,
+	    log2len-N, scale != NULL ? *scale : 1);
+  } else if (level == N) {
     if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
       void (*func)(real *, const real *, const int) = DFTF[config][p->isa][N];
       (*func)(d, s, log2len-N);
@@ -192,26 +299,72 @@ static void dispatch(SleefDFT *p, const int N, real *d, const real *s, const int
       void (*func)(real *, const real *, const int) = DFTB[config][p->isa][N];
       (*func)(d, s, log2len-N);
     }
+  } else if (level == log2len && (io != NULL || win != NULL)) {
+    assert(p->vecwidth <= (1 << N));
+    void (*func)(real *, uint32_t *, const void *, const void *, const int, const int, const real *, const int, const real *, const int) =
+      ((p->mode & SLEEF_MODE_BACKWARD) == 0 ? IOTBUTF : IOTBUTB)[config][p->isa][N];
+    (*func)(d, stockham ? NULL : p->perm[level], io != NULL ? io->s0 : s, io != NULL ? io->s1 : NULL, io != NULL ? io->fmtIn : FORMAT_REAL,
+	    log2len-N, p->tbl[N][level], K, win, winReal);
   } else if (level == log2len) {
     assert(p->vecwidth <= (1 << N));
     if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
-      void (*func)(real *, uint32_t *, const real *, const int, const real *, const int) = TBUTF[config][p->isa][N];
+      void (*func)(real *, uint32_t *, const real *, const int, const real *, const int) = stockham ? STBUTF[config][p->isa][N] : TBUTF[config][p->isa][N];
       (*func)(d, p->perm[level], s, log2len-N, p->tbl[N][level], K);
     } else {
-      void (*func)(real *, uint32_t *, const real *, const int, const real *, const int) = TBUTB[config][p->isa][N];
+      void (*func)(real *, uint32_t *, const real *, const int, const real *, const int) = stockham ? STBUTB[config][p->isa][N] : TBUTB[config][p->isa][N];
       (*func)(d, p->perm[level], s, log2len-N, p->tbl[N][level], K);
     }
   } else {
     if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
-      void (*func)(real *, uint32_t *, const int, const real *, const int, const real *, const int) = BUTF[config][p->isa][N];
+      void (*func)(real *, uint32_t *, const int, const real *, const int, const real *, const int) = stockham ? SBUTF[config][p->isa][N] : BUTF[config][p->isa][N];
       (*func)(d, p->perm[level], log2len-level, s, log2len-N, p->tbl[N][level], K);
     } else {
-      void (*func)(real *, uint32_t *, const int, const real *, const int, const real *, const int) = BUTB[config][p->isa][N];
+      void (*func)(real *, uint32_t *, const int, const real *, const int, const real *, const int) = stockham ? SBUTB[config][p->isa][N] : BUTB[config][p->isa][N];
       (*func)(d, p->perm[level], log2len-level, s, log2len-N, p->tbl[N][level], K);
     }
   }
 }
 
+// An MT kernel is run as one task per thread, each processing a chunk
+// of the butterflies
+
+typedef struct DispatchArg {
+  SleefDFT *p;
+  int N, level, config, nTask;
+  real *d;
+  const real *s, *win, *scale;
+  int winReal;
+  const KernelIO *io;
+} DispatchArg;
+
+static void dispatchTask(void *ptr, int t) {
+  DispatchArg *a = (DispatchArg *)ptr;
+  const KernelIO *io = a->io;
+  KernelIO taskIO;
+  if (io != NULL && isFixed(io->fmtOut)) {
+    taskIO = *io;
+    taskIO.d1 = (real *)io->d1 + (size_t)t * 2 * a->p->vecwidth;
+    io = &taskIO;
+  }
+  KernelChunk_set(t, a->nTask);
+  dispatchKernel(a->p, a->N, a->d, a->s, a->level, a->config, a->win, a->winReal, a->scale, io);
+  KernelChunk_set(0, 1);
+}
+
+static void dispatchFused(SleefDFT *p, const int N, real *d, const real *s, const int level, const int config, const real *win, const int winReal, const real *scale, const KernelIO *io) {
+  if ((config & CONFIG_MT) == 0) {
+    dispatchKernel(p, N, d, s, level, config, win, winReal, scale, io);
+    return;
+  }
+
+  DispatchArg a = { p, N, level, config, MIN(p->nThread, Executor_threadCount()), d, s, win, scale, winReal, io };
+  Executor_run(dispatchTask, &a, a.nTask);
+}
+
+static void dispatch(SleefDFT *p, const int N, real *d, const real *s, const int level, const int config) {
+  dispatchFused(p, N, d, s, level, config, NULL, 0, NULL, NULL);
+}
+
 // Transposer
 
 #if defined(__GNUC__) && __GNUC__ < 5
@@ -229,59 +382,50 @@ static void dispatch(SleefDFT *p, const int N, real *d, const real *s, const int
       *(element_t *)&row[x2].r[y2*2+0] = r;				\
     }} while(0)
 
-static void transpose(real *RESTRICT ALIGNED(256) d, real *RESTRICT ALIGNED(256) s, const int log2n, const int log2m) {
-  if (log2n < LOG2BS || log2m < LOG2BS) {
-    for(int y=0;y<(1 << log2n);y++) {
-      for(int x=0;x<(1 << log2m);x++) {
-	real r0 = s[((y << log2m)+x)*2+0];
-	real r1 = s[((y << log2m)+x)*2+1];
-	d[((x << log2n)+y)*2+0] = r0;
-	d[((x << log2n)+y)*2+1] = r1;
-      }
-    }
-  } else {
+// Transposes the rows y0 <= y < y1 of the blocked part, where y0 and
+// y1 are multiples of BS. s points to row y0.
+
+static void transposeRows(real *RESTRICT ALIGNED(256) d, const real *RESTRICT ALIGNED(256) s, const int log2n, const int log2m, const int y0, const int y1) {
 #if defined(__GNUC__) && !defined(__clang__)
-    typedef struct { real __attribute__((vector_size(sizeof(real)*BS*2))) r; } row_t;
-    typedef struct { real __attribute__((vector_size(sizeof(real)*2))) r; } element_t;
+  typedef struct { real __attribute__((vector_size(sizeof(real)*BS*2))) r; } row_t;
+  typedef struct { real __attribute__((vector_size(sizeof(real)*2))) r; } element_t;
 #else
-    typedef struct { real r[BS*2]; } row_t;
-    typedef struct { real r0, r1; } element_t;
+  typedef struct { real r[BS*2]; } row_t;
+  typedef struct { real r0, r1; } element_t;
 #endif
-    for(int y=0;y<(1 << log2n);y+=BS) {
-      for(int x=0;x<(1 << log2m);x+=BS) {
-	row_t row[BS];
-	for(int y2=0;y2<BS;y2++) {
-	  row[y2] = *(row_t *)&s[(((y+y2) << log2m)+x)*2];
-	}
+  for(int y=y0;y<y1;y+=BS) {
+    for(int x=0;x<(1 << log2m);x+=BS) {
+      row_t row[BS];
+      for(int y2=0;y2<BS;y2++) {
+	row[y2] = *(row_t *)&s[(((y-y0+y2) << log2m)+x)*2];
+      }
 
 #if LOG2BS == 4
-	TRANSPOSE_BLOCK( 0); TRANSPOSE_BLOCK( 1);
-	TRANSPOSE_BLOCK( 2); TRANSPOSE_BLOCK( 3);
-	TRANSPOSE_BLOCK( 4); TRANSPOSE_BLOCK( 5);
-	TRANSPOSE_BLOCK( 6); TRANSPOSE_BLOCK( 7);
-	TRANSPOSE_BLOCK( 8); TRANSPOSE_BLOCK( 9);
-	TRANSPOSE_BLOCK(10); TRANSPOSE_BLOCK(11);
-	TRANSPOSE_BLOCK(12); TRANSPOSE_BLOCK(13);
-	TRANSPOSE_BLOCK(14); TRANSPOSE_BLOCK(15);
+      TRANSPOSE_BLOCK( 0); TRANSPOSE_BLOCK( 1);
+      TRANSPOSE_BLOCK( 2); TRANSPOSE_BLOCK( 3);
+      TRANSPOSE_BLOCK( 4); TRANSPOSE_BLOCK( 5);
+      TRANSPOSE_BLOCK( 6); TRANSPOSE_BLOCK( 7);
+      TRANSPOSE_BLOCK( 8); TRANSPOSE_BLOCK( 9);
+      TRANSPOSE_BLOCK(10); TRANSPOSE_BLOCK(11);
+      TRANSPOSE_BLOCK(12); TRANSPOSE_BLOCK(13);
+      TRANSPOSE_BLOCK(14); TRANSPOSE_BLOCK(15);
 #else
-	for(int y2=0;y2<BS;y2++) {
-	  for(int x2=y2+1;x2<BS;x2++) {
-	    element_t r = *(element_t *)&row[y2].r[x2*2+0];
-	    *(element_t *)&row[y2].r[x2*2+0] = *(element_t *)&row[x2].r[y2*2+0];
-	    *(element_t *)&row[x2].r[y2*2+0] = r;
-	  }
+      for(int y2=0;y2<BS;y2++) {
+	for(int x2=y2+1;x2<BS;x2++) {
+	  element_t r = *(element_t *)&row[y2].r[x2*2+0];
+	  *(element_t *)&row[y2].r[x2*2+0] = *(element_t *)&row[x2].r[y2*2+0];
+	  *(element_t *)&row[x2].r[y2*2+0] = r;
 	}
+      }
 #endif
-	for(int y2=0;y2<BS;y2++) {
-	  *(row_t *)&d[(((x+y2) << log2n)+y)*2] = row[y2];
-	}
+      for(int y2=0;y2<BS;y2++) {
+	*(row_t *)&d[(((x+y2) << log2n)+y)*2] = row[y2];
       }
     }
   }
 }
 
-#ifdef _OPENMP
-static void transposeMT(real *RESTRICT ALIGNED(256) d, real *RESTRICT ALIGNED(256) s, int log2n, int log2m) {
+static void transpose(real *RESTRICT ALIGNED(256) d, real *RESTRICT ALIGNED(256) s, const int log2n, const int log2m) {
   if (log2n < LOG2BS || log2m < LOG2BS) {
     for(int y=0;y<(1 << log2n);y++) {
       for(int x=0;x<(1 << log2m);x++) {
@@ -292,48 +436,66 @@ static void transposeMT(real *RESTRICT ALIGNED(256) d, real *RESTRICT ALIGNED(25
       }
     }
   } else {
+    transposeRows(d, s, log2n, log2m, 0, 1 << log2n);
+  }
+}
+
+// Transposes a BS x BS block of s, whose rows are spitch elements
+// apart, into d, whose rows are dpitch elements apart. Neither needs
+// to be aligned.
+
+static void transposeBlock(real *RESTRICT d, size_t dpitch, const real *RESTRICT s, size_t spitch) {
 #if defined(__GNUC__) && !defined(__clang__)
-    typedef struct { real __attribute__((vector_size(sizeof(real)*BS*2))) r; } row_t;
-    typedef struct { real __attribute__((vector_size(sizeof(real)*2))) r; } element_t;
+  typedef struct { real __attribute__((vector_size(sizeof(real)*BS*2))) r; } row_t;
+  typedef struct { real __attribute__((vector_size(sizeof(real)*2))) r; } element_t;
 #else
-    typedef struct { real r[BS*2]; } row_t;
-    typedef struct { real r0, r1; } element_t;
+  typedef struct { real r[BS*2]; } row_t;
+  typedef struct { real r0, r1; } element_t;
 #endif
-    int y=0;
-#pragma omp parallel for
-    for(y=0;y<(1 << log2n);y+=BS) {
-      for(int x=0;x<(1 << log2m);x+=BS) {
-	row_t row[BS];
-	for(int y2=0;y2<BS;y2++) {
-	  row[y2] = *(row_t *)&s[(((y+y2) << log2m)+x)*2];
-	}
+  row_t row[BS];
+  for(int y2=0;y2<BS;y2++) memcpy(&row[y2], &s[y2*spitch*2], sizeof(row_t));
 
 #if LOG2BS == 4
-	TRANSPOSE_BLOCK( 0); TRANSPOSE_BLOCK( 1);
-	TRANSPOSE_BLOCK( 2); TRANSPOSE_BLOCK( 3);
-	TRANSPOSE_BLOCK( 4); TRANSPOSE_BLOCK( 5);
-	TRANSPOSE_BLOCK( 6); TRANSPOSE_BLOCK( 7);
-	TRANSPOSE_BLOCK( 8); TRANSPOSE_BLOCK( 9);
-	TRANSPOSE_BLOCK(10); TRANSPOSE_BLOCK(11);
-	TRANSPOSE_BLOCK(12); TRANSPOSE_BLOCK(13);
-	TRANSPOSE_BLOCK(14); TRANSPOSE_BLOCK(15);
+  TRANSPOSE_BLOCK( 0); TRANSPOSE_BLOCK( 1);
+  TRANSPOSE_BLOCK( 2); TRANSPOSE_BLOCK( 3);
+  TRANSPOSE_BLOCK( 4); TRANSPOSE_BLOCK( 5);
+  TRANSPOSE_BLOCK( 6); TRANSPOSE_BLOCK( 7);
+  TRANSPOSE_BLOCK( 8); TRANSPOSE_BLOCK( 9);
+  TRANSPOSE_BLOCK(10); TRANSPOSE_BLOCK(11);
+  TRANSPOSE_BLOCK(12); TRANSPOSE_BLOCK(13);
+  TRANSPOSE_BLOCK(14); TRANSPOSE_BLOCK(15);
 #else
-	for(int y2=0;y2<BS;y2++) {
-	  for(int x2=y2+1;x2<BS;x2++) {
-	    element_t r = *(element_t *)&row[y2].r[x2*2+0];
-	    *(element_t *)&row[y2].r[x2*2+0] = *(element_t *)&row[x2].r[y2*2+0];
-	    *(element_t *)&row[x2].r[y2*2+0] = r;
-	  }
-	}
-#endif
-	for(int y2=0;y2<BS;y2++) {
-	  *(row_t *)&d[(((x+y2) << log2n)+y)*2] = row[y2];
-	}
-      }
+  for(int y2=0;y2<BS;y2++) {
+    for(int x2=y2+1;x2<BS;x2++) {
+      element_t r = *(element_t *)&row[y2].r[x2*2+0];
+      *(element_t *)&row[y2].r[x2*2+0] = *(element_t *)&row[x2].r[y2*2+0];
+      *(element_t *)&row[x2].r[y2*2+0] = r;
     }
   }
+#endif
+
+  for(int y2=0;y2<BS;y2++) memcpy(&d[y2*dpitch*2], &row[y2], sizeof(row_t));
+}
+
+typedef struct TransposeArg {
+  real *d;
+  const real *s;
+  int log2n, log2m;
+} TransposeArg;
+
+static void transposeTask(void *ptr, int i) {
+  TransposeArg *a = (TransposeArg *)ptr;
+  transposeRows(a->d, &a->s[((size_t)i*BS << a->log2m)*2], a->log2n, a->log2m, i*BS, (i+1)*BS);
+}
+
+static void transposeMT(real *RESTRICT ALIGNED(256) d, real *RESTRICT ALIGNED(256) s, int log2n, int log2m, int nth) {
+  if (log2n < LOG2BS || log2m < LOG2BS) {
+    transpose(d, s, log2n, log2m);
+  } else {
+    TransposeArg a = { d, s, log2n, log2m };
+    Executor_parallelFor(transposeTask, &a, 1 << (log2n - LOG2BS), MIN(nth, Executor_threadCount()));
+  }
 }
-#endif // #ifdef _OPENMP
 
 // Table generator
 
@@ -375,63 +537,46 @@ static int makeTableRecurse(real *x, int *p, const int log2len, const int levelo
   return cnt;
 }
 
-static uint32_t perm(int nbits, uint32_t k, int s, int d) {
-  s = MIN(MAX(s, 0), nbits);
-  d = MIN(MAX(d, 0), nbits);
-  uint32_t r;
-  r = (((k & 0xaaaaaaaa) >> 1) | ((k & 0x55555555) << 1));
-  r = (((r & 0xcccccccc) >> 2) | ((r & 0x33333333) << 2));
-  r = (((r & 0xf0f0f0f0) >> 4) | ((r & 0x0f0f0f0f) << 4));
-  r = (((r & 0xff00ff00) >> 8) | ((r & 0x00ff00ff) << 8));
-  r = ((r >> 16) | (r << 16)) >> (32-nbits);
-
-  return (((r << s) | (k & ~(-1 << s))) & ~(-1 << d)) |
-    ((((k >> s) | (r & (-1 << (nbits-s)))) << d) & ~(-1 << nbits));
+static int tableAvailable(SleefDFT *p, const int N, const int level) {
+  if ((int)p->log2len < N || level < N || level > (int)p->log2len) return 0;
+  return !(level == (int)p->log2len && (1 << (p->log2len-N)) < p->vecwidth);
 }
 
-static real **makeTable(int sign, int vecwidth, int log2len, const int N, const int K) {
-  if (log2len < N) return NULL;
-
+static real *makeTable(int sign, int vecwidth, int log2len, const int N, const int K, const int level) {
   int *p = (int *)malloc(sizeof(int)*((N+1)<<N));
-  
-  real **tbl = (real **)calloc(sizeof(real *), (log2len+1));
 
-  for(int level=N;level<=log2len;level++) {
-    if (level == log2len && (1 << (log2len-N)) < vecwidth) { tbl[level] = NULL; continue; }
+  int tblOffset = 0;
+  real *tbl = (real *)Sleef_malloc(sizeof(real) * (K << (level-N)));
 
-    int tblOffset = 0;
-    tbl[level] = (real *)Sleef_malloc(sizeof(real) * (K << (level-N)));
-
-    for(int i0=0;i0 < (1 << (log2len-N));i0+=(1 << (log2len - level))) {
-      for(int j=0;j<N+1;j++) {
-	for(int i=0;i<(1 << N);i++) {
-	  p[(j << N) + i] = perm(log2len, i0 + (i << (log2len-N)), log2len-level, log2len-(level-j));
-	}
+  for(int i0=0;i0 < (1 << (log2len-N));i0+=(1 << (log2len - level))) {
+    for(int j=0;j<N+1;j++) {
+      for(int i=0;i<(1 << N);i++) {
+	p[(j << N) + i] = perm(log2len, i0 + (i << (log2len-N)), log2len-level, log2len-(level-j));
       }
+    }
 
-      int a = -sign*(p[((N-1) << N) + 0] & (-1 << (log2len - level)));
-      sc_t sc = r2coefsc(a, log2len, level-N+1);
-      tbl[level][tblOffset++] = sc.y; tbl[level][tblOffset++] = sc.x;
+    int a = -sign*(p[((N-1) << N) + 0] & (-1 << (log2len - level)));
+    sc_t sc = r2coefsc(a, log2len, level-N+1);
+    tbl[tblOffset++] = sc.y; tbl[tblOffset++] = sc.x;
       
-      tblOffset = makeTableRecurse(tbl[level], p, log2len, level, 0, sign, 0, 1 << N, N, tblOffset);
-    }
-
-    if (level == log2len) {
-      real *atbl = (real *)Sleef_malloc(sizeof(real)*(K << (log2len-N))*2);
-      tblOffset = 0;
-      while(tblOffset < (K << (log2len-N))) {
-	for(int k=0;k < K;k++) {
-	  for(int v = 0;v < vecwidth;v++) {
-	    assert((tblOffset + k * vecwidth + v)*2 + 1 < (K << (log2len-N))*2);
-	    atbl[(tblOffset + k * vecwidth + v)*2 + 0] = tbl[log2len][tblOffset + v * K + k];
-	    atbl[(tblOffset + k * vecwidth + v)*2 + 1] = tbl[log2len][tblOffset + v * K + k];
-	  }
+    tblOffset = makeTableRecurse(tbl, p, log2len, level, 0, sign, 0, 1 << N, N, tblOffset);
+  }
+
+  if (level == log2len) {
+    real *atbl = (real *)Sleef_malloc(sizeof(real)*(K << (log2len-N))*2);
+    tblOffset = 0;
+    while(tblOffset < (K << (log2len-N))) {
+      for(int k=0;k < K;k++) {
+	for(int v = 0;v < vecwidth;v++) {
+	  assert((tblOffset + k * vecwidth + v)*2 + 1 < (K << (log2len-N))*2);
+	  atbl[(tblOffset + k * vecwidth + v)*2 + 0] = tbl[tblOffset + v * K + k];
+	  atbl[(tblOffset + k * vecwidth + v)*2 + 1] = tbl[tblOffset + v * K + k];
 	}
-	tblOffset += K * vecwidth;
       }
-      Sleef_free(tbl[log2len]);
-      tbl[log2len] = atbl;
+      tblOffset += K * vecwidth;
     }
+    Sleef_free(tbl);
+    tbl = atbl;
   }
 
   free(p);
@@ -439,6 +584,86 @@ static real **makeTable(int sign, int vecwidth, int log2len, const int N, const
   return tbl;
 }
 
+// Borrows the twiddle table of the butterfly from the shared cache
+static void acquireTable(SleefDFT *p, const int N, const int level) {
+  real **tbl = ((real ***)p->tbl)[N];
+  if (tbl[level] != NULL) return;
+
+  const int sign = (p->mode & SLEEF_MODE_BACKWARD) != 0 ? -1 : 1;
+  uint64_t key = TableCache_keyTwiddle(BASETYPEID, p->log2len, sign, p->log2vecwidth, N, level);
+  real *t = (real *)TableCache_acquire(key);
+  if (t == NULL) {
+    size_t size = sizeof(real) * (level == (int)p->log2len ? (constK[N] << (p->log2len-N))*2 : constK[N] << (level-N));
+    t = (real *)TableCache_insert(key, makeTable(sign, p->vecwidth, p->log2len, N, constK[N], level), size);
+  }
+  tbl[level] = t;
+}
+
+static uint32_t *acquirePerm(SleefDFT *p, const int N, const int level) {
+  uint64_t key = TableCache_keyPerm(p->log2len, p->log2vecwidth, N, level);
+  uint32_t *t = (uint32_t *)TableCache_acquire(key);
+  if (t != NULL) return t;
+
+  t = makePermTable(p->log2len, p->log2vecwidth, N, level);
+  return (uint32_t *)TableCache_insert(key, t, sizeof(uint32_t) * ((1 << p->log2len) + 8));
+}
+
+static void allocTables(SleefDFT *p) {
+  for(int N=1;N<=MAXBUTWIDTH;N++) {
+    p->tbl[N] = (int)p->log2len < N ? NULL : (void **)calloc(sizeof(void *), p->log2len+1);
+  }
+}
+
+// Makes the plan hold the twiddle and permutation tables of the
+// butterflies on bestPath, and nothing else. Stockham stages need no
+// permutation table.
+void BINDPATH(SleefDFT *p) {
+  for(int level = p->log2len;level >= 1;level--) {
+    int N = 0, stockham = 0;
+    for(int l = p->log2len;l >= level;l -= ABS(p->bestPath[l])) {
+      if (l == level) {
+	N = ABS(p->bestPath[l]);
+	stockham = (p->bestPathConfig[l] & CONFIG_STOCKHAM) != 0;
+	break;
+      }
+      if (p->bestPath[l] == 0) break;
+    }
+    if (N == level) N = 0;
+
+    for(int n=1;n<=MAXBUTWIDTH;n++) {
+      if (p->tbl[n] == NULL || n == N || p->tbl[n][level] == NULL) continue;
+      TableCache_release(p->tbl[n][level]);
+      p->tbl[n][level] = NULL;
+    }
+
+    uint32_t *old = p->perm[level];
+    p->perm[level] = NULL;
+    if (N != 0) {
+      acquireTable(p, N, level);
+      if (!stockham) p->perm[level] = acquirePerm(p, N, level);
+    }
+    TableCache_release(old);
+  }
+}
+
+// Planning time limit
+
+static int planTimeExceeded(SleefDFT *p) {
+  if (p->planner != NULL && p->planner->cancel) return 1;
+  return p->planDeadline != 0 && Sleef_currentTimeMicros() > p->planDeadline;
+}
+
+// Returns the fastest variant of the config at the level, that is,
+// with or without streaming stores and the Stockham kernel
+static int fastestConfig(SleefDFT *p, int config, int level, int N) {
+  int best = config;
+  for(int c=0;c<PATHCONFIGMAX;c++) {
+    if ((c & CONFIG_MT) != (config & CONFIG_MT)) continue;
+    if (p->tm[c][level*(MAXBUTWIDTH+1) + N] < p->tm[best][level*(MAXBUTWIDTH+1) + N]) best = c;
+  }
+  return best;
+}
+
 // Random planner (for debugging)
 
 static int searchForRandomPathRecurse(SleefDFT *p, int level, int *path, int *pathConfig, uint64_t tm, int nTrial) {
@@ -458,16 +683,18 @@ static int searchForRandomPathRecurse(SleefDFT *p, int level, int *path, int *pa
 
     do {
       N = 1 + rand() % MAXBUTWIDTH;
-    } while(p->tm[0][level*(MAXBUTWIDTH+1)+N] >= 1ULL << 60);
+    } while(p->tm[fastestConfig(p, 0, level, N)][level*(MAXBUTWIDTH+1)+N] >= 1ULL << 60);
 
     if (p->vecwidth > (1 << N) || N == p->log2len) continue;
 
     path[level] = N;
     for(;;) {
-      pathConfig[level] = rand() % CONFIGMAX;
+      pathConfig[level] = rand() % PATHCONFIGMAX;
 #if ENABLE_STREAM == 0
       pathConfig[level] &= ~1;
 #endif
+      if ((p->mode & SLEEF_MODE_LOW_MEMORY) != 0) pathConfig[level] |= CONFIG_STOCKHAM;
+      if (N == level) pathConfig[level] &= ~CONFIG_STOCKHAM;
       if ((p->mode2 & SLEEF_MODE2_MT1D) == 0 && (pathConfig[level] & CONFIG_MT) != 0) continue;
       break;
     }
@@ -623,12 +850,10 @@ static uint64_t ksAdjacentCost(ks_t *q, int pos, int n) {
   int nxpos = ksAdjacent(q, pos, n);
   if (nxpos == -1) return 0;
   int config = pos2config(nxpos), level = pos2level(nxpos), N = pos2N(nxpos);
-  uint64_t ret0 = q->p->tm[config | 0][level*(MAXBUTWIDTH+1) + N];
-  uint64_t ret1 = q->p->tm[config | 1][level*(MAXBUTWIDTH+1) + N];
-  return MIN(ret0, ret1);
+  return q->p->tm[fastestConfig(q->p, config, level, N)][level*(MAXBUTWIDTH+1) + N];
 }
 
-static void searchForBestPath(SleefDFT *p) {
+static void searchForBestPath(SleefDFT *p, int timed) {
   ks_t *q = ksInit(p);
 
   for(int i=0;;i++) {
@@ -677,7 +902,7 @@ static void searchForBestPath(SleefDFT *p) {
 
   for(int j = p->log2len;j >= 0;j--) p->bestPath[j] = 0;
 
-  if (((p->mode & SLEEF_MODE_MEASURE) != 0 || (planFilePathSet && (p->mode & SLEEF_MODE_MEASUREBITS) == 0))) {
+  if (timed) {
     uint64_t besttm = 1ULL << 62;
     int bestPath = -1;
     const int niter =  1 + 5000000 / ((1 << p->log2len) + 1);
@@ -686,31 +911,32 @@ static void searchForBestPath(SleefDFT *p) {
     const real *s = p->in  == NULL ? (s2 = (real *)memset(Sleef_malloc((2 << p->log2len) * sizeof(real)), 0, sizeof(real) * (2 << p->log2len))) : p->in;
     real       *d = p->out == NULL ? (d2 = (real *)memset(Sleef_malloc((2 << p->log2len) * sizeof(real)), 0, sizeof(real) * (2 << p->log2len))) : p->out;
 
-#ifdef _OPENMP
-    const int tn = omp_get_thread_num();
-#else
-    const int tn = 0;
-#endif
+    const int tn = Executor_slot();
 
     real *t[] = { p->x1[tn], p->x0[tn], d };
 
     for(int mt=0;mt<2;mt++) {
       for(int i=q->nPaths-1;i>=0;i--) {
 	if (((pos2config(q->path[i][0]) & CONFIG_MT) != 0) != mt) continue;
+	if (bestPath != -1 && planTimeExceeded(p)) break;
 
 	if ((p->mode & SLEEF_MODE_VERBOSE) != 0) {
 	  for(int j=0;j<q->pathLen[i];j++) {
 	    int N = pos2N(q->path[i][j]);
 	    int level = pos2level(q->path[i][j]);
-	    int config = pos2config(q->path[i][j]) & ~1;
-	    uint64_t t0 = q->p->tm[config | 0][level*(MAXBUTWIDTH+1) + N];
-	    uint64_t t1 = q->p->tm[config | 1][level*(MAXBUTWIDTH+1) + N];
-	    config = t0 < t1 ? config : (config | 1);
+	    int config = fastestConfig(p, pos2config(q->path[i][j]), level, N);
 
 	    if (N != 0) printf("%d(%s) ", N, configStr[config]);
 	  }
 	}
 
+	for(int level = p->log2len, j=0;level >= 1;j++) {
+	  int N = pos2N(q->path[i][j]);
+	  int config = fastestConfig(p, pos2config(q->path[i][j]), level, N);
+	  if (level != N && (config & CONFIG_STOCKHAM) == 0) p->perm[level] = acquirePerm(p, N, level);
+	  level -= N;
+	}
+
 	if (mt) startAllThreads(p->nThread);
 
 	uint64_t tm0 = Sleef_currentTimeMicros();
@@ -721,10 +947,7 @@ static void searchForBestPath(SleefDFT *p) {
 	  for(int level = p->log2len, j=0;level >= 1;j++) {
 	    assert(pos2level(q->path[i][j]) == level);
 	    int N = pos2N(q->path[i][j]);
-	    int config = pos2config(q->path[i][j]) & ~1;
-	    uint64_t t0 = q->p->tm[config | 0][level*(MAXBUTWIDTH+1) + N];
-	    uint64_t t1 = q->p->tm[config | 1][level*(MAXBUTWIDTH+1) + N];
-	    config = t0 < t1 ? config : (config | 1);
+	    int config = fastestConfig(p, pos2config(q->path[i][j]), level, N);
 	    dispatch(p, N, t[nb+1], lb, level, config);
 	    level -= N;
 	    lb = t[nb+1];
@@ -739,10 +962,7 @@ static void searchForBestPath(SleefDFT *p) {
 	  for(int level = p->log2len, j=0;level >= 1;j++) {
 	    assert(pos2level(q->path[i][j]) == level);
 	    int N = pos2N(q->path[i][j]);
-	    int config = pos2config(q->path[i][j]) & ~1;
-	    uint64_t t0 = q->p->tm[config | 0][level*(MAXBUTWIDTH+1) + N];
-	    uint64_t t1 = q->p->tm[config | 1][level*(MAXBUTWIDTH+1) + N];
-	    config = t0 < t1 ? config : (config | 1);
+	    int config = fastestConfig(p, pos2config(q->path[i][j]), level, N);
 	    dispatch(p, N, t[nb+1], lb, level, config);
 	    level -= N;
 	    lb = t[nb+1];
@@ -751,6 +971,11 @@ static void searchForBestPath(SleefDFT *p) {
 	}
 	uint64_t tm2 = Sleef_currentTimeMicros();
 
+	for(int level = p->log2len;level >= 1;level--) {
+	  TableCache_release(p->perm[level]);
+	  p->perm[level] = NULL;
+	}
+
 	if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf(" : %lld %lld\n", (long long int)(tm1 - tm0), (long long int)(tm2 - tm1));
 	if ((tm1 - tm0) < besttm) {
 	  bestPath = i;
@@ -767,10 +992,7 @@ static void searchForBestPath(SleefDFT *p) {
       assert(pos2level(q->path[bestPath][j]) == level);
       int N = pos2N(q->path[bestPath][j]);
 
-      int config = pos2config(q->path[bestPath][j]) & ~1;
-      uint64_t t0 = q->p->tm[config | 0][level*(MAXBUTWIDTH+1) + N];
-      uint64_t t1 = q->p->tm[config | 1][level*(MAXBUTWIDTH+1) + N];
-      config = t0 < t1 ? config : (config | 1);
+      int config = fastestConfig(p, pos2config(q->path[bestPath][j]), level, N);
 
       p->bestPath[level] = N;
       p->bestPathConfig[level] = config;
@@ -784,7 +1006,7 @@ static void searchForBestPath(SleefDFT *p) {
       int bestPath = 0;
       assert(pos2level(q->path[bestPath][j]) == level);
       int N = pos2N(q->path[bestPath][j]);
-      int config = pos2config(q->path[bestPath][j]);
+      int config = fastestConfig(p, pos2config(q->path[bestPath][j]), level, N);
       p->bestPath[level] = N;
       p->bestPathConfig[level] = config;
       level -= N;
@@ -802,34 +1024,47 @@ static uint64_t estimate(int log2len, int level, int N, int config) {
   return ret;
 }
 
-static void measureBut(SleefDFT *p) {
-  if (p->x0 == NULL) return;
+// Returns 0 if the time limit for planning is reached before every
+// butterfly is measured once
+static int measureBut(SleefDFT *p) {
+  if (p->x0 == NULL) return 0;
 
   //
 
-#ifdef _OPENMP
-  const int tn = omp_get_thread_num();
-#else
-  const int tn = 0;
-#endif
+  const int tn = Executor_slot();
 
   real *s = (real *)memset(p->x0[tn], 0, sizeof(real) * (2 << p->log2len));
   real *d = (real *)memset(p->x1[tn], 0, sizeof(real) * (2 << p->log2len));
 
   const int niter =  1 + 100000 / ((1 << p->log2len) + 1);
 
+  // The permutation table is rewritten for each butterfly measured, so
+  // a private one is used here instead of the shared ones. A plan in
+  // the low memory mode only measures the Stockham kernels, which need
+  // none.
+
+  const int lowMem = (p->mode & SLEEF_MODE_LOW_MEMORY) != 0;
+  uint32_t *permScratch = lowMem ? NULL : (uint32_t *)Sleef_malloc(sizeof(uint32_t) * ((1 << p->log2len) + 8));
+  for(uint32_t level = p->log2len;level >= 1;level--) p->perm[level] = permScratch;
+
 #define MEASURE_REPEAT 4
 
-  for(int rep=1;rep<=MEASURE_REPEAT;rep++) {
-    for(int config=0;config<CONFIGMAX;config++) {
+  int complete = 1;
+
+  for(int rep=1;rep<=MEASURE_REPEAT && complete;rep++) {
+    for(int config=0;config<PATHCONFIGMAX && complete;config++) {
 #if ENABLE_STREAM == 0
       if ((config & 1) != 0) continue;
 #endif
       if ((p->mode2 & SLEEF_MODE2_MT1D) == 0 && (config & CONFIG_MT) != 0) continue;
+      const int stockham = (config & CONFIG_STOCKHAM) != 0;
       for(uint32_t level = p->log2len;level >= 1;level--) {
+	if (rep == 1 && planTimeExceeded(p)) { complete = 0; break; }
 	for(uint32_t N=1;N<=MAXBUTWIDTH;N++) {
 	  if (level < N || p->log2len <= N) continue;
+	  if (lowMem && !stockham && level != N) continue;
 	  if (level == N) {
+	    if (stockham) continue;
 	    if ((int)p->log2len - (int)level < p->log2vecwidth) continue;
 
 	    uint64_t tm = Sleef_currentTimeMicros();
@@ -839,21 +1074,11 @@ static void measureBut(SleefDFT *p) {
 	    tm = Sleef_currentTimeMicros() - tm + 1;
 	    p->tm[config][level*(MAXBUTWIDTH+1)+N] = MIN(p->tm[config][level*(MAXBUTWIDTH+1)+N], tm);
 	  } else if (level == p->log2len) {
-	    if (p->tbl[N] == NULL || p->tbl[N][level] == NULL) continue;
+	    if (!tableAvailable(p, N, level)) continue;
 	    if (p->vecwidth > (1 << N)) continue;
-	    if ((config & CONFIG_MT) != 0) {
-	      int i1=0;
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-	      for(i1=0;i1 < (1 << (p->log2len-N-p->log2vecwidth));i1++) {
-		int i0 = i1 << p->log2vecwidth;
-		p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
-	      }
-	    } else {
-	      for(int i0=0, i1=0;i0 < (1 << (p->log2len-N));i0+=p->vecwidth, i1++) {
-		p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
-	      }
+	    acquireTable(p, N, level);
+	    for(int i0=0, i1=0;!stockham && i0 < (1 << (p->log2len-N));i0+=p->vecwidth, i1++) {
+	      p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
 	    }
 
 	    uint64_t tm = Sleef_currentTimeMicros();
@@ -864,22 +1089,12 @@ static void measureBut(SleefDFT *p) {
 	    tm = Sleef_currentTimeMicros() - tm + 1;
 	    p->tm[config][level*(MAXBUTWIDTH+1)+N] = MIN(p->tm[config][level*(MAXBUTWIDTH+1)+N], tm);
 	  } else {
-	    if (p->tbl[N] == NULL || p->tbl[N][level] == NULL) continue;
+	    if (!tableAvailable(p, N, level)) continue;
 	    if (p->vecwidth > 2 && p->log2len <= N+2) continue;
 	    if ((int)p->log2len - (int)level < p->log2vecwidth) continue;
-	    if ((config & CONFIG_MT) != 0) {
-	      int i1=0;
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-	      for(i1=0;i1 < (1 << (p->log2len-N-p->log2vecwidth));i1++) {
-		int i0 = i1 << p->log2vecwidth;
-		p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
-	      }
-	    } else {
-	      for(int i0=0, i1=0;i0 < (1 << (p->log2len-N));i0+=p->vecwidth, i1++) {
-		p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
-	      }
+	    acquireTable(p, N, level);
+	    for(int i0=0, i1=0;!stockham && i0 < (1 << (p->log2len-N));i0+=p->vecwidth, i1++) {
+	      p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
 	    }
 
 	    uint64_t tm = Sleef_currentTimeMicros();
@@ -893,6 +1108,15 @@ static void measureBut(SleefDFT *p) {
 	}
       }
     }
+    if (planTimeExceeded(p)) break;
+  }
+
+  for(uint32_t level = p->log2len;level >= 1;level--) p->perm[level] = NULL;
+  if (permScratch != NULL) Sleef_free(permScratch);
+
+  if (!complete) {
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("Time limit for planning reached\n");
+    return 0;
   }
 
   if ((p->mode & SLEEF_MODE_VERBOSE) != 0) {
@@ -902,7 +1126,7 @@ static void measureBut(SleefDFT *p) {
 	if (level == N) {
 	  if ((int)p->log2len - (int)level < p->log2vecwidth) continue;
 	  printf("bot %d, %d, %d, ", p->log2len, level, N);
-	  for(int config=0;config<CONFIGMAX;config++) {
+	  for(int config=0;config<PATHCONFIGMAX;config++) {
 	    if (p->tm[config][level*(MAXBUTWIDTH+1)+N] == 1ULL << 60) {
 	      printf("N/A, ");
 	    } else {
@@ -911,10 +1135,10 @@ static void measureBut(SleefDFT *p) {
 	  }
 	  printf("\n");
 	} else if (level == p->log2len) {
-	  if (p->tbl[N] == NULL || p->tbl[N][level] == NULL) continue;
+	  if (!tableAvailable(p, N, level)) continue;
 	  if (p->vecwidth > (1 << N)) continue;
 	  printf("top %d, %d, %d, ", p->log2len, level, N);
-	  for(int config=0;config<CONFIGMAX;config++) {
+	  for(int config=0;config<PATHCONFIGMAX;config++) {
 	    if (p->tm[config][level*(MAXBUTWIDTH+1)+N] == 1ULL << 60) {
 	      printf("N/A, ");
 	    } else {
@@ -923,11 +1147,11 @@ static void measureBut(SleefDFT *p) {
 	  }
 	  printf("\n");
 	} else {
-	  if (p->tbl[N] == NULL || p->tbl[N][level] == NULL) continue;
+	  if (!tableAvailable(p, N, level)) continue;
 	  if (p->vecwidth > 2 && p->log2len <= N+2) continue;
 	  if ((int)p->log2len - (int)level < p->log2vecwidth) continue;
 	  printf("mid %d, %d, %d, ", p->log2len, level, N);
-	  for(int config=0;config<CONFIGMAX;config++) {
+	  for(int config=0;config<PATHCONFIGMAX;config++) {
 	    if (p->tm[config][level*(MAXBUTWIDTH+1)+N] == 1ULL << 60) {
 	      printf("N/A, ");
 	    } else {
@@ -939,44 +1163,69 @@ static void measureBut(SleefDFT *p) {
       }
     }
   }
+
+  return 1;
+}
+
+// Whether the butterfly of width N can be used at the level
+static int butAvailable(SleefDFT *p, uint32_t N, uint32_t level) {
+  if (level < N || p->log2len <= N) return 0;
+  if (level == N) return (int)p->log2len - (int)level >= p->log2vecwidth;
+  if (!tableAvailable(p, N, level)) return 0;
+  if (level == p->log2len) return p->vecwidth <= (1 << N);
+  if (p->vecwidth > 2 && p->log2len <= N+2) return 0;
+  return (int)p->log2len - (int)level >= p->log2vecwidth;
 }
 
+// Estimated plans use the Stockham kernels from this length, where
+// the permutation tables no longer fit in the cache
+
+#define STOCKHAM_MIN_LOG2LEN 18
+
 static void estimateBut(SleefDFT *p) {
+  const int stockham = (p->mode & SLEEF_MODE_LOW_MEMORY) != 0 || p->log2len >= STOCKHAM_MIN_LOG2LEN;
   for(uint32_t level = p->log2len;level >= 1;level--) {
     for(uint32_t N=1;N<=MAXBUTWIDTH;N++) {
-      if (level < N || p->log2len <= N) continue;
-      if (level == N) {
-	if ((int)p->log2len - (int)level < p->log2vecwidth) continue;
-	for(int config=0;config<CONFIGMAX;config++) {
-#if ENABLE_STREAM == 0
-	  if ((config & 1) != 0) continue;
-#endif
-	  p->tm[config][level*(MAXBUTWIDTH+1)+N] = estimate(p->log2len, level, N, config);
-	}
-      } else if (level == p->log2len) {
-	if (p->tbl[N] == NULL || p->tbl[N][level] == NULL) continue;
-	if (p->vecwidth > (1 << N)) continue;
-	for(int config=0;config<CONFIGMAX;config++) {
-#if ENABLE_STREAM == 0
-	  if ((config & 1) != 0) continue;
-#endif
-	  p->tm[config][level*(MAXBUTWIDTH+1)+N] = estimate(p->log2len, level, N, config);
-	}
-      } else {
-	if (p->tbl[N] == NULL || p->tbl[N][level] == NULL) continue;
-	if (p->vecwidth > 2 && p->log2len <= N+2) continue;
-	if ((int)p->log2len - (int)level < p->log2vecwidth) continue;
-	for(int config=0;config<CONFIGMAX;config++) {
+      if (!butAvailable(p, N, level)) continue;
+      for(int config=0;config<PATHCONFIGMAX;config++) {
 #if ENABLE_STREAM == 0
-	  if ((config & 1) != 0) continue;
+	if ((config & 1) != 0) continue;
 #endif
-	  p->tm[config][level*(MAXBUTWIDTH+1)+N] = estimate(p->log2len, level, N, config);
-	}
+	if (level == N && (config & CONFIG_STOCKHAM) != 0) continue;
+	if (level != N && ((config & CONFIG_STOCKHAM) != 0) != stockham) continue;
+	p->tm[config][level*(MAXBUTWIDTH+1)+N] = estimate(p->log2len, level, N, config);
+      }
+    }
+  }
+}
+
+static void clearButTimes(SleefDFT *p) {
+  for(uint32_t level = p->log2len;level >= 1;level--) {
+    for(uint32_t N=1;N<=MAXBUTWIDTH;N++) {
+      for(int config=0;config<PATHCONFIGMAX;config++) {
+	p->tm[config][level*(MAXBUTWIDTH+1)+N] = 1ULL << 60;
       }
     }
   }
 }
 
+// Checks a path loaded from the plan file or imported plans
+static int pathAvailable(SleefDFT *p) {
+  for(int level = p->log2len;level >= 1;) {
+    int N = ABS(p->bestPath[level]);
+    if (!butAvailable(p, N, level)) return 0;
+    if ((p->mode & SLEEF_MODE_LOW_MEMORY) != 0 && N != level && (p->bestPathConfig[level] & CONFIG_STOCKHAM) == 0) return 0;
+    level -= N;
+  }
+  return 1;
+}
+
+// Plans with and without MT, and in the low memory mode, are saved
+// separately
+static int pathCategory(SleefDFT *p) {
+  return ((p->mode & SLEEF_MODE_NO_MT) != 0 ? 1 : 0) | ((p->mode & SLEEF_MODE_LOW_MEMORY) != 0 ? 2 : 0);
+}
+
 static int measure(SleefDFT *p, int randomize) {
   if (p->log2len == 1) {
     p->bestTime = 1ULL << 60;
@@ -987,7 +1236,7 @@ static int measure(SleefDFT *p, int randomize) {
     return 1;
   }
 
-  if (PlanManager_loadMeasurementResultsP(p, (p->mode & SLEEF_MODE_NO_MT) != 0 ? 1 : 0)) {
+  if (PlanManager_loadMeasurementResultsP(p, pathCategory(p)) && pathAvailable(p)) {
     if ((p->mode & SLEEF_MODE_VERBOSE) != 0) {
       printf("Path(loaded) : ");
       for(int j = p->log2len;j >= 0;j--) if (p->bestPath[j] != 0) printf("%d(%s) ", p->bestPath[j], configStr[p->bestPathConfig[j]]);
@@ -999,24 +1248,26 @@ static int measure(SleefDFT *p, int randomize) {
   
   int toBeSaved = 0;
 
-  for(uint32_t level = p->log2len;level >= 1;level--) {
-    for(uint32_t N=1;N<=MAXBUTWIDTH;N++) {
-      for(int config=0;config<CONFIGMAX;config++) {
-	p->tm[config][level*(MAXBUTWIDTH+1)+N] = 1ULL << 60;
-      }
-    }
-  }
+  clearButTimes(p);
   
   if (((p->mode & SLEEF_MODE_MEASURE) != 0 || (planFilePathSet && (p->mode & SLEEF_MODE_MEASUREBITS) == 0)) && !randomize) {
-    measureBut(p);
-    toBeSaved = 1;
-  } else {
+    if ((p->mode2 & SLEEF_MODE2_DEFER) != 0) {
+      // The measurement is left to the background planner
+      p->mode2 |= SLEEF_MODE2_REFINE;
+    } else {
+      p->planDeadline = planTimeLimit == 0 ? 0 : Sleef_currentTimeMicros() + planTimeLimit * 1000;
+      toBeSaved = measureBut(p);
+    }
+  }
+
+  if (!toBeSaved) {
+    clearButTimes(p);
     estimateBut(p);
   }
 
   int executable = 0;
   for(int i=1;i<=MAXBUTWIDTH && !executable;i++) {
-    if (p->tm[0][p->log2len*(MAXBUTWIDTH+1)+i] < (1ULL << 60)) executable = 1;
+    if (p->tm[fastestConfig(p, 0, p->log2len, i)][p->log2len*(MAXBUTWIDTH+1)+i] < (1ULL << 60)) executable = 1;
   }
 
   if (!executable) return 0;
@@ -1026,7 +1277,7 @@ static int measure(SleefDFT *p, int randomize) {
   p->bestPath[p->log2len] = 0;
   
   if (!randomize) {
-    searchForBestPath(p);
+    searchForBestPath(p, toBeSaved);
   } else {
     int path[MAXLOG2LEN+1];
     int pathConfig[MAXLOG2LEN+1];
@@ -1054,16 +1305,91 @@ static int measure(SleefDFT *p, int randomize) {
   }
 
   if (toBeSaved) {
-    PlanManager_saveMeasurementResultsP(p, (p->mode & SLEEF_MODE_NO_MT) != 0 ? 1 : 0);
+    PlanManager_saveMeasurementResultsP(p, pathCategory(p));
   }
   
   return 1;
 }
 
+// Background planner
+
+#ifdef ENABLE_PTHREAD
+static void *refinePlan(void *arg) {
+  SleefDFT *q = (SleefDFT *)arg;
+
+  int success = measure(q, 0);
+
+  for(int i=0;i<q->nThread;i++) {
+    Sleef_free(q->x0[i]);
+    Sleef_free(q->x1[i]);
+  }
+  free(q->x0);
+  free(q->x1);
+  q->x0 = q->x1 = NULL;
+
+  if (success && !q->planner->cancel) {
+    BINDPATH(q);
+    __atomic_store_n(&q->planner->path, q, __ATOMIC_RELEASE);
+  }
+
+  return NULL;
+}
+#endif
+
+// Measures the path on a copy of the plan in a background thread. The
+// plan keeps executing with the estimated path until the measured one
+// is ready.
+static void startPlanner(SleefDFT *p) {
+#ifdef ENABLE_PTHREAD
+  SleefDFT *q = (SleefDFT *)malloc(sizeof(SleefDFT));
+  memcpy(q, p, sizeof(SleefDFT));
+
+  q->mode2 &= ~(SLEEF_MODE2_DEFER | SLEEF_MODE2_REFINE);
+  q->in = NULL;
+  q->out = NULL;
+  q->rtCoef0 = q->rtCoef1 = NULL;
+  q->perm = (uint32_t **)calloc(sizeof(uint32_t *), q->log2len+1);
+  allocTables(q);
+
+  q->x0 = malloc(sizeof(real *) * q->nThread);
+  q->x1 = malloc(sizeof(real *) * q->nThread);
+  for(int i=0;i<q->nThread;i++) {
+    q->x0[i] = (real *)Sleef_malloc(sizeof(real) * (2 << q->log2len));
+    q->x1[i] = (real *)Sleef_malloc(sizeof(real) * (2 << q->log2len));
+  }
+
+  AsyncPlanner *a = (AsyncPlanner *)calloc(1, sizeof(AsyncPlanner));
+  a->refined = q;
+  p->planner = q->planner = a;
+
+  if (pthread_create(&a->thread, NULL, refinePlan, q) != 0) {
+    // Keep the estimated path
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("Background planner could not be started\n");
+    for(int i=0;i<q->nThread;i++) {
+      Sleef_free(q->x0[i]);
+      Sleef_free(q->x1[i]);
+    }
+    free(q->x0);
+    free(q->x1);
+    free(q->perm);
+    freeTables(q);
+    free(q);
+    free(a);
+    p->planner = NULL;
+  }
+#endif
+}
+
+static size_t wsSize(SleefDFT *p);
+static int panel2DAvailable(SleefDFT *p);
+static void execute2D(SleefDFT *p, const real *s, real *d, real *ws, int strategy);
+
 static void measureTranspose(SleefDFT *p) {
   if (PlanManager_loadMeasurementResultsT(p)) {
     if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("transpose NoMT(loaded): %lld\n", (long long int)p->tmNoMT);
     if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("transpose   MT(loaded): %lld\n", (long long int)p->tmMT);
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("2D separate(loaded): %lld\n", (long long int)p->tmSep);
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("2D    panel(loaded): %lld\n", (long long int)p->tmPanel);
     return;
   }
 
@@ -1077,6 +1403,15 @@ static void measureTranspose(SleefDFT *p) {
       p->tmMT = 20;
       if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("transpose : selected NoMT(estimated)\n");
     }
+
+    // The panel strategy saves two passes over the whole array, which
+    // pays off once the array no longer fits in the cache
+    p->tmSep = 20;
+    p->tmPanel = 0;
+    if (panel2DAvailable(p) && p->log2hlen + p->log2vlen >= 16) {
+      p->tmPanel = 10;
+      if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("2D : selected panel(estimated)\n");
+    }
     return;
   }
   
@@ -1094,343 +1429,3557 @@ static void measureTranspose(SleefDFT *p) {
 
   if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("transpose NoMT(measured): %lld\n", (long long int)p->tmNoMT);
 
-#ifdef _OPENMP
+  if (MIN(p->tNThread, Executor_threadCount()) > 1) {
+    tm = Sleef_currentTimeMicros();
+    for(int i=0;i<niter;i++) {
+      transposeMT(tBuf2, p->tBuf, p->log2hlen, p->log2vlen, p->tNThread);
+      transposeMT(tBuf2, p->tBuf, p->log2vlen, p->log2hlen, p->tNThread);
+    }
+    p->tmMT = Sleef_currentTimeMicros() - tm + 1;
+
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("transpose   MT(measured): %lld\n", (long long int)p->tmMT);
+  } else {
+    p->tmMT = p->tmNoMT*2;
+  }
+
+  // Whole transforms with the better transpose and with panels
+
+  real *ws = (p->mode & SLEEF_MODE_NO_SCRATCH) == 0 ? NULL : (real *)Sleef_malloc(sizeof(real) * wsSize(p));
+  memset(tBuf2, 0, sizeof(real)*2*p->hlen*p->vlen);
+  const int niter2D = 1 + 1000000 / (p->hlen * p->vlen + 1);
+
   tm = Sleef_currentTimeMicros();
-  for(int i=0;i<niter;i++) {
-    transposeMT(tBuf2, p->tBuf, p->log2hlen, p->log2vlen);
-    transposeMT(tBuf2, p->tBuf, p->log2vlen, p->log2hlen);
+  for(int i=0;i<niter2D;i++) execute2D(p, tBuf2, tBuf2, ws, p->tmMT < p->tmNoMT ? 1 : 0);
+  p->tmSep = Sleef_currentTimeMicros() - tm + 1;
+
+  if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("2D separate(measured): %lld\n", (long long int)p->tmSep);
+
+  p->tmPanel = 0;
+  if (panel2DAvailable(p)) {
+    tm = Sleef_currentTimeMicros();
+    for(int i=0;i<niter2D;i++) execute2D(p, tBuf2, tBuf2, ws, 2);
+    p->tmPanel = Sleef_currentTimeMicros() - tm + 1;
+
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("2D    panel(measured): %lld\n", (long long int)p->tmPanel);
   }
-  p->tmMT = Sleef_currentTimeMicros() - tm + 1;
 
-  if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("transpose   MT(measured): %lld\n", (long long int)p->tmMT);
-#else
-  p->tmMT = p->tmNoMT*2;
-#endif
-  
+  if (ws != NULL) Sleef_free(ws);
   Sleef_free(tBuf2);
 
   PlanManager_saveMeasurementResultsT(p);
 }
 
-// Implementation of SleefDFT_*_init1d
+// Workspace
+
+// A workspace holds the scratch buffers of one execution, so that a
+// plan is not modified while it is executed. Slices of a workspace are
+// rounded up to keep them aligned like the memory from Sleef_malloc.
+// Plans made with SLEEF_MODE_NO_SCRATCH keep no buffers of their own.
+
+#define WS_ALIGN (256 / sizeof(real))
+
+static size_t wsRound(size_t n) { return (n + WS_ALIGN - 1) & ~(WS_ALIGN - 1); }
+
+static void **allocBuffers(int nThread, size_t n, uint64_t mode) {
+  if ((mode & SLEEF_MODE_NO_SCRATCH) != 0) return NULL;
+
+  void **buf = malloc(sizeof(void *) * nThread);
+  for(int i=0;i<nThread;i++) buf[i] = Sleef_malloc(sizeof(real) * n);
+  return buf;
+}
+
+static size_t wsSize(SleefDFT *p);
+static void executeWS(SleefDFT *p, const real *s, real *d, real *ws);
+static int ioAvailable(SleefDFT *p);
+static void executeIO(SleefDFT *p, const KernelIO *io, real *ws);
+
+// Mixed-radix planner
+
+// Lengths of the form 2^a * 3^b * 5^c * 7^d are transformed by
+// peeling one odd radix r at a time. The input is gathered into r
+// rows of length m = n/r, each row is transformed by a sub-plan of
+// length m, and a radix-r butterfly with fused twiddles writes the
+// result in natural order.
+
+static int mrRadix(uint32_t n) {
+  if (n % 7 == 0) return 7;
+  if (n % 5 == 0) return 5;
+  if (n % 3 == 0) return 3;
+  return 0;
+}
+
+static int isSmoothLength(uint32_t n) {
+  if (n == 0) return 0;
+  while(n % 7 == 0) n /= 7;
+  while(n % 5 == 0) n /= 5;
+  while(n % 3 == 0) n /= 3;
+  return (n & (n - 1)) == 0;
+}
+
+// Scalar butterflies for the columns [i0, i1). These cover the
+// whole row when no vector ISA is available, and otherwise only the
+// m % VECWIDTH columns left over by the vectorized kernels.
+
+static void mrButScalar(SleefDFT *p, real *d, const real *s, int i0, int i1) {
+  const int r = p->radix, m = p->length / r;
+  const real *tbl = (const real *)p->mrTbl, *coef = (const real *)p->mrCoef;
+
+  for(int i=i0;i<i1;i++) {
+    real ar[8], ai[8];
+
+    ar[0] = s[i*2+0]; ai[0] = s[i*2+1];
+    for(int j=1;j<r;j++) {
+      real xr = s[(j*m+i)*2+0], xi = s[(j*m+i)*2+1];
+      real c = tbl[((2*j-2)*m+i)*2], sn = tbl[((2*j-1)*m+i)*2];
+      ar[j] = xr * c - xi * sn;
+      ai[j] = xr * sn + xi * c;
+    }
+
+    for(int k=0;k<r;k++) {
+      real yr = 0, yi = 0;
+      for(int j=0;j<r;j++) {
+	int q = (j * k) % r;
+	yr += ar[j] * coef[q*2+0] - ai[j] * coef[q*2+1];
+	yi += ar[j] * coef[q*2+1] + ai[j] * coef[q*2+0];
+      }
+      d[(k*m+i)*2+0] = yr;
+      d[(k*m+i)*2+1] = yi;
+    }
+  }
+}
+
+static SleefDFT *initMixedRadix(uint32_t n, const real *in, real *out, uint64_t mode) {
+  const int radix = mrRadix(n);
+  const uint32_t m = n / radix;
 
-EXPORT SleefDFT *INIT(uint32_t n, const real *in, real *out, uint64_t mode) {
   SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
-  p->magic = MAGIC;
+  p->magic = MAGICMR;
   p->baseTypeID = BASETYPEID;
   p->in = (const void *)in;
   p->out = (void *)out;
-  
-  // Mode
-
   p->mode = mode;
-
-  if ((p->mode & SLEEF_MODE_NO_MT) == 0) {
-    p->mode2 |= SLEEF_MODE2_MT1D;
+  p->length = n;
+  p->radix = radix;
+
+  if (m > 1) {
+    p->instSub = INIT(m, NULL, NULL, mode);
+    if (p->instSub == NULL) {
+      p->magic = 0;
+      free(p);
+      return NULL;
+    }
   }
-  
-  if ((mode & SLEEF_MODE_REAL) != 0) n /= 2;
-  p->log2len = ilog2(n);
-
-  if (p->log2len <= 1) return p;
 
-  if ((mode & SLEEF_MODE_ALT) != 0) p->mode = mode = mode ^ SLEEF_MODE_BACKWARD;
+  int backward = ((mode & SLEEF_MODE_BACKWARD) != 0) != ((mode & SLEEF_MODE_ALT) != 0);
 
-#ifdef _OPENMP
-  p->nThread = omp_thread_count();
-#else
-  p->nThread = 1;
-  p->mode2 &= ~SLEEF_MODE2_MT1D;
-#endif
+  p->mrNThread = Executor_slotCount();
 
-  // ISA availability
+  // The vectorized butterflies process VECWIDTH columns at a time
+  // with unaligned loads, so any row length can use them; the
+  // remaining m % VECWIDTH columns are done by mrButScalar.
 
   int bestPriority = -1;
-  p->isa = -1;
+  p->mrIsa = -1;
 
   for(int i=0;i<ISAMAX;i++) {
-    if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY) && n >= (uint32_t)((*GETINT[i])(GETINT_VECWIDTH) * (*GETINT[i])(GETINT_VECWIDTH))) {
+    if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY)) {
       bestPriority = (*GETINT[i])(GETINT_DFTPRIORITY);
-      p->isa = i;
+      p->mrIsa = i;
     }
   }
 
-  if (p->isa == -1) {
-    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("ISA not available\n");
-    p->magic = 0;
-    free(p);
-    return NULL;
+  p->mrVec = 0;
+  if (p->mrIsa != -1) {
+    const uint32_t vw = (uint32_t)(*GETINT[p->mrIsa])(GETINT_VECWIDTH);
+    p->mrVec = (int)(m - m % vw);
+    if (p->mrVec == 0) p->mrIsa = -1;
   }
 
-  // Tables
+  p->mrConfig = 0;
+  if ((mode & SLEEF_MODE_NO_MT) == 0 && Executor_threadCount() > 1 && n >= (1 << 14)) p->mrConfig = CONFIG_MT;
+
+  real *tbl = (real *)Sleef_malloc(sizeof(real) * 4 * m * (radix - 1));
+  for(int j=1;j<radix;j++) {
+    for(uint32_t i=0;i<m;i++) {
+      uint64_t q = ((uint64_t)j * i) % n;
+      sc_t sc = SINCOSPI((backward ? 2 : -2) * (real)q / (real)n);
+      tbl[((2*j-2)*m+i)*2+0] = tbl[((2*j-2)*m+i)*2+1] = sc.y;
+      tbl[((2*j-1)*m+i)*2+0] = tbl[((2*j-1)*m+i)*2+1] = sc.x;
+    }
+  }
+  p->mrTbl = tbl;
+
+  real *coef = (real *)Sleef_malloc(sizeof(real) * 2 * radix);
+  for(int q=0;q<radix;q++) {
+    sc_t sc = SINCOSPI((backward ? 2 : -2) * (real)q / (real)radix);
+    coef[q*2+0] = sc.y;
+    coef[q*2+1] = sc.x;
+  }
+  p->mrCoef = coef;
+
+  p->mrBuf0 = allocBuffers(p->mrNThread, 2 * n, mode);
+  p->mrBuf1 = allocBuffers(p->mrNThread, 2 * n, mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) {
+    printf("Mixed radix : %d x %d, ", radix, (int)m);
+    if (p->mrIsa == -1) {
+      printf("scalar\n");
+    } else {
+      printf("%s %s", (char *)(*GETPTR[p->mrIsa])(0), configStr[p->mrConfig]);
+      if (p->mrVec != (int)m) printf(", %d scalar columns", (int)m - p->mrVec);
+      printf("\n");
+    }
+  }
+
+  return p;
+}
+
+typedef struct MixedRadixArg {
+  SleefDFT *p;
+  real *d;
+  const real *s;
+  int nTask;
+} MixedRadixArg;
+
+static void mixedRadixTask(void *ptr, int t) {
+  MixedRadixArg *a = (MixedRadixArg *)ptr;
+  SleefDFT *p = a->p;
+  const int r = p->radix, m = p->length / r;
+
+  KernelChunk_set(t, a->nTask);
+  if (((p->mode & SLEEF_MODE_BACKWARD) != 0) == ((p->mode & SLEEF_MODE_ALT) != 0)) {
+    (*MRBUTF[p->mrConfig][p->mrIsa][r])(a->d, a->s, m, (const real *)p->mrTbl);
+  } else {
+    (*MRBUTB[p->mrConfig][p->mrIsa][r])(a->d, a->s, m, (const real *)p->mrTbl);
+  }
+  KernelChunk_set(0, 1);
+}
+
+// The rows x0[j*m + i] = s[i*r + j] are gathered in one pass over s,
+// MR_GATHER_CHUNK columns per task. Each radix has its own call, so
+// that the loop over the rows is unrolled.
+
+#define MR_GATHER_CHUNK 1024
+
+static INLINE void mrGatherRows(real *d, const real *s, const int r, int m, int i0, int i1) {
+  for(int i=i0;i<i1;i++) {
+    for(int j=0;j<r;j++) {
+      d[(j*m+i)*2+0] = s[(i*r+j)*2+0];
+      d[(j*m+i)*2+1] = s[(i*r+j)*2+1];
+    }
+  }
+}
+
+static void mixedRadixGatherTask(void *ptr, int t) {
+  MixedRadixArg *a = (MixedRadixArg *)ptr;
+  const int r = a->p->radix, m = a->p->length / r;
+  const int i0 = t * MR_GATHER_CHUNK, i1 = MIN(i0 + MR_GATHER_CHUNK, m);
+
+  switch(r) {
+  case 3: mrGatherRows(a->d, a->s, 3, m, i0, i1); break;
+  case 5: mrGatherRows(a->d, a->s, 5, m, i0, i1); break;
+  default: mrGatherRows(a->d, a->s, 7, m, i0, i1); break;
+  }
+}
+
+static void executeMixedRadix(SleefDFT *p, const real *s, real *d, real *ws) {
+  const int r = p->radix, m = p->length / r;
+  real *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws;
+    x1 = ws + wsRound(2 * p->length);
+    subws = ws + 2 * wsRound(2 * p->length);
+  } else {
+    const int tn = Executor_slot();
+    x0 = (real *)p->mrBuf0[tn];
+    x1 = (real *)p->mrBuf1[tn];
+  }
+
+  if (p->instSub == NULL && p->mrHasScale) {
+    const real scale = (real)p->mrScale;
+    for(int j=0;j<r;j++) {
+      x0[j*2+0] = s[j*2+0] * scale;
+      x0[j*2+1] = s[j*2+1] * scale;
+    }
+  } else {
+    MixedRadixArg g = { p, x0, s, (m + MR_GATHER_CHUNK - 1) / MR_GATHER_CHUNK };
+    if ((p->mrConfig & CONFIG_MT) != 0) {
+      Executor_parallelFor(mixedRadixGatherTask, &g, g.nTask, MIN(p->mrNThread, Executor_threadCount()));
+    } else {
+      for(int t=0;t<g.nTask;t++) mixedRadixGatherTask(&g, t);
+    }
+  }
+
+  if (p->instSub != NULL) {
+    for(int j=0;j<r;j++) executeWS(p->instSub, &x0[j*m*2], &x1[j*m*2], subws);
+  } else {
+    real *t = x0; x0 = x1; x1 = t;
+  }
+
+  if (p->mrIsa == -1) {
+    mrButScalar(p, d, x1, 0, m);
+  } else {
+    MixedRadixArg a = { p, d, x1, (p->mrConfig & CONFIG_MT) != 0 ? MIN(p->mrNThread, Executor_threadCount()) : 1 };
+    Executor_run(mixedRadixTask, &a, a.nTask);
+    if (p->mrVec < m) mrButScalar(p, d, x1, p->mrVec, m);
+  }
+}
+
+// Bluestein planner
+
+// Other lengths are computed as a convolution with the chirp
+// w[k] = exp(-pi i k^2 / n), which is carried out with power-of-two
+// plans of length m >= 2n-1. The transform of the chirp is computed
+// once at initialization, and is prescaled by 1/m.
+
+// Returns a q mod 2 for an integer q. The part of a that is a multiple
+// of 2^-62 is multiplied modulo 2 in integers, so that the phases of
+// the chirp-z chirps keep their accuracy for large q.
+
+static double phaseMod2(double a, uint64_t q) {
+  if (a < 0) return -phaseMod2(-a, q);
+  a = fmod(a, 2);
+  const uint64_t u = (uint64_t)ldexp(a, 62);
+  double r = a - ldexp((double)u, -62);
+  double x = ldexp((double)((u * q) & ((UINT64_C(1) << 63) - 1)), -62) + r * (double)q;
+  x -= 2 * floor(x / 2);
+  return x > 1 ? x - 2 : x;
+}
+
+// Stores exp(pi i phase) to c. The phase is reduced to [-1, 1) in
+// double before it is passed to SINCOSPI. Shared by the Bluestein and
+// chirp-z planners.
+
+static void chirpAt(real *c, double phase) {
+  sc_t sc = SINCOSPI((real)(phase - 2 * floor(phase / 2 + 0.5)));
+  c[0] = sc.y;
+  c[1] = sc.x;
+}
+
+static SleefDFT *initBluestein(uint32_t n, const real *in, real *out, uint64_t mode) {
+  uint64_t m = 1;
+  while(m < 2 * (uint64_t)n - 1) m <<= 1;
+
+  if (n < 2 || m > (UINT64_C(1) << MAXLOG2LEN) || m > UINT32_MAX) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported length : %u\n", (unsigned)n);
+    return NULL;
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICBS;
+  p->baseTypeID = BASETYPEID;
+  p->in = (const void *)in;
+  p->out = (void *)out;
+  p->mode = mode;
+  p->bsLength = n;
+  p->bsLength2 = m;
+
+  uint64_t mode1D = mode & ~(uint64_t)(SLEEF_MODE_BACKWARD | SLEEF_MODE_ALT);
+
+  p->instF = INIT(m, NULL, NULL, mode1D);
+  p->instB = INIT(m, NULL, NULL, mode1D | SLEEF_MODE_BACKWARD);
+
+  if (p->instF == NULL || p->instB == NULL) {
+    if (p->instF != NULL) SleefDFT_dispose(p->instF);
+    if (p->instB != NULL) SleefDFT_dispose(p->instB);
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  int backward = ((mode & SLEEF_MODE_BACKWARD) != 0) != ((mode & SLEEF_MODE_ALT) != 0);
+
+  real *chirp = (real *)Sleef_malloc(sizeof(real) * 2 * n);
+  for(uint32_t k=0;k<n;k++) {
+    uint64_t q = ((uint64_t)k * k) % (2 * (uint64_t)n);
+    chirpAt(&chirp[k*2], (backward ? 1 : -1) * (double)q / (double)n);
+  }
+  p->bsChirp = chirp;
+
+  real *kernel = (real *)Sleef_malloc(sizeof(real) * 2 * m);
+  real *t = (real *)memset(Sleef_malloc(sizeof(real) * 2 * m), 0, sizeof(real) * 2 * m);
+  for(uint32_t k=0;k<n;k++) {
+    t[k*2+0] =  chirp[k*2+0];
+    t[k*2+1] = -chirp[k*2+1];
+    if (k == 0) continue;
+    t[(m-k)*2+0] =  chirp[k*2+0];
+    t[(m-k)*2+1] = -chirp[k*2+1];
+  }
+  EXECUTE(p->instF, t, kernel);
+  for(uint32_t k=0;k<2*m;k++) kernel[k] *= (real)1.0 / m;
+  Sleef_free(t);
+  p->bsKernel = kernel;
+
+  p->bsNThread = Executor_slotCount();
+
+  p->bsBuf0 = allocBuffers(p->bsNThread, 2 * m, mode);
+  p->bsBuf1 = allocBuffers(p->bsNThread, 2 * m, mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Bluestein : %u -> %u\n", (unsigned)n, (unsigned)m);
+
+  return p;
+}
+
+static void executeBluestein(SleefDFT *p, const real *s, real *d, real *ws) {
+  const uint32_t n = p->bsLength, m = p->bsLength2;
+  const real *chirp = (const real *)p->bsChirp, *kernel = (const real *)p->bsKernel;
+  real *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws;
+    x1 = ws + wsRound(2 * m);
+    subws = ws + 2 * wsRound(2 * m);
+  } else {
+    const int tn = Executor_slot();
+    x0 = (real *)p->bsBuf0[tn];
+    x1 = (real *)p->bsBuf1[tn];
+  }
+
+  for(uint32_t k=0;k<n;k++) {
+    real xr = s[k*2+0], xi = s[k*2+1];
+    x0[k*2+0] = xr * chirp[k*2+0] - xi * chirp[k*2+1];
+    x0[k*2+1] = xr * chirp[k*2+1] + xi * chirp[k*2+0];
+  }
+  memset(&x0[n*2], 0, sizeof(real) * 2 * (m - n));
+
+  executeWS(p->instF, x0, x1, subws);
+
+  for(uint32_t k=0;k<m;k++) {
+    real xr = x1[k*2+0], xi = x1[k*2+1];
+    x1[k*2+0] = xr * kernel[k*2+0] - xi * kernel[k*2+1];
+    x1[k*2+1] = xr * kernel[k*2+1] + xi * kernel[k*2+0];
+  }
+
+  executeWS(p->instB, x1, x0, subws);
+
+  for(uint32_t k=0;k<n;k++) {
+    real xr = x0[k*2+0], xi = x0[k*2+1];
+    d[k*2+0] = xr * chirp[k*2+0] - xi * chirp[k*2+1];
+    d[k*2+1] = xr * chirp[k*2+1] + xi * chirp[k*2+0];
+  }
+}
+
+// Real-to-real planner
+
+// DCT-II and DST-II of length n are computed with one n-point real
+// transform (Makhoul's algorithm). The input is permuted into even
+// samples followed by reversed odd samples, and a single twiddle stage
+// on the half spectrum produces two outputs per complex bin. DCT-III
+// and DST-III run the same stages backward. A DST is a DCT with
+// alternating input signs and reversed output order. The definitions
+// follow FFTW's REDFT10/REDFT01/RODFT10/RODFT01, so a type-III
+// transform of a type-II transform multiplies the input by 2n.
+
+static SleefDFT *initR2R(uint32_t n, const real *in, real *out, uint64_t mode) {
+  if ((n & (n - 1)) != 0 || n < 2 ||
+      (mode & (SLEEF_MODE_DCT | SLEEF_MODE_DST)) == (SLEEF_MODE_DCT | SLEEF_MODE_DST)) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported real-to-real transform : %u\n", (unsigned)n);
+    return NULL;
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICRR;
+  p->baseTypeID = BASETYPEID;
+  p->in = (const void *)in;
+  p->out = (void *)out;
+  p->mode = mode;
+  p->rrLength = n;
+
+  uint64_t mode1D = (mode & ~(uint64_t)(SLEEF_MODE_DCT | SLEEF_MODE_DST | SLEEF_MODE_ALT)) | SLEEF_MODE_REAL;
+
+  p->instReal = INIT(n, NULL, NULL, mode1D);
+
+  if (p->instReal == NULL) {
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  // The twiddles tw[k] = exp(-i pi k / 2n), k = 0 .. n/2, are
+  // multiplied by the real postprocessing of the forward transform,
+  // or by the real preprocessing of the backward transform, given as
+  // weights in specTbl. The forward weights are 2 tw[k] and the
+  // backward weights are conj(tw[k]). Element n/4 of the half spectrum
+  // is stored conjugated by the forward postprocessing. The DC and
+  // Nyquist components share the first element, and only the real
+  // part of the twiddled Nyquist component is used. Plans with n <= 4
+  // have no real pre/postprocessing, and the twiddles are then
+  // applied by executeR2R from rrTbl.
+
+  const int backward = (mode & SLEEF_MODE_BACKWARD) != 0;
+  const uint32_t h = n/2;
+
+  if (p->instReal->magic == MAGIC && p->instReal->log2len > 1) {
+    real *w = (real *)Sleef_malloc(sizeof(real) * 2 * n);
+    for(uint32_t k=0;k<h;k++) {
+      sc_t sc = SINCOSPI((real)k / (real)(2 * n));
+      real c = backward ? sc.y : 2 * sc.y, t = backward ? sc.x : -2 * sc.x;
+      if (!backward && k == h/2) t = -t;
+      w[k*2+0] = w[k*2+1] = c;
+      w[n+k*2+0] = w[n+k*2+1] = t;
+    }
+
+    // tw[n/2] = exp(-i pi / 4). The forward Nyquist component V[n/2]
+    // is real, and the backward one is X[n/2] - i X[n/2], so the real
+    // part of the twiddled component is sqrt(2) V[n/2] or sqrt(2) X[n/2].
+    w[1] = (real)1.4142135623730950488016887242096980785697L;
+    p->instReal->specTbl = w;
+  } else {
+    real *tbl = (real *)Sleef_malloc(sizeof(real) * 2 * (h+1));
+    for(uint32_t k=0;k<=h;k++) {
+      sc_t sc = SINCOSPI((real)k / (real)(2 * n));
+      tbl[k*2+0] =  sc.y;
+      tbl[k*2+1] = -sc.x;
+    }
+    p->rrTbl = tbl;
+  }
+
+  p->rrNThread = Executor_slotCount();
+
+  p->rrBuf0 = allocBuffers(p->rrNThread, n + 2, mode);
+  p->rrBuf1 = allocBuffers(p->rrNThread, n + 2, mode);
+
+  return p;
+}
+
+static void executeR2R(SleefDFT *p, const real *s, real *d, real *ws) {
+  const real *tbl = (const real *)p->rrTbl;
+  const int n = p->rrLength;
+  real *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws;
+    x1 = ws + wsRound(n + 2);
+    subws = ws + 2 * wsRound(n + 2);
+  } else {
+    const int tn = Executor_slot();
+    x0 = (real *)p->rrBuf0[tn];
+    x1 = (real *)p->rrBuf1[tn];
+  }
+  const int dst = (p->mode & SLEEF_MODE_DST) != 0;
+  const real sgn = dst ? -1 : 1;
+
+  if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
+    for(int i=0;i<n/2;i++) {
+      x0[i      ] =       s[2*i+0];
+      x0[n-1-i  ] = sgn * s[2*i+1];
+    }
+
+    executeWS(p->instReal, x0, x1, subws);
+
+    // (a + ib) = 2 tw[k] V[k], X[k] = a, X[n-k] = -b
+
+    if (tbl != NULL) {
+      for(int k=0;k<=n/2;k++) {
+	real c = tbl[k*2+0], t = tbl[k*2+1], vr = x1[k*2+0], vi = x1[k*2+1];
+	x1[k*2+0] = 2 * (c * vr - t * vi);
+	x1[k*2+1] = 2 * (c * vi + t * vr);
+      }
+    }
+
+    for(int k=1;k<n/2;k++) d[dst ? k-1 : n-k] = -x1[k*2+1];
+    for(int k=0;k<=n/2;k++) d[dst ? n-1-k : k] = x1[k*2+0];
+  } else {
+    // V[k] = conj(tw[k]) (X[k] - i X[n-k]), X[n] = 0
+
+#define R2R_IN(k) ((k) == n ? 0 : s[dst ? n-1-(k) : (k)])
+
+    x0[0] = R2R_IN(0);
+    x0[1] = 0;
+
+    for(int k=1;k<=n/2;k++) {
+      x0[k*2+0] =  R2R_IN(k);
+      x0[k*2+1] = -R2R_IN(n-k);
+    }
+
+#undef R2R_IN
+
+    if (tbl != NULL) {
+      for(int k=1;k<=n/2;k++) {
+	real c = tbl[k*2+0], t = tbl[k*2+1], xr = x0[k*2+0], xi = x0[k*2+1];
+	x0[k*2+0] = c * xr + t * xi;
+	x0[k*2+1] = c * xi - t * xr;
+      }
+    }
+
+    executeWS(p->instReal, x0, x1, subws);
+
+    for(int i=0;i<n/2;i++) {
+      d[2*i+0] =       x1[i    ];
+      d[2*i+1] = sgn * x1[n-1-i];
+    }
+  }
+}
+
+// Six-step planner
+
+// With SLEEF_MODE_LARGE, a complex power-of-two length n = n1 * n2 is
+// transformed as a 2D transform of the input viewed as n1 rows of n2
+// elements, with twiddle factors between the two passes (Bailey's
+// six-step algorithm). The transposes of the algorithm are folded
+// into panels, as in the panel strategy for 2D transforms. The first
+// pass gathers a panel of columns of the input, transforms them with
+// an n1-point plan, multiplies the twiddles and writes them as rows of
+// the output. The second pass transforms the columns of the output
+// in place with an n2-point plan. Each pass reads and writes every
+// element once, in segments of a whole panel width, and no buffer of
+// n elements is allocated, so the arrays may be memory-mapped files.
+// The twiddle w^m is the product of w^(m & ~mask) and w^(m & mask),
+// which are looked up in two tables of about sqrt(n) elements.
+
+// Makes the two tables of the twiddles w^m of a length n, for
+// 0 <= m < n. lo holds w^m for m < 2^log2lo, and hi holds w^m for the
+// multiples of 2^log2lo.
+
+static void makeTwiddleTables(uint32_t n, int log2lo, int backward, real **plo, real **phi) {
+  const uint32_t nlo = 1 << log2lo, nhi = n >> log2lo;
+  const real sign = backward ? 2 : -2;
+  real *lo = (real *)Sleef_malloc(sizeof(real) * 2 * nlo);
+  real *hi = (real *)Sleef_malloc(sizeof(real) * 2 * nhi);
+
+  for(uint32_t i=0;i<nlo;i++) {
+    sc_t sc = SINCOSPI(sign * (real)i / (real)n);
+    lo[i*2+0] = sc.y;
+    lo[i*2+1] = sc.x;
+  }
+
+  for(uint32_t i=0;i<nhi;i++) {
+    sc_t sc = SINCOSPI(sign * (real)((uint64_t)i << log2lo) / (real)n);
+    hi[i*2+0] = sc.y;
+    hi[i*2+1] = sc.x;
+  }
+
+  *plo = lo;
+  *phi = hi;
+}
+
+// Multiplies the complex number at x by w^m
+
+static void twiddleAt(real *x, const real *lo, const real *hi, int log2lo, uint64_t m) {
+  const real *th = &hi[(m >> log2lo)*2], *tl = &lo[(m & ((UINT64_C(1) << log2lo) - 1))*2];
+  const real tr = th[0] * tl[0] - th[1] * tl[1], ti = th[0] * tl[1] + th[1] * tl[0];
+  const real xr = x[0], xi = x[1];
+  x[0] = xr * tr - xi * ti;
+  x[1] = xr * ti + xi * tr;
+}
+
+#define LARGE_MIN_LOG2LEN (2 * LOG2BS)
+#define LARGE_PANEL_SIZE (1 << 20)
+#define LARGE_PAGE_SIZE 4096
+
+static SleefDFT *initLarge(uint32_t n, uint64_t mode) {
+  const int log2n = ilog2(n), log2n1 = log2n / 2, log2lo = (log2n + 1) / 2;
+  const uint32_t n1 = 1 << log2n1, n2 = n >> log2n1;
+  const int backward = ((mode & SLEEF_MODE_BACKWARD) != 0) != ((mode & SLEEF_MODE_ALT) != 0);
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICLG;
+  p->baseTypeID = BASETYPEID;
+  p->mode = mode;
+  p->lgLength = n;
+  p->lgLen1 = n1;
+  p->lgLen2 = n2;
+  p->lgLog2Lo = log2lo;
+  p->lgNThread = Executor_slotCount();
+  p->lgMT = (mode & SLEEF_MODE_NO_MT) == 0;
+
+  // A panel is as wide as a page, so that each segment of a row that a
+  // pass reads or writes covers whole pages
+
+  p->lgPanel = MIN((uint32_t)(LARGE_PAGE_SIZE / (2 * sizeof(real))), n1);
+
+  uint64_t mode1D = (mode & ~(uint64_t)(SLEEF_MODE_BACKWARD | SLEEF_MODE_ALT | SLEEF_MODE_LARGE)) |
+    SLEEF_MODE_NO_MT | (backward ? SLEEF_MODE_BACKWARD : 0);
+
+  p->instL1 = INIT(n1, NULL, NULL, mode1D);
+  p->instL2 = n2 == n1 ? p->instL1 : INIT(n2, NULL, NULL, mode1D);
+
+  if (p->instL1 == NULL || p->instL2 == NULL) {
+    if (p->instL2 != NULL && p->instL2 != p->instL1) SleefDFT_dispose(p->instL2);
+    if (p->instL1 != NULL) SleefDFT_dispose(p->instL1);
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  real *lo, *hi;
+  makeTwiddleTables(n, log2lo, backward, &lo, &hi);
+  p->lgTwLo = lo;
+  p->lgTwHi = hi;
+
+  // The twiddles are multiplied by the twiddleRow kernel, which
+  // processes a vector at a time
+
+  int bestPriority = -1;
+  p->lgIsa = -1;
+
+  for(int i=0;i<ISAMAX;i++) {
+    if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY)) {
+      bestPriority = (*GETINT[i])(GETINT_DFTPRIORITY);
+      p->lgIsa = i;
+    }
+  }
+
+  if (p->lgIsa != -1 && n1 % (*GETINT[p->lgIsa])(GETINT_VECWIDTH) != 0) p->lgIsa = -1;
+
+  p->lgBuf = allocBuffers(p->lgNThread, 2 * (size_t)p->lgPanel * n2, mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Six-step : %u x %u, panel %u\n", (unsigned)n1, (unsigned)n2, (unsigned)p->lgPanel);
+
+  return p;
+}
+
+static size_t largeWsSlice(SleefDFT *p) {
+  return wsRound(2 * (size_t)p->lgPanel * p->lgLen2) + MAX(wsSize(p->instL1), wsSize(p->instL2));
+}
+
+// Copies the columns c0 <= c < c0 + w of the rows x cols matrix s into
+// the rows of t, BS rows of s at a time. rows, cols, c0 and w are
+// multiples of BS.
+
+static void gatherColumns(real *t, const real *s, size_t rows, size_t cols, size_t c0, size_t w) {
+  for(size_t r0=0;r0<rows;r0+=BS) {
+    for(size_t c=0;c<w;c+=BS) transposeBlock(&t[(c*rows+r0)*2], rows, &s[(r0*cols+c0+c)*2], cols);
+  }
+}
+
+static void scatterColumns(real *d, const real *t, size_t rows, size_t cols, size_t c0, size_t w) {
+  for(size_t r0=0;r0<rows;r0+=BS) {
+    for(size_t c=0;c<w;c+=BS) transposeBlock(&d[(r0*cols+c0+c)*2], cols, &t[(c*rows+r0)*2], rows);
+  }
+}
+
+typedef struct LargeArg {
+  SleefDFT *p;
+  const real *s;
+  real *d, *ws;
+  int pass;
+} LargeArg;
+
+static void largeTask(void *ptr, int i) {
+  LargeArg *a = (LargeArg *)ptr;
+  SleefDFT *p = a->p;
+  const int tn = Executor_slot();
+  const size_t n1 = p->lgLen1, n2 = p->lgLen2, w = p->lgPanel, c0 = (size_t)i * w;
+  real *panel, *subws = NULL;
+
+  if (a->ws != NULL) {
+    panel = a->ws + (p->lgMT ? tn : 0) * largeWsSlice(p);
+    subws = panel + wsRound(2 * w * n2);
+  } else {
+    panel = (real *)p->lgBuf[tn];
+  }
+
+  if (a->pass == 0) {
+    // Columns j2 of the n1 x n2 input, twiddled by w^(j2 k1), become
+    // rows of the n2 x n1 output
+
+    const real *lo = (const real *)p->lgTwLo, *hi = (const real *)p->lgTwHi;
+
+    gatherColumns(panel, a->s, n1, n2, c0, w);
+
+    for(size_t c=0;c<w;c++) {
+      real *row = &panel[c*n1*2];
+      executeWS(p->instL1, row, row, subws);
+
+      const uint64_t j2 = c0 + c;
+      if (p->lgIsa != -1) {
+	(*TWIDDLEROW[p->lgIsa])(row, lo, hi, p->lgLog2Lo, j2, (int)n1);
+      } else {
+	for(size_t k1=1;k1<n1;k1++) twiddleAt(&row[k1*2], lo, hi, p->lgLog2Lo, j2 * k1);
+      }
+
+      memcpy(&a->d[(j2*n1)*2], row, sizeof(real) * 2 * n1);
+    }
+  } else {
+    // Columns k1 of the n2 x n1 output are transformed in place
+
+    gatherColumns(panel, a->d, n2, n1, c0, w);
+    for(size_t c=0;c<w;c++) executeWS(p->instL2, &panel[c*n2*2], &panel[c*n2*2], subws);
+    scatterColumns(a->d, panel, n2, n1, c0, w);
+  }
+}
+
+// The first pass writes rows of the output over columns of the input
+// that other panels have yet to read, so a transform in place is
+// refused
+static void executeLarge(SleefDFT *p, const real *s, real *d, real *ws) {
+  if (s == d) {
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("SLEEF_MODE_LARGE plans cannot be executed in place\n");
+    return;
+  }
+
+  const int nth = p->lgMT ? MIN(p->lgNThread, Executor_threadCount()) : 1;
+  const int nTask[2] = { (int)(p->lgLen2 / p->lgPanel), (int)(p->lgLen1 / p->lgPanel) };
+
+  for(int pass=0;pass<2;pass++) {
+    LargeArg a = { p, s, d, ws, pass };
+    if (nth > 1) {
+      Executor_parallelFor(largeTask, &a, nTask[pass], nth);
+    } else {
+      for(int i=0;i<nTask[pass];i++) largeTask(&a, i);
+    }
+  }
+}
+
+// SLEEF_MODE_REALTIME plans execute on a single thread along a fixed
+// path, so execution never allocates, locks or forks a team. Scratch
+// has to be owned by the plan, hence NO_SCRATCH is rejected.
+
+static int realtimeMode(uint64_t *mode) {
+  if ((*mode & SLEEF_MODE_REALTIME) == 0) return 1;
+
+  if ((*mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    if ((*mode & SLEEF_MODE_VERBOSE) != 0) printf("SLEEF_MODE_REALTIME cannot be combined with SLEEF_MODE_NO_SCRATCH\n");
+    return 0;
+  }
+
+  *mode = (*mode | SLEEF_MODE_NO_MT) & ~(uint64_t)SLEEF_MODE_ASYNC;
+  return 1;
+}
+
+// Implementation of SleefDFT_*_init1d
+
+static SleefDFT *initSplit(int rank, uint32_t n0, uint32_t n1, const real *in, real *out, uint64_t mode);
+static SleefDFT *initFormat(int rank, uint32_t n0, uint32_t n1, const void *in, void *out, uint64_t mode);
+
+EXPORT SleefDFT *INIT(uint32_t n, const real *in, real *out, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  if ((mode & (SLEEF_MODE_FORMAT_IN | SLEEF_MODE_FORMAT_OUT)) != 0) return initFormat(1, n, 1, in, out, mode);
+  if ((mode & (SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT)) != 0) return initSplit(1, n, 1, in, out, mode);
+  if ((mode & (SLEEF_MODE_DCT | SLEEF_MODE_DST)) != 0) return initR2R(n, in, out, mode);
+
+  if ((n & (n - 1)) != 0) {
+    if ((mode & SLEEF_MODE_REAL) == 0) {
+      if (isSmoothLength(n)) return initMixedRadix(n, in, out, mode);
+      return initBluestein(n, in, out, mode);
+    }
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported length : %u\n", (unsigned)n);
+    return NULL;
+  }
+
+  if ((mode & (SLEEF_MODE_LARGE | SLEEF_MODE_REAL)) == SLEEF_MODE_LARGE && n >= (UINT32_C(1) << LARGE_MIN_LOG2LEN)) {
+    return initLarge(n, mode);
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGIC;
+  p->baseTypeID = BASETYPEID;
+  p->in = (const void *)in;
+  p->out = (void *)out;
   
-  p->perm = (uint32_t **)calloc(sizeof(uint32_t *), p->log2len+1);
-  for(int level = p->log2len;level >= 1;level--) {
-    p->perm[level] = (uint32_t *)Sleef_malloc(sizeof(uint32_t) * ((1 << p->log2len) + 8));
+  // Mode
+
+  p->mode = mode;
+
+  if ((p->mode & SLEEF_MODE_NO_MT) == 0) {
+    p->mode2 |= SLEEF_MODE2_MT1D;
   }
+  
+  if ((mode & SLEEF_MODE_REAL) != 0) n /= 2;
+  p->log2len = ilog2(n);
+
+  if (p->log2len <= 1) return p;
+
+  if ((mode & SLEEF_MODE_ALT) != 0) p->mode = mode = mode ^ SLEEF_MODE_BACKWARD;
+
+  p->nThread = Executor_slotCount();
+  if (Executor_threadCount() == 1) p->mode2 &= ~SLEEF_MODE2_MT1D;
+
+  // ISA availability
+
+  int bestPriority = -1;
+  p->isa = -1;
+
+  for(int i=0;i<ISAMAX;i++) {
+    if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY) && n >= (uint32_t)((*GETINT[i])(GETINT_VECWIDTH) * (*GETINT[i])(GETINT_VECWIDTH))) {
+      bestPriority = (*GETINT[i])(GETINT_DFTPRIORITY);
+      p->isa = i;
+    }
+  }
+
+  if (p->isa == -1) {
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("ISA not available\n");
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  // Tables
+  
+  p->perm = (uint32_t **)calloc(sizeof(uint32_t *), p->log2len+1);
+
+  p->x0 = malloc(sizeof(real *) * p->nThread);
+  p->x1 = malloc(sizeof(real *) * p->nThread);
+
+  for(int i=0;i<p->nThread;i++) {
+    p->x0[i] = (real *)Sleef_malloc(sizeof(real) * 2 * n);
+    p->x1[i] = (real *)Sleef_malloc(sizeof(real) * 2 * n);
+  }
+  
+  if ((mode & SLEEF_MODE_REAL) != 0) {
+    p->rtCoef0 = (real *)Sleef_malloc(sizeof(real) * n);
+    p->rtCoef1 = (real *)Sleef_malloc(sizeof(real) * n);
+
+    if ((mode & SLEEF_MODE_BACKWARD) == 0) {
+      for(uint32_t i=0;i<n/2;i++) {
+	sc_t sc = SINCOSPI(i*((real)-1.0/n));
+	((real *)p->rtCoef0)[i*2+0] = ((real *)p->rtCoef0)[i*2+1] = (real)0.5 - (real)0.5 * sc.x;
+	((real *)p->rtCoef1)[i*2+0] = ((real *)p->rtCoef1)[i*2+1] = (real)0.5*sc.y;
+      }
+    } else {
+      for(uint32_t i=0;i<n/2;i++) {
+	sc_t sc = SINCOSPI(i*((real)-1.0/n));
+	((real *)p->rtCoef0)[i*2+0] = ((real *)p->rtCoef0)[i*2+1] = (real)0.5 + (real)0.5 * sc.x;
+	((real *)p->rtCoef1)[i*2+0] = ((real *)p->rtCoef1)[i*2+1] = (real)0.5*sc.y;
+      }
+    }
+  }
+
+  // Measure
+  
+  p->vecwidth = (*GETINT[p->isa])(GETINT_VECWIDTH);
+  p->log2vecwidth = ilog2(p->vecwidth);
+
+  // Twiddle tables are borrowed from the shared cache when they are
+  // measured, and only those on the chosen path are kept
+
+  allocTables(p);
+
+  // With SLEEF_MODE_ASYNC, the path is estimated here and measured in
+  // the background
+
+#ifdef ENABLE_PTHREAD
+  if ((mode & SLEEF_MODE_ASYNC) != 0) p->mode2 |= SLEEF_MODE2_DEFER;
+#endif
+
+  if (!measure(p, (mode & SLEEF_MODE_DEBUG))) {
+    // Fall back to the first ISA
+    freeTables(p);
+    p->isa = 0;
+
+    p->vecwidth = (*GETINT[p->isa])(GETINT_VECWIDTH);
+    p->log2vecwidth = ilog2(p->vecwidth);
+
+    allocTables(p);
+
+    if (!measure(p, (mode & SLEEF_MODE_DEBUG))) {
+      if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("Suitable ISA not found. This should not happen.\n");
+      return NULL;
+    }
+  }
+
+  BINDPATH(p);
+  
+  if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("ISA : %s %d bit %s\n", (char *)(*GETPTR[p->isa])(0), (int)(GETINT[p->isa](GETINT_VECWIDTH) * sizeof(real) * 16), BASETYPESTRING);
+
+  // The buffers are only needed for planning with SLEEF_MODE_NO_SCRATCH
+
+  if ((mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    for(int i=0;i<p->nThread;i++) {
+      Sleef_free(p->x0[i]);
+      Sleef_free(p->x1[i]);
+    }
+    free(p->x0);
+    free(p->x1);
+    p->x0 = p->x1 = NULL;
+  }
+
+  p->mode2 &= ~SLEEF_MODE2_DEFER;
+  if ((p->mode2 & SLEEF_MODE2_REFINE) != 0) startPlanner(p);
+
+  return p;
+}
+
+// Implementation of SleefDFT_*_init2d
+
+static SleefDFT *initReal2D(uint32_t vlen, uint32_t hlen, const real *in, real *out, uint64_t mode);
+
+EXPORT SleefDFT *INIT2D(uint32_t vlen, uint32_t hlen, const real *in, real *out, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  if ((mode & (SLEEF_MODE_FORMAT_IN | SLEEF_MODE_FORMAT_OUT)) != 0) return initFormat(2, vlen, hlen, in, out, mode);
+  if ((mode & (SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT)) != 0) return initSplit(2, vlen, hlen, in, out, mode);
+  if ((mode & SLEEF_MODE_REAL) != 0) return initReal2D(vlen, hlen, in, out, mode);
+
+  if ((vlen & (vlen - 1)) != 0 || (hlen & (hlen - 1)) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported size : %u x %u\n", (unsigned)vlen, (unsigned)hlen);
+    return NULL;
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGIC2D;
+  p->mode = mode;
+  p->baseTypeID = BASETYPEID;
+  p->in = in;
+  p->out = out;
+  p->hlen = hlen;
+  p->log2hlen = ilog2(hlen);
+  p->vlen = vlen;
+  p->log2vlen = ilog2(vlen);
+  
+  uint64_t mode1D = mode;
+  mode1D |= SLEEF_MODE_NO_MT;
+
+  if ((mode & SLEEF_MODE_NO_MT) == 0) p->mode3 |= SLEEF_MODE3_MT2D;
+  
+  p->instH = p->instV = INIT(hlen, NULL, NULL, mode1D);
+  if (hlen != vlen) p->instV = INIT(vlen, NULL, NULL, mode1D);
+
+  p->tNThread = Executor_slotCount();
+
+  p->tBuf = (void *)Sleef_malloc(sizeof(real)*2*hlen*vlen);
+  if (panel2DAvailable(p)) p->tPanel = allocBuffers(p->tNThread, 2 * BS * MAX(hlen, vlen), mode);
+
+  measureTranspose(p);
+
+  if ((mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    Sleef_free(p->tBuf);
+    p->tBuf = NULL;
+  }
+
+  return p;
+}
+
+// N-D planner
+
+// An N-D transform is computed by one pass of 1D transforms per axis.
+// Two strategies are available. The transpose strategy transforms the
+// contiguous last axis and then rotates the axes with a blocked
+// transpose, so that every pass reads contiguous rows. It needs
+// power-of-two sizes. The strided strategy transforms each axis in
+// place, gathering BS neighbouring lines at a time into per-thread
+// buffers so that every cache line fetched is used BS times.
+
+#define LINE_ALIGNMENT 256
+
+// Transforms O x L x S complex elements along the middle axis of
+// length L. Each line buffer holds BS rows of pitch complex elements.
+// The lines are spread over nth threads. With a workspace, thread tn
+// uses the tn-th slice of wsSlice reals, which starts with the two
+// line buffers.
+
+typedef struct StridedArg {
+  SleefDFT *inst;
+  const real *s;
+  real *d;
+  uint32_t L, S;
+  int pitch, nblk, nth;
+  void **line0, **line1;
+  real *ws;
+  size_t wsSlice;
+} StridedArg;
+
+static void stridedTask(void *ptr, int t) {
+  StridedArg *a = (StridedArg *)ptr;
+  const real *s = a->s;
+  real *d = a->d;
+  const uint32_t L = a->L, S = a->S;
+  const int tn = Executor_slot();
+  real *x0, *x1, *subws = NULL;
+
+  if (a->ws != NULL) {
+    x0 = a->ws + (a->nth > 1 ? tn : 0) * a->wsSlice;
+    x1 = x0 + wsRound(2 * BS * a->pitch);
+    subws = x1 + wsRound(2 * BS * a->pitch);
+  } else {
+    x0 = (real *)a->line0[tn];
+    x1 = (real *)a->line1[tn];
+  }
+
+  const uint32_t o = t / a->nblk, i0 = (t % a->nblk) * BS;
+  const int nb = S - i0 < BS ? S - i0 : BS;
+
+  if (S == 1) {
+    const real *sr = &s[(size_t)o * L * 2];
+    real *dr = &d[(size_t)o * L * 2];
+
+    if (((uintptr_t)sr % LINE_ALIGNMENT) == 0 && ((uintptr_t)dr % LINE_ALIGNMENT) == 0) {
+      executeWS(a->inst, sr, dr, subws);
+    } else {
+      memcpy(x0, sr, sizeof(real) * 2 * L);
+      executeWS(a->inst, x0, x1, subws);
+      memcpy(dr, x1, sizeof(real) * 2 * L);
+    }
+    return;
+  }
+
+  for(uint32_t j=0;j<L;j++) {
+    const real *sj = &s[(((size_t)o * L + j) * S + i0) * 2];
+    for(int b=0;b<nb;b++) {
+      x0[(b*a->pitch+j)*2+0] = sj[b*2+0];
+      x0[(b*a->pitch+j)*2+1] = sj[b*2+1];
+    }
+  }
+
+  for(int b=0;b<nb;b++) executeWS(a->inst, &x0[b*a->pitch*2], &x1[b*a->pitch*2], subws);
+
+  for(uint32_t j=0;j<L;j++) {
+    real *dj = &d[(((size_t)o * L + j) * S + i0) * 2];
+    for(int b=0;b<nb;b++) {
+      dj[b*2+0] = x1[(b*a->pitch+j)*2+0];
+      dj[b*2+1] = x1[(b*a->pitch+j)*2+1];
+    }
+  }
+}
+
+static void stridedPass(SleefDFT *inst, const real *s, real *d, uint32_t L, uint32_t S, uint32_t O,
+			int pitch, void **line0, void **line1, real *ws, size_t wsSlice, int nth) {
+  const int nblk = (S + BS - 1) / BS;
+  StridedArg a = { inst, s, d, L, S, pitch, nblk, nth, line0, line1, ws, wsSlice };
+  Executor_parallelFor(stridedTask, &a, O * nblk, MIN(nth, Executor_threadCount()));
+}
+
+// Transforms n contiguous rows of len complex elements, spread over
+// nth threads. With a workspace, thread tn uses ws + tn * wsSlice.
+
+typedef struct RowsArg {
+  SleefDFT *inst;
+  const real *s;
+  real *d;
+  size_t len;
+  real *ws;
+  size_t wsSlice;
+} RowsArg;
+
+static void rowTask(void *ptr, int y) {
+  RowsArg *a = (RowsArg *)ptr;
+  executeWS(a->inst, &a->s[a->len*2*y], &a->d[a->len*2*y], a->ws == NULL ? NULL : a->ws + Executor_slot() * a->wsSlice);
+}
+
+static void rowsMT(SleefDFT *inst, const real *s, real *d, size_t len, int n, real *ws, size_t wsSlice, int nth) {
+  RowsArg a = { inst, s, d, len, ws, wsSlice };
+  Executor_parallelFor(rowTask, &a, n, MIN(nth, Executor_threadCount()));
+}
+
+// 2D execution
+
+// The separate strategy transforms all rows, transposes the whole
+// array, transforms all rows again and transposes back. That is four
+// passes over the array. The panel strategy transforms BS rows at a
+// time into a small per-thread panel that stays in the cache, and
+// writes the panel transposed into the destination. Each half of the
+// transform then reads and writes the array only once.
+
+static int panel2DAvailable(SleefDFT *p) {
+  return p->log2hlen >= LOG2BS && p->log2vlen >= LOG2BS;
+}
+
+// The workspace of a 2D plan is the transpose buffer followed by one
+// slice per thread. A slice holds a panel and the workspace of a row
+// transform.
+
+static size_t panel2DSize(SleefDFT *p) {
+  return panel2DAvailable(p) ? wsRound(2 * BS * (size_t)MAX(p->hlen, p->vlen)) : 0;
+}
+
+static size_t ws2DSlice(SleefDFT *p) {
+  return panel2DSize(p) + MAX(wsSize(p->instH), wsSize(p->instV));
+}
+
+// Like transposeRows, but the destination is split into the planes
+// dr and di of real and imaginary parts
+
+static void transposeRowsSplit(real *dr, real *di, const real *s, const int log2n, const int log2m, const int y0, const int y1) {
+  for(int y=y0;y<y1;y+=BS) {
+    for(int x=0;x<(1 << log2m);x+=BS) {
+      for(int x2=0;x2<BS;x2++) {
+	const real *sp = &s[(((size_t)(y-y0) << log2m)+x+x2)*2];
+	const size_t o = ((size_t)(x+x2) << log2n)+y;
+	for(int y2=0;y2<BS;y2++) {
+	  dr[o+y2] = sp[((size_t)y2 << log2m)*2+0];
+	  di[o+y2] = sp[((size_t)y2 << log2m)*2+1];
+	}
+      }
+    }
+  }
+}
+
+// Storage formats
+
+// The 16-bit floating-point formats are converted by the functions in
+// dftformat.h. A double is rounded to float first. A fixed-point
+// value is an int16_t or an int32_t. Conversions to these formats
+// multiply by a scale, round to nearest and saturate.
+
+static INLINE uint16_t toHalf(real x, int bf) { return bf ? floatToBf16((float)x) : floatToFp16((float)x); }
+
+static INLINE int32_t toFixed(real x, double scale, int32_t limit) {
+  double y = x * scale;
+  y = y > limit ? limit : y < -(double)limit - 1 ? -(double)limit - 1 : y;
+  y = y == y ? y : 0;
+
+  // Adding and subtracting 1.5 * 2^52 rounds to nearest even without
+  // a call to rint, so that the loops in storeFormat are vectorised
+  return (int32_t)((y + 0x1.8p+52) - 0x1.8p+52);
+}
+
+static size_t formatSize(int fmt) { return fmt == FORMAT_INT32 ? sizeof(int32_t) : sizeof(uint16_t); }
+
+// Converts n values from s, starting at element o
+
+static void loadFormat(real *d, const void *s, size_t o, size_t n, int fmt) {
+  switch(fmt) {
+  case FORMAT_FP16: for(size_t i=0;i<n;i++) d[i] = fp16ToFloat(((const uint16_t *)s)[o+i]); break;
+  case FORMAT_BF16: for(size_t i=0;i<n;i++) d[i] = bf16ToFloat(((const uint16_t *)s)[o+i]); break;
+  case FORMAT_INT16: for(size_t i=0;i<n;i++) d[i] = (real)((const int16_t *)s)[o+i]; break;
+  case FORMAT_INT32: for(size_t i=0;i<n;i++) d[i] = (real)((const int32_t *)s)[o+i]; break;
+  }
+}
+
+// scale only applies to fixed-point formats
+
+static void storeFormat(void *d, const real *s, size_t n, int fmt, double scale) {
+  switch(fmt) {
+  case FORMAT_FP16: for(size_t i=0;i<n;i++) ((uint16_t *)d)[i] = floatToFp16((float)s[i]); break;
+  case FORMAT_BF16: for(size_t i=0;i<n;i++) ((uint16_t *)d)[i] = floatToBf16((float)s[i]); break;
+  case FORMAT_INT16: for(size_t i=0;i<n;i++) ((int16_t *)d)[i] = (int16_t)toFixed(s[i], scale, INT16_MAX); break;
+  case FORMAT_INT32: for(size_t i=0;i<n;i++) ((int32_t *)d)[i] = toFixed(s[i], scale, INT32_MAX); break;
+  }
+}
+
+// Returns the exponent e of a block of n values such that the largest
+// magnitude times 2^-e fills bits bits. A block of zeros, or one with
+// a value that is not finite, has exponent 0.
+
+static int blockExponent(const real *s, size_t n, int bits) {
+  real m = 0;
+  for(size_t i=0;i<n;i++) {
+    const real a = s[i] < 0 ? -s[i] : s[i];
+    if (!(a - a == 0)) return 0;
+    if (a > m) m = a;
+  }
+  if (m == 0) return 0;
+  int k;
+  frexp((double)m, &k);
+  return k - bits;
+}
+
+// Like transposeRows, but the destination holds 16-bit values
+
+static void transposeRowsHalf(uint16_t *d, const real *s, const int log2n, const int log2m, const int y0, const int y1, const int bf) {
+  for(int y=y0;y<y1;y+=BS) {
+    for(int x=0;x<(1 << log2m);x+=BS) {
+      for(int x2=0;x2<BS;x2++) {
+	const real *sp = &s[(((size_t)(y-y0) << log2m)+x+x2)*2];
+	uint16_t *dp = &d[(((size_t)(x+x2) << log2n)+y)*2];
+	for(int y2=0;y2<BS;y2++) {
+	  dp[y2*2+0] = toHalf(sp[((size_t)y2 << log2m)*2+0], bf);
+	  dp[y2*2+1] = toHalf(sp[((size_t)y2 << log2m)*2+1], bf);
+	}
+      }
+    }
+  }
+}
+
+// A split source or destination is given by a non-NULL sIm or dIm,
+// and one with a storage format by a non-NULL fs or fd. A split row or
+// a row with a storage format is converted into a line buffer before
+// it is transformed. fd takes binary16 or bfloat16 only.
+
+typedef struct PanelArg {
+  SleefDFT *p, *inst;
+  const real *s, *sIm;
+  real *d, *dIm;
+  int log2n, log2m;
+  real *ws;
+  void **lines;
+  real *linesWs;
+  size_t lineSlice;
+  const void *fs;
+  void *fd;
+  int fmtIn, fmtOut;
+} PanelArg;
+
+static void panelTask(void *ptr, int i) {
+  PanelArg *a = (PanelArg *)ptr;
+  const int tn = Executor_slot();
+  const size_t m = (size_t)1 << a->log2m;
+  real *panel = a->ws == NULL ? (real *)a->p->tPanel[tn] : a->ws + tn * ws2DSlice(a->p);
+  real *subws = a->ws == NULL ? NULL : panel + panel2DSize(a->p);
+
+  for(int y=0;y<BS;y++) {
+    real *line = a->linesWs == NULL ? (a->lines == NULL ? NULL : (real *)a->lines[tn]) : a->linesWs + tn * a->lineSlice;
+    const real *row = line;
+
+    if (a->sIm != NULL) {
+      const real *re = &a->s[(i*BS+y)*m], *im = &a->sIm[(i*BS+y)*m];
+      for(size_t x=0;x<m;x++) {
+	line[x*2+0] = re[x];
+	line[x*2+1] = im[x];
+      }
+    } else if (a->fs != NULL) {
+      loadFormat(line, a->fs, (i*BS+y)*m*2, m*2, a->fmtIn);
+    } else {
+      row = &a->s[(i*BS+y)*m*2];
+    }
+
+    executeWS(a->inst, row, &panel[y*m*2], subws);
+  }
+
+  if (a->dIm != NULL) {
+    transposeRowsSplit(a->d, a->dIm, panel, a->log2n, a->log2m, i*BS, (i+1)*BS);
+  } else if (a->fd != NULL) {
+    transposeRowsHalf((uint16_t *)a->fd, panel, a->log2n, a->log2m, i*BS, (i+1)*BS, a->fmtOut == FORMAT_BF16);
+  } else {
+    transposeRows(a->d, panel, a->log2n, a->log2m, i*BS, (i+1)*BS);
+  }
+}
+
+// Transforms the 2^log2n rows of length 2^log2m in s, and writes the
+// result transposed into d
+
+static void panelPass(SleefDFT *p, SleefDFT *inst, const real *s, real *d, int log2n, int log2m, real *ws, int nth) {
+  PanelArg a = { p, inst, s, NULL, d, NULL, log2n, log2m, ws, NULL, NULL, 0, NULL, NULL, 0, 0 };
+  Executor_parallelFor(panelTask, &a, 1 << (log2n - LOG2BS), MIN(nth, Executor_threadCount()));
+}
+
+// strategy is 0 for separate passes with a serial transpose, 1 for
+// separate passes with a multithreaded transpose and 2 for panels
+
+static void execute2D(SleefDFT *p, const real *s, real *d, real *ws, int strategy) {
+  real *tBuf = ws == NULL ? (real *)(p->tBuf) : ws;
+  real *wsThread = ws == NULL ? NULL : ws + wsRound(2 * (size_t)p->hlen * p->vlen);
+  real *wsRow = wsThread == NULL ? NULL : wsThread + panel2DSize(p);
+  const int nth = (p->mode3 & SLEEF_MODE3_MT2D) != 0 ? p->tNThread : 1;
+
+  if (strategy == 2) {
+    // S -> T -> D
+
+    panelPass(p, p->instH, s, tBuf, p->log2vlen, p->log2hlen, wsThread, nth);
+    panelPass(p, p->instV, tBuf, d, p->log2hlen, p->log2vlen, wsThread, nth);
+  } else if (strategy == 1 && nth > 1) {
+    // S -> T -> D -> T -> D
+
+    rowsMT(p->instH, s, tBuf, p->hlen, p->vlen, wsRow, ws2DSlice(p), nth);
+    transposeMT(d, tBuf, p->log2vlen, p->log2hlen, nth);
+    rowsMT(p->instV, d, tBuf, p->vlen, p->hlen, wsRow, ws2DSlice(p), nth);
+    transposeMT(d, tBuf, p->log2hlen, p->log2vlen, nth);
+  } else {
+    for(int y=0;y<p->vlen;y++) {
+      executeWS(p->instH, &s[p->hlen*2*y], &tBuf[p->hlen*2*y], wsRow);
+    }
+
+    transpose(d, tBuf, p->log2vlen, p->log2hlen);
+
+    for(int y=0;y<p->hlen;y++) {
+      executeWS(p->instV, &d[p->vlen*2*y], &tBuf[p->vlen*2*y], wsRow);
+    }
+
+    transpose(d, tBuf, p->log2hlen, p->log2vlen);
+  }
+}
+
+// Returns the strategy of execute2D chosen by the planner. Plans in
+// the debug mode pick one at random.
+
+static int strategy2D(SleefDFT *p) {
+  int strategy = (p->mode3 & SLEEF_MODE3_MT2D) != 0 && p->tmMT < p->tmNoMT ? 1 : 0;
+  if (p->tmPanel != 0 && p->tmPanel < p->tmSep) strategy = 2;
+
+  if ((p->mode & (SLEEF_MODE_DEBUG | SLEEF_MODE_REALTIME)) == SLEEF_MODE_DEBUG) strategy = rand() % (panel2DAvailable(p) ? 3 : 2);
+
+  return strategy;
+}
+
+// Split-complex planner
+
+// A split-complex plan keeps the real and imaginary parts of its
+// input, its output or both in two separate planes. It wraps an
+// interleaved plan. The stages of a 1D power-of-two transform read
+// and write the planes themselves, see executeIO. A 2D transform with
+// panels reads the planes while filling the panels and writes the
+// planes in its final transpose. If the planner prefers separate
+// passes for the 2D transform, the planes are interleaved into one
+// buffer, which is transformed in place. Other transforms interleave
+// the input into a buffer and split the output from another buffer.
+
+static int split2D(SleefDFT *p) {
+  return p->instSplit->magic == MAGIC2D && panel2DAvailable(p->instSplit);
+}
+
+static int splitDirect(SleefDFT *p) {
+  return p->instSplit->magic == MAGIC && p->instSplit->log2len > 1;
+}
+
+// Returns 1 if a 2D transform may take panels, if panels is 1, or
+// separate passes, if panels is 0. A plan in the debug mode may take
+// both.
+
+static int splitMayUse(SleefDFT *p, int panels) {
+  SleefDFT *q = p->instSplit;
+  if ((q->mode & (SLEEF_MODE_DEBUG | SLEEF_MODE_REALTIME)) == SLEEF_MODE_DEBUG) return 1;
+  return (q->tmPanel != 0 && q->tmPanel < q->tmSep) == panels;
+}
+
+static size_t splitLineSize(SleefDFT *p) {
+  return wsRound(2 * (size_t)MAX(p->instSplit->hlen, p->instSplit->vlen));
+}
+
+static size_t splitLinesSize(SleefDFT *p) {
+  return splitMayUse(p, 1) ? p->spNThread * splitLineSize(p) : 0;
+}
+
+// The workspace is the workspace of the wrapped plan followed by the
+// line buffers and the buffer of a 2D transform, or the two
+// interleaving buffers. A 1D transform with input weights needs the
+// interleaving buffers.
+
+static size_t splitWsShared(SleefDFT *p) {
+  const size_t n = wsRound(2 * (size_t)p->spTotal);
+  if (split2D(p)) return splitLinesSize(p) + (splitMayUse(p, 0) ? n : 0);
+  if (splitDirect(p) && p->instSplit->winTbl == NULL) return 0;
+  return 2 * n;
+}
+
+static void allocSplitBuffers(SleefDFT *p) {
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0 || p->spBuf0 != NULL) return;
+  p->spBuf0 = Sleef_malloc(sizeof(real) * 2 * p->spTotal);
+  p->spBuf1 = Sleef_malloc(sizeof(real) * 2 * p->spTotal);
+}
+
+static SleefDFT *initSplit(int rank, uint32_t n0, uint32_t n1, const real *in, real *out, uint64_t mode) {
+  if ((mode & (SLEEF_MODE_REAL | SLEEF_MODE_DCT | SLEEF_MODE_DST)) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Split layouts are only supported for complex transforms\n");
+    return NULL;
+  }
+
+  uint64_t modeSub = mode & ~(uint64_t)(SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT);
+  SleefDFT *q = rank == 1 ? INIT(n0, NULL, NULL, modeSub) : INIT2D(n0, n1, NULL, NULL, modeSub);
+  if (q == NULL) return NULL;
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICSP;
+  p->baseTypeID = BASETYPEID;
+  p->in = (const void *)in;
+  p->out = (void *)out;
+  p->mode = mode;
+  p->instSplit = q;
+  p->spTotal = rank == 1 ? n0 : n0 * n1;
+  p->spNThread = Executor_slotCount();
+
+  if (split2D(p)) {
+    if (splitMayUse(p, 1)) p->spLine = allocBuffers(p->spNThread, splitLineSize(p), mode);
+    if (splitMayUse(p, 0) && (mode & SLEEF_MODE_NO_SCRATCH) == 0) p->spBuf0 = Sleef_malloc(sizeof(real) * 2 * p->spTotal);
+  } else if (!splitDirect(p)) {
+    allocSplitBuffers(p);
+  }
+
+  return p;
+}
+
+static void interleavePlanes(real *x, const real *re, const real *im, size_t n) {
+  for(size_t i=0;i<n;i++) {
+    x[i*2+0] = re[i];
+    x[i*2+1] = im[i];
+  }
+}
+
+static void splitPlanes(real *re, real *im, const real *x, size_t n) {
+  for(size_t i=0;i<n;i++) {
+    re[i] = x[i*2+0];
+    im[i] = x[i*2+1];
+  }
+}
+
+// sIm and dIm are ignored unless the corresponding side is split
+
+static void executeSplit(SleefDFT *p, const real *s, const real *sIm, real *d, real *dIm, real *ws) {
+  SleefDFT *q = p->instSplit;
+  const int splitIn = (p->mode & SLEEF_MODE_SPLIT_IN) != 0, splitOut = (p->mode & SLEEF_MODE_SPLIT_OUT) != 0;
+  real *subws = ws == NULL ? NULL : ws + splitWsShared(p);
+  const size_t n = p->spTotal;
+
+  if (split2D(p)) {
+    const int strategy = strategy2D(q);
+
+    if (strategy != 2) {
+      real *x = ws == NULL ? (real *)p->spBuf0 : ws + splitLinesSize(p);
+      if (splitIn) interleavePlanes(x, s, sIm, n);
+      execute2D(q, splitIn ? x : s, splitOut ? x : d, subws, strategy);
+      if (splitOut) splitPlanes(d, dIm, x, n);
+      return;
+    }
+
+    // S -> T -> D, as in execute2D
+
+    real *tBuf = subws == NULL ? (real *)(q->tBuf) : subws;
+    real *wsThread = subws == NULL ? NULL : subws + wsRound(2 * (size_t)q->hlen * q->vlen);
+    const int nth = (q->mode3 & SLEEF_MODE3_MT2D) != 0 ? q->tNThread : 1;
+
+    PanelArg a = { q, q->instH, s, splitIn ? sIm : NULL, tBuf, NULL, q->log2vlen, q->log2hlen,
+		   wsThread, p->spLine, ws, splitLineSize(p), NULL, NULL, 0, 0 };
+    Executor_parallelFor(panelTask, &a, 1 << (q->log2vlen - LOG2BS), MIN(nth, Executor_threadCount()));
+
+    PanelArg b = { q, q->instV, tBuf, NULL, d, splitOut ? dIm : NULL, q->log2hlen, q->log2vlen,
+		   wsThread, NULL, NULL, 0, NULL, NULL, 0, 0 };
+    Executor_parallelFor(panelTask, &b, 1 << (q->log2hlen - LOG2BS), MIN(nth, Executor_threadCount()));
+    return;
+  }
+
+  if (splitDirect(p) && q->winTbl == NULL) {
+    KernelIO io = { s, splitIn ? sIm : NULL, d, splitOut ? dIm : NULL,
+		    splitIn ? FORMAT_SPLIT : FORMAT_REAL, splitOut ? FORMAT_SPLIT : FORMAT_REAL };
+    executeIO(q, &io, subws);
+    return;
+  }
+
+  real *x0 = ws == NULL ? (real *)p->spBuf0 : ws;
+  real *x1 = ws == NULL ? (real *)p->spBuf1 : ws + wsRound(2 * n);
+
+  if (splitIn) {
+    interleavePlanes(x0, s, sIm, n);
+    s = x0;
+  }
+
+  executeWS(q, s, splitOut ? x1 : d, subws);
+
+  if (splitOut) splitPlanes(d, dIm, x1, n);
+}
+
+// Storage format planner
+
+// A plan with a storage format reads its input, writes its output or
+// both as binary16, bfloat16, int16 or int32 values, and computes in
+// real. Like a split-complex plan it wraps an interleaved plan. The
+// first stage of a 1D power-of-two transform converts the input
+// itself, and the last stage converts a 16-bit floating-point output
+// or finds the exponent of a fixed-point output, see loadio and
+// storeio in vectortype.h. A 2D
+// transform with panels converts each row into a line buffer while
+// filling the panels, and converts a 16-bit floating-point output in
+// its final transpose. If the planner prefers separate passes for the
+// 2D transform, or the output is fixed-point, the 2D transform runs
+// in place on a conversion buffer. Other transforms convert the input
+// into the buffer, transform the buffer in place and convert the
+// output from it.
+//
+// A fixed-point output is a block floating-point array. The values of
+// the whole output share an exponent, which is chosen after the
+// transform so that the largest value fills the integer type. An
+// input is taken as integers, and the caller adds its own exponent to
+// the one of the output. An int32 input is rounded to real, so a
+// float plan keeps the 24 most significant bits of each value.
+
+static int format2D(SleefDFT *p) {
+  return p->instFormat->magic == MAGIC2D && panel2DAvailable(p->instFormat);
+}
+
+static int formatDirect(SleefDFT *p) {
+  return p->instFormat->magic == MAGIC && p->instFormat->log2len > 1;
+}
+
+// Size of the magnitude maxima of a fixed-point output, see KernelIO
+
+static size_t formatMaxSize(SleefDFT *p) {
+  return formatDirect(p) && isFixed(p->fmOut) ? wsRound(2 * (size_t)p->instFormat->vecwidth * p->instFormat->nThread) : 0;
+}
+
+// Like splitMayUse. Panels cannot write a fixed-point output.
+
+static int formatMayUse(SleefDFT *p, int panels) {
+  SleefDFT *q = p->instFormat;
+  if (isFixed(p->fmOut)) return !panels;
+  if ((q->mode & (SLEEF_MODE_DEBUG | SLEEF_MODE_REALTIME)) == SLEEF_MODE_DEBUG) return 1;
+  return (q->tmPanel != 0 && q->tmPanel < q->tmSep) == panels;
+}
+
+// Like strategy2D, but falls back to separate passes if panels cannot
+// be used
+
+static int formatStrategy(SleefDFT *p) {
+  SleefDFT *q = p->instFormat;
+  const int strategy = strategy2D(q);
+  if (strategy != 2 || !isFixed(p->fmOut)) return strategy;
+  return (q->mode3 & SLEEF_MODE3_MT2D) != 0 && q->tmMT < q->tmNoMT ? 1 : 0;
+}
+
+static size_t formatLineSize(SleefDFT *p) {
+  return wsRound(2 * (size_t)MAX(p->instFormat->hlen, p->instFormat->vlen));
+}
+
+static size_t formatLinesSize(SleefDFT *p) {
+  return formatMayUse(p, 1) ? p->fmNThread * formatLineSize(p) : 0;
+}
+
+// The workspace is the line buffers and the conversion buffer of a 2D
+// transform, or the conversion buffer and the magnitude maxima,
+// followed by the workspace of the wrapped plan. A 1D transform
+// needs the conversion buffer if it has input weights or a
+// fixed-point output.
+
+static size_t formatWsShared(SleefDFT *p) {
+  const size_t n = wsRound(2 * (size_t)p->fmTotal);
+  if (format2D(p)) return formatLinesSize(p) + (formatMayUse(p, 0) ? n : 0);
+  if (formatDirect(p) && p->instFormat->winTbl == NULL && !isFixed(p->fmOut)) return 0;
+  return n + formatMaxSize(p);
+}
+
+static void allocFormatBuffer(SleefDFT *p) {
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0 || p->fmBuf != NULL) return;
+  p->fmBuf = Sleef_malloc(sizeof(real) * (wsRound(2 * (size_t)p->fmTotal) + formatMaxSize(p)));
+}
+
+// Returns the format selected for one side, or -1 if more than one is
+// selected
+
+static int sideFormat(uint64_t mode, uint64_t fp16, uint64_t bf16, uint64_t int16, uint64_t int32) {
+  const uint64_t flags[4] = { fp16, bf16, int16, int32 };
+  int fmt = FORMAT_REAL;
+  for(int i=0;i<4;i++) {
+    if ((mode & flags[i]) == 0) continue;
+    if (fmt != FORMAT_REAL) return -1;
+    fmt = FORMAT_FP16 + i;
+  }
+  return fmt;
+}
+
+static SleefDFT *initFormat(int rank, uint32_t n0, uint32_t n1, const void *in, void *out, uint64_t mode) {
+  if ((mode & (SLEEF_MODE_REAL | SLEEF_MODE_DCT | SLEEF_MODE_DST | SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT)) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Storage formats are only supported for interleaved complex transforms\n");
+    return NULL;
+  }
+
+  const int fmtIn = sideFormat(mode, SLEEF_MODE_FP16_IN, SLEEF_MODE_BF16_IN, SLEEF_MODE_INT16_IN, SLEEF_MODE_INT32_IN);
+  const int fmtOut = sideFormat(mode, SLEEF_MODE_FP16_OUT, SLEEF_MODE_BF16_OUT, SLEEF_MODE_INT16_OUT, SLEEF_MODE_INT32_OUT);
+
+  if (fmtIn < 0 || fmtOut < 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Only one storage format can be given for each side\n");
+    return NULL;
+  }
+
+  uint64_t modeSub = mode & ~(uint64_t)(SLEEF_MODE_FORMAT_IN | SLEEF_MODE_FORMAT_OUT);
+  SleefDFT *q = rank == 1 ? INIT(n0, NULL, NULL, modeSub) : INIT2D(n0, n1, NULL, NULL, modeSub);
+  if (q == NULL) return NULL;
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICFM;
+  p->baseTypeID = BASETYPEID;
+  p->in = in;
+  p->out = out;
+  p->mode = mode;
+  p->instFormat = q;
+  p->fmTotal = rank == 1 ? n0 : n0 * n1;
+  p->fmNThread = Executor_slotCount();
+  p->fmIn = fmtIn;
+  p->fmOut = fmtOut;
+
+  if (format2D(p)) {
+    if (formatMayUse(p, 1) && fmtIn != FORMAT_REAL) p->fmLine = allocBuffers(p->fmNThread, formatLineSize(p), mode);
+    if (formatMayUse(p, 0)) allocFormatBuffer(p);
+  } else if (!formatDirect(p) || isFixed(fmtOut)) {
+    allocFormatBuffer(p);
+  }
+
+  return p;
+}
+
+// Converts the n complex values in x into d. The exponent of a
+// fixed-point output is found from the nm values in m, which are x
+// itself or magnitude maxima found by the last stage. Returns the
+// exponent of a fixed-point output, and 0 for other outputs.
+
+static int storeOutput(void *d, const real *x, size_t n, int fmt, const real *m, size_t nm) {
+  int e = 0;
+  if (fmt == FORMAT_INT16) e = blockExponent(m, nm, 15);
+  if (fmt == FORMAT_INT32) e = blockExponent(m, nm, 31);
+
+  storeFormat(d, x, 2 * n, fmt, ldexp(1, -e));
+
+  return e;
+}
+
+// s and d point to values in the formats of the plan. Returns the
+// exponent of a fixed-point output, and 0 for other outputs.
+
+static int executeFormat(SleefDFT *p, const void *s, void *d, real *ws) {
+  SleefDFT *q = p->instFormat;
+  const int fmtIn = p->fmIn, fmtOut = p->fmOut;
+  real *subws = ws == NULL ? NULL : ws + formatWsShared(p);
+  const size_t n = p->fmTotal;
+
+  if (format2D(p)) {
+    const int strategy = formatStrategy(p);
+
+    if (strategy != 2) {
+      real *x = ws == NULL ? (real *)p->fmBuf : ws + formatLinesSize(p);
+      if (fmtIn != FORMAT_REAL) loadFormat(x, s, 0, 2 * n, fmtIn);
+      execute2D(q, fmtIn != FORMAT_REAL ? x : (const real *)s, fmtOut != FORMAT_REAL ? x : (real *)d, subws, strategy);
+      return fmtOut == FORMAT_REAL ? 0 : storeOutput(d, x, n, fmtOut, x, 2 * n);
+    }
+
+    // S -> T -> D, as in execute2D
+
+    real *tBuf = subws == NULL ? (real *)(q->tBuf) : subws;
+    real *wsThread = subws == NULL ? NULL : subws + wsRound(2 * (size_t)q->hlen * q->vlen);
+    const int nth = (q->mode3 & SLEEF_MODE3_MT2D) != 0 ? q->tNThread : 1;
+
+    PanelArg a = { q, q->instH, fmtIn != FORMAT_REAL ? NULL : (const real *)s, NULL, tBuf, NULL, q->log2vlen, q->log2hlen,
+		   wsThread, p->fmLine, ws, formatLineSize(p), fmtIn != FORMAT_REAL ? s : NULL, NULL, fmtIn, 0 };
+    Executor_parallelFor(panelTask, &a, 1 << (q->log2vlen - LOG2BS), MIN(nth, Executor_threadCount()));
+
+    PanelArg b = { q, q->instV, tBuf, NULL, fmtOut != FORMAT_REAL ? NULL : (real *)d, NULL, q->log2hlen, q->log2vlen,
+		   wsThread, NULL, NULL, 0, NULL, fmtOut != FORMAT_REAL ? d : NULL, 0, fmtOut };
+    Executor_parallelFor(panelTask, &b, 1 << (q->log2hlen - LOG2BS), MIN(nth, Executor_threadCount()));
+    return 0;
+  }
+
+  real *x = ws == NULL ? (real *)p->fmBuf : ws;
+
+  if (formatDirect(p) && q->winTbl == NULL) {
+    if (!isFixed(fmtOut)) {
+      KernelIO io = { s, NULL, d, NULL, fmtIn, fmtOut };
+      executeIO(q, &io, subws);
+      return 0;
+    }
+
+    // The last stage finds the largest magnitude, so only the
+    // conversion into integers is left
+
+    real *mx = x + wsRound(2 * n);
+    memset(mx, 0, sizeof(real) * formatMaxSize(p));
+    KernelIO io = { s, NULL, x, mx, fmtIn, fmtOut };
+    executeIO(q, &io, subws);
+    return storeOutput(d, x, n, fmtOut, mx, formatMaxSize(p));
+  }
+
+  if (fmtIn != FORMAT_REAL) {
+    loadFormat(x, s, 0, 2 * n, fmtIn);
+    s = x;
+  }
+
+  executeWS(q, (const real *)s, fmtOut != FORMAT_REAL ? x : (real *)d, subws);
+
+  return fmtOut == FORMAT_REAL ? 0 : storeOutput(d, x, n, fmtOut, x, 2 * n);
+}
+
+// The workspace of an N-D plan is the transpose buffer followed by one
+// slice per thread
+
+static size_t ndWsSlice(SleefDFT *p) {
+  size_t sub = 0;
+  for(int a=0;a<p->ndRank;a++) sub = MAX(sub, wsSize(p->ndInst[a]));
+  return 2 * wsRound(2 * BS * p->ndPitch) + sub;
+}
+
+static size_t ndWsShared(SleefDFT *p) {
+  return p->ndPow2 ? wsRound(2 * (size_t)p->ndTotal) : 0;
+}
+
+static void ndPassStrided(SleefDFT *p, int axis, const real *s, real *d, real *ws) {
+  uint32_t S = 1;
+  for(int a=axis+1;a<p->ndRank;a++) S *= p->ndLen[a];
+  const uint32_t L = p->ndLen[axis], O = p->ndTotal / (L * S);
+
+  stridedPass(p->ndInst[axis], s, d, L, S, O, p->ndPitch, p->ndLine0, p->ndLine1,
+	      ws == NULL ? NULL : ws + ndWsShared(p), ndWsSlice(p), p->ndMT ? p->ndNThread : 1);
+}
+
+static void executeNDStrided(SleefDFT *p, const real *s, real *d, real *ws) {
+  ndPassStrided(p, p->ndRank-1, s, d, ws);
+  for(int a=p->ndRank-2;a>=0;a--) ndPassStrided(p, a, d, d, ws);
+}
+
+static void executeNDTranspose(SleefDFT *p, const real *s, real *d, real *ws) {
+  real *tBuf = ws == NULL ? (real *)p->ndBuf : ws;
+  real *wsThread = ws == NULL ? NULL : ws + ndWsShared(p);
+  const size_t wsSlice = ndWsSlice(p);
+  int log2total = 0;
+  for(int a=0;a<p->ndRank;a++) log2total += p->ndLog2Len[a];
+
+  const real *cur = s;
+
+  for(int a=p->ndRank-1;a>=0;a--) {
+    const int log2L = p->ndLog2Len[a], log2rows = log2total - log2L;
+    const uint32_t L = p->ndLen[a];
+
+    if (p->ndMT) {
+      rowsMT(p->ndInst[a], cur, tBuf, L, 1 << log2rows,
+	     wsThread == NULL ? NULL : wsThread + 2 * wsRound(2 * BS * p->ndPitch), wsSlice, p->ndNThread);
+
+      transposeMT(d, tBuf, log2rows, log2L, p->ndNThread);
+    } else {
+      real *subws = wsThread == NULL ? NULL : wsThread + 2 * wsRound(2 * BS * p->ndPitch);
+      for(int y=0;y<(1 << log2rows);y++) executeWS(p->ndInst[a], &cur[(size_t)L*2*y], &tBuf[(size_t)L*2*y], subws);
+
+      transpose(d, tBuf, log2rows, log2L);
+    }
+
+    cur = d;
+  }
+}
+
+static void executeND(SleefDFT *p, const real *s, real *d, real *ws) {
+  int useTranspose = p->ndPow2 &&
+    ((p->mode & (SLEEF_MODE_DEBUG | SLEEF_MODE_REALTIME)) != SLEEF_MODE_DEBUG ? p->ndTm[0] < p->ndTm[1] : (rand() & 1));
+
+  if (useTranspose) {
+    executeNDTranspose(p, s, d, ws);
+  } else {
+    executeNDStrided(p, s, d, ws);
+  }
+}
+
+static void measureND(SleefDFT *p) {
+  if (!p->ndPow2) {
+    p->ndTm[0] = 20;
+    p->ndTm[1] = 10;
+    return;
+  }
+
+  if (PlanManager_loadMeasurementResultsN(p)) {
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("N-D transpose(loaded): %lld, strided(loaded): %lld\n", (long long int)p->ndTm[0], (long long int)p->ndTm[1]);
+    return;
+  }
+
+  if ((p->mode & SLEEF_MODE_MEASURE) == 0 && (!planFilePathSet || (p->mode & SLEEF_MODE_MEASUREBITS) != 0)) {
+    p->ndTm[0] = 10;
+    p->ndTm[1] = 20;
+    if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("N-D : selected transpose(estimated)\n");
+    return;
+  }
+
+  real *s = (real *)Sleef_malloc(sizeof(real)*2*p->ndTotal);
+  real *d = (real *)Sleef_malloc(sizeof(real)*2*p->ndTotal);
+  real *ws = (p->mode & SLEEF_MODE_NO_SCRATCH) == 0 ? NULL : (real *)Sleef_malloc(sizeof(real) * wsSize(p));
+  memset(s, 0, sizeof(real)*2*p->ndTotal);
+
+  const int niter = 1 + 5000000 / (p->ndTotal + 1);
+  uint64_t tm;
+
+  tm = Sleef_currentTimeMicros();
+  for(int i=0;i<niter;i++) executeNDTranspose(p, s, d, ws);
+  p->ndTm[0] = Sleef_currentTimeMicros() - tm + 1;
+
+  tm = Sleef_currentTimeMicros();
+  for(int i=0;i<niter;i++) executeNDStrided(p, s, d, ws);
+  p->ndTm[1] = Sleef_currentTimeMicros() - tm + 1;
+
+  if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("N-D transpose(measured): %lld, strided(measured): %lld\n", (long long int)p->ndTm[0], (long long int)p->ndTm[1]);
+
+  Sleef_free(s);
+  Sleef_free(d);
+  if (ws != NULL) Sleef_free(ws);
+
+  PlanManager_saveMeasurementResultsN(p);
+}
+
+// Implementation of SleefDFT_*_initnd
+
+EXPORT SleefDFT *INITND(uint32_t rank, const uint32_t *dims, const real *in, real *out, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  if (rank < 1 || rank > MAXNDRANK || (mode & SLEEF_MODE_REAL) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported N-D transform : rank %u\n", (unsigned)rank);
+    return NULL;
+  }
+
+  if (rank == 1) return INIT(dims[0], in, out, mode);
+
+  // The element count is kept in 32 bits, so the product of the
+  // dimensions may not exceed the longest supported 1D length
+
+  uint64_t total = 1;
+  for(int a=0;a<(int)rank;a++) {
+    total *= dims[a];
+    if (total == 0 || total > (UINT64_C(1) << 31)) {
+      if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported N-D transform : too many elements\n");
+      return NULL;
+    }
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICND;
+  p->mode = mode;
+  p->baseTypeID = BASETYPEID;
+  p->in = in;
+  p->out = out;
+  p->ndRank = rank;
+  p->ndPow2 = 1;
+  p->ndTotal = (uint32_t)total;
+
+  uint32_t maxLen = 0;
+  for(int a=0;a<(int)rank;a++) {
+    p->ndLen[a] = dims[a];
+    if ((dims[a] & (dims[a] - 1)) != 0) p->ndPow2 = 0; else p->ndLog2Len[a] = ilog2(dims[a]);
+    if (dims[a] > maxLen) maxLen = dims[a];
+  }
+
+  p->ndNThread = Executor_slotCount();
+  p->ndMT = (mode & SLEEF_MODE_NO_MT) == 0 && Executor_threadCount() > 1 && p->ndTotal >= (1 << 14);
+
+  uint64_t mode1D = mode;
+  mode1D |= SLEEF_MODE_NO_MT;
+
+  for(int a=0;a<(int)rank;a++) {
+    for(int b=0;b<a;b++) {
+      if (dims[b] == dims[a]) { p->ndInst[a] = p->ndInst[b]; break; }
+    }
+    if (p->ndInst[a] == NULL) p->ndInst[a] = INIT(dims[a], NULL, NULL, mode1D);
+    if (p->ndInst[a] == NULL) {
+      for(int b=0;b<a;b++) {
+	int shared = 0;
+	for(int c=0;c<b;c++) if (p->ndInst[c] == p->ndInst[b]) shared = 1;
+	if (!shared) SleefDFT_dispose(p->ndInst[b]);
+      }
+      p->magic = 0;
+      free(p);
+      return NULL;
+    }
+  }
+
+  // Rows in the line buffers are padded to keep every row aligned
+
+  p->ndPitch = (maxLen + BS - 1) & ~(BS - 1);
+
+  p->ndLine0 = allocBuffers(p->ndNThread, 2 * BS * p->ndPitch, mode);
+  p->ndLine1 = allocBuffers(p->ndNThread, 2 * BS * p->ndPitch, mode);
+
+  if (p->ndPow2 && (mode & SLEEF_MODE_NO_SCRATCH) == 0) p->ndBuf = (void *)Sleef_malloc(sizeof(real)*2*p->ndTotal);
+
+  measureND(p);
+
+  return p;
+}
+
+// Implementation of SleefDFT_*_init3d
+
+EXPORT SleefDFT *INIT3D(uint32_t n0, uint32_t n1, uint32_t n2, const real *in, real *out, uint64_t mode) {
+  uint32_t dims[3] = { n0, n1, n2 };
+  return INITND(3, dims, in, out, mode);
+}
+
+// Real 2D planner
+
+// A forward real 2D transform of vlen x hlen real numbers produces
+// vlen x (hlen/2+1) complex numbers. The rows are transformed by the
+// real 1D plan, and then only the hlen/2+1 non-redundant columns are
+// transformed by the complex 1D plan. The backward transform runs the
+// two passes in the reverse order.
+
+static SleefDFT *initReal2D(uint32_t vlen, uint32_t hlen, const real *in, real *out, uint64_t mode) {
+  if ((hlen & (hlen - 1)) != 0 || hlen < 2 || (mode & SLEEF_MODE_ALT) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported real 2D transform : %u x %u\n", (unsigned)vlen, (unsigned)hlen);
+    return NULL;
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICR2D;
+  p->mode = mode;
+  p->baseTypeID = BASETYPEID;
+  p->in = in;
+  p->out = out;
+  p->r2hlen = hlen;
+  p->r2vlen = vlen;
+  p->r2hc = hlen/2+1;
+
+  p->r2NThread = Executor_slotCount();
+  p->r2MT = (mode & SLEEF_MODE_NO_MT) == 0 && Executor_threadCount() > 1 && hlen * vlen >= (1 << 14);
+
+  uint64_t mode1D = mode;
+  mode1D |= SLEEF_MODE_NO_MT;
+
+  p->instRow = INIT(hlen, NULL, NULL, mode1D);
+  p->instCol = INIT(vlen, NULL, NULL, mode1D & ~(uint64_t)SLEEF_MODE_REAL);
+
+  if (p->instRow == NULL || p->instCol == NULL) {
+    if (p->instRow != NULL) SleefDFT_dispose(p->instRow);
+    if (p->instCol != NULL) SleefDFT_dispose(p->instCol);
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  p->r2Pitch = (MAX(vlen, p->r2hc) + BS - 1) & ~(BS - 1);
+
+  p->r2Line0 = allocBuffers(p->r2NThread, 2 * BS * p->r2Pitch, mode);
+  p->r2Line1 = allocBuffers(p->r2NThread, 2 * BS * p->r2Pitch, mode);
+
+  if ((mode & SLEEF_MODE_BACKWARD) != 0 && (mode & SLEEF_MODE_NO_SCRATCH) == 0) p->r2Buf = (void *)Sleef_malloc(sizeof(real)*2*vlen*p->r2hc);
+
+  return p;
+}
+
+// The workspace of a real 2D plan is the backward column buffer
+// followed by one slice per thread
+
+static size_t real2DWsSlice(SleefDFT *p) {
+  return 2 * wsRound(2 * BS * p->r2Pitch) + MAX(wsSize(p->instRow), wsSize(p->instCol));
+}
+
+static size_t real2DWsShared(SleefDFT *p) {
+  return (p->mode & SLEEF_MODE_BACKWARD) != 0 ? wsRound(2 * (size_t)p->r2vlen * p->r2hc) : 0;
+}
+
+static void real2DRow(SleefDFT *p, const real *s, real *d, int y, real *ws) {
+  const int tn = Executor_slot();
+  real *x0, *x1, *subws = NULL;
+  const int hlen = p->r2hlen, hc = p->r2hc;
+
+  if (ws != NULL) {
+    x0 = ws + real2DWsShared(p) + (p->r2MT ? tn : 0) * real2DWsSlice(p);
+    x1 = x0 + wsRound(2 * BS * p->r2Pitch);
+    subws = x1 + wsRound(2 * BS * p->r2Pitch);
+  } else {
+    x0 = (real *)p->r2Line0[tn];
+    x1 = (real *)p->r2Line1[tn];
+  }
+
+  if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
+    const real *sr = &s[(size_t)hlen * y];
+
+    if (((uintptr_t)sr % LINE_ALIGNMENT) != 0) {
+      memcpy(x0, sr, sizeof(real) * hlen);
+      sr = x0;
+    }
+
+    executeWS(p->instRow, sr, x1, subws);
+    memcpy(&d[(size_t)hc * 2 * y], x1, sizeof(real) * 2 * hc);
+  } else {
+    real *dr = &d[(size_t)hlen * y];
+
+    memcpy(x0, &s[(size_t)hc * 2 * y], sizeof(real) * 2 * hc);
+
+    if (((uintptr_t)dr % LINE_ALIGNMENT) == 0) {
+      executeWS(p->instRow, x0, dr, subws);
+    } else {
+      executeWS(p->instRow, x0, x1, subws);
+      memcpy(dr, x1, sizeof(real) * hlen);
+    }
+  }
+}
+
+typedef struct Real2DArg {
+  SleefDFT *p;
+  const real *s;
+  real *d, *ws;
+} Real2DArg;
+
+static void real2DRowTask(void *ptr, int y) {
+  Real2DArg *a = (Real2DArg *)ptr;
+  real2DRow(a->p, a->s, a->d, y, a->ws);
+}
+
+static void executeReal2D(SleefDFT *p, const real *s, real *d, real *ws) {
+  const int vlen = p->r2vlen, hc = p->r2hc;
+  real *wsThread = ws == NULL ? NULL : ws + real2DWsShared(p);
+  const int nTask = p->r2MT ? MIN(p->r2NThread, Executor_threadCount()) : 1;
+
+  if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
+    Real2DArg a = { p, s, d, ws };
+    Executor_parallelFor(real2DRowTask, &a, vlen, nTask);
+
+    stridedPass(p->instCol, d, d, vlen, hc, 1, p->r2Pitch, p->r2Line0, p->r2Line1, wsThread, real2DWsSlice(p), p->r2MT ? p->r2NThread : 1);
+  } else {
+    real *tBuf = ws == NULL ? (real *)p->r2Buf : ws;
+
+    stridedPass(p->instCol, s, tBuf, vlen, hc, 1, p->r2Pitch, p->r2Line0, p->r2Line1, wsThread, real2DWsSlice(p), p->r2MT ? p->r2NThread : 1);
+
+    Real2DArg a = { p, tBuf, d, ws };
+    Executor_parallelFor(real2DRowTask, &a, vlen, nTask);
+  }
+}
+
+// Implementation of SleefDFT_*_init1dBatch
+
+// Strides and distances are counted in elements. An element is a
+// complex number on the complex side of a transform, and a real
+// number on the real side of a real transform.
+
+static size_t batchBufLen(SleefDFT *p) {
+  return ((size_t)2 * p->btLength << p->btLog2Block) + 8;
+}
+
+EXPORT SleefDFT *INITBATCH(uint32_t n, uint32_t howmany, uint32_t istride, uint32_t idist, uint32_t ostride, uint32_t odist, const real *in, real *out, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICBT;
+  p->mode = mode;
+  p->baseTypeID = BASETYPEID;
+  p->in = in;
+  p->out = out;
+  p->howmany = howmany;
+  p->istride = istride;
+  p->idist = idist;
+  p->ostride = ostride;
+  p->odist = odist;
+
+  if ((mode & SLEEF_MODE_REAL) == 0) {
+    p->btInSize = p->btOutSize = 2;
+    p->btInCount = p->btOutCount = n;
+  } else {
+    int specCount = (mode & SLEEF_MODE_ALT) != 0 ? n/2 : n/2+1;
+    if ((mode & SLEEF_MODE_BACKWARD) == 0) {
+      p->btInSize = 1;  p->btInCount = n;
+      p->btOutSize = 2; p->btOutCount = specCount;
+    } else {
+      p->btInSize = 2;  p->btInCount = specCount;
+      p->btOutSize = 1; p->btOutCount = n;
+    }
+  }
+
+  p->btNThread = Executor_slotCount();
+
+  // Many transforms are spread across threads, each running a
+  // single-threaded plan. A few long transforms use MT kernels.
+
+  uint64_t mode1D = mode;
+  if ((mode & SLEEF_MODE_NO_MT) == 0 && howmany >= (uint32_t)p->btNThread && howmany > 1) {
+    mode1D |= SLEEF_MODE_NO_MT;
+    p->btMT = 1;
+  }
+
+  p->btLength = n;
+  p->instBatch = INIT(n, NULL, NULL, mode1D);
+
+  if (p->instBatch == NULL) {
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  // Short complex transforms are computed several at a time by a
+  // single dft kernel, which vectorizes across transforms. The
+  // transforms of a block are gathered so that element j of
+  // transform b is at j * block + b, and the kernel is called with
+  // shift = log2(block). Tiny lengths keep the per-transform path,
+  // as their plans do not have the direction flipped by
+  // SLEEF_MODE_ALT.
+
+  p->btIsa = -1;
+  p->btLog2Block = 0;
+
+  if ((mode & SLEEF_MODE_REAL) == 0 && p->instBatch->magic == MAGIC &&
+      p->instBatch->log2len >= 2 && p->instBatch->log2len <= MAXBUTWIDTH) {
+    int bestPriority = -1;
+    for(int i=0;i<ISAMAX;i++) {
+      if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY)) {
+	bestPriority = (*GETINT[i])(GETINT_DFTPRIORITY);
+	p->btIsa = i;
+      }
+    }
+
+    if (p->btIsa != -1) {
+      int log2vw = 0;
+      while((1 << log2vw) < (*GETINT[p->btIsa])(GETINT_VECWIDTH)) log2vw++;
+      p->btLog2Block = log2vw + 2;
+      if (howmany < (UINT32_C(1) << p->btLog2Block)) {
+	p->btIsa = -1;
+	p->btLog2Block = 0;
+      }
+    }
+  }
+
+  p->btBuf0 = allocBuffers(p->btNThread, batchBufLen(p), mode);
+  p->btBuf1 = allocBuffers(p->btNThread, batchBufLen(p), mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) {
+    printf("Batch : %u x %u, %s", (unsigned)howmany, (unsigned)n, p->btMT ? "MT" : "ST");
+    if (p->btIsa != -1) printf(", %s blocks of %d", (char *)(*GETPTR[p->btIsa])(0), 1 << p->btLog2Block);
+    printf("\n");
+  }
+
+  return p;
+}
+
+#define BATCH_ALIGNMENT 256
+
+static size_t batchWsSlice(SleefDFT *p) {
+  return 2 * wsRound(batchBufLen(p)) + wsSize(p->instBatch);
+}
+
+static void executeBatchOne(SleefDFT *p, const real *s, real *d, uint32_t b, real *ws) {
+  const int tn = Executor_slot();
+
+  const real *sb = s + (size_t)b * p->idist * p->btInSize;
+  real *db = d + (size_t)b * p->odist * p->btOutSize;
+
+  int gather  = p->istride != 1 || ((uintptr_t)sb % BATCH_ALIGNMENT) != 0;
+  int scatter = p->ostride != 1 || ((uintptr_t)db % BATCH_ALIGNMENT) != 0;
+
+  real *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws + (p->btMT ? tn : 0) * batchWsSlice(p);
+    x1 = x0 + wsRound(batchBufLen(p));
+    subws = x1 + wsRound(batchBufLen(p));
+  } else {
+    x0 = (real *)p->btBuf0[tn];
+    x1 = (real *)p->btBuf1[tn];
+  }
+
+  if (gather) {
+    for(int j=0;j<p->btInCount;j++) {
+      for(int c=0;c<p->btInSize;c++) {
+	x0[j*p->btInSize+c] = sb[(size_t)j * p->istride * p->btInSize + c];
+      }
+    }
+  }
+
+  executeWS(p->instBatch, gather ? x0 : sb, scatter ? x1 : db, subws);
+
+  if (scatter) {
+    for(int j=0;j<p->btOutCount;j++) {
+      for(int c=0;c<p->btOutSize;c++) {
+	db[(size_t)j * p->ostride * p->btOutSize + c] = x1[j*p->btOutSize+c];
+      }
+    }
+  }
+}
+
+// Computes the transforms b0 to b0 + block - 1 with one kernel call
+
+static void executeBatchBlock(SleefDFT *p, const real *s, real *d, uint32_t b0, real *ws) {
+  const int tn = Executor_slot(), N = p->instBatch->log2len, lb = p->btLog2Block;
+  const uint32_t block = UINT32_C(1) << lb, n = p->btLength;
+  const SleefDFT *q = p->instBatch;
+  real *x0, *x1;
+
+  if (ws != NULL) {
+    x0 = ws + (p->btMT ? tn : 0) * batchWsSlice(p);
+    x1 = x0 + wsRound(batchBufLen(p));
+  } else {
+    x0 = (real *)p->btBuf0[tn];
+    x1 = (real *)p->btBuf1[tn];
+  }
+
+  for(uint32_t b=0;b<block;b++) {
+    const real *sb = s + (size_t)(b0 + b) * p->idist * 2;
+    for(uint32_t j=0;j<n;j++) {
+      x0[((j << lb) + b)*2+0] = sb[(size_t)j * p->istride * 2 + 0];
+      x0[((j << lb) + b)*2+1] = sb[(size_t)j * p->istride * 2 + 1];
+    }
+  }
+
+  if (q->hasScale) {
+    (*((q->mode & SLEEF_MODE_BACKWARD) == 0 ? IODFTF : IODFTB)[0][p->btIsa][N])(x1, NULL, FORMAT_REAL, x0, NULL, FORMAT_REAL, lb, (real)q->outScale);
+  } else {
+    (*((q->mode & SLEEF_MODE_BACKWARD) == 0 ? DFTF : DFTB)[0][p->btIsa][N])(x1, x0, lb);
+  }
+
+  for(uint32_t b=0;b<block;b++) {
+    real *db = d + (size_t)(b0 + b) * p->odist * 2;
+    for(uint32_t j=0;j<n;j++) {
+      db[(size_t)j * p->ostride * 2 + 0] = x1[((j << lb) + b)*2+0];
+      db[(size_t)j * p->ostride * 2 + 1] = x1[((j << lb) + b)*2+1];
+    }
+  }
+}
+
+// Task t < nBlock is the t-th block, and the other tasks are the
+// remaining transforms, one at a time
+
+typedef struct BatchArg {
+  SleefDFT *p;
+  const real *s;
+  real *d, *ws;
+  uint32_t nBlock;
+} BatchArg;
+
+static void batchTask(void *ptr, int t) {
+  BatchArg *a = (BatchArg *)ptr;
+  if ((uint32_t)t < a->nBlock) {
+    executeBatchBlock(a->p, a->s, a->d, (uint32_t)t << a->p->btLog2Block, a->ws);
+  } else {
+    executeBatchOne(a->p, a->s, a->d, (a->nBlock << a->p->btLog2Block) + (t - a->nBlock), a->ws);
+  }
+}
+
+static void executeBatch(SleefDFT *p, const real *s, real *d, real *ws) {
+  const uint32_t nBlock = p->btIsa != -1 ? p->howmany >> p->btLog2Block : 0;
+  const uint32_t nTask = nBlock + (p->howmany - (nBlock << p->btLog2Block));
+
+  BatchArg a = { p, s, d, ws, nBlock };
+
+  if (p->btMT) {
+    Executor_parallelFor(batchTask, &a, nTask, MIN(p->btNThread, Executor_threadCount()));
+    return;
+  }
+
+  for(uint32_t t=0;t<nTask;t++) batchTask(&a, t);
+}
+
+// Convolution
+
+// A convolution plan filters a stream of samples with a fixed kernel
+// by overlap-save. Each call appends blen new samples to the last
+// n - blen samples of the stream, where n is the transform length,
+// and outputs the last blen samples of the circular convolution of
+// this buffer with the kernel. The spectrum of the kernel divided by
+// n is precomputed. For complex signals it is multiplied by the first
+// stage of the backward transform, as the input weights of that plan.
+// For real signals it is multiplied by the postprocessing of the real
+// forward transform, as the output weights of that plan. A correlation
+// is a convolution with the reversed and conjugated kernel.
+
+// Implementation of SleefDFT_*_init1dConv
+
+EXPORT SleefDFT *INITCONV(uint32_t klen, const real *kernel, uint32_t blen, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  const uint64_t unsupported = SLEEF_MODE_BACKWARD | SLEEF_MODE_ALT | SLEEF_MODE_DCT | SLEEF_MODE_DST |
+    SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT;
+
+  if (kernel == NULL || klen == 0 || blen == 0 || (mode & unsupported) != 0 ||
+      (uint64_t)klen - 1 + blen > (UINT64_C(1) << (MAXLOG2LEN - 2))) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported convolution : %u, %u\n", (unsigned)klen, (unsigned)blen);
+    return NULL;
+  }
+
+  const int isReal = (mode & SLEEF_MODE_REAL) != 0, corr = (mode & SLEEF_MODE_CORRELATE) != 0;
+  const int c = isReal ? 1 : 2;
+
+  uint32_t n = 16;
+  while (n < klen - 1 + blen) n *= 2;
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICCV;
+  p->baseTypeID = BASETYPEID;
+  p->mode = mode;
+  p->cvLength = n;
+  p->cvKernelLen = klen;
+  p->cvBlockLen = blen;
+
+  uint64_t mode1D = mode & ~(uint64_t)SLEEF_MODE_CORRELATE;
+
+  p->instCF = INIT(n, NULL, NULL, mode1D);
+  p->instCB = INIT(n, NULL, NULL, mode1D | SLEEF_MODE_BACKWARD);
+
+  if (p->instCF == NULL || p->instCB == NULL) {
+    if (p->instCF != NULL) SleefDFT_dispose(p->instCF);
+    if (p->instCB != NULL) SleefDFT_dispose(p->instCB);
+    free(p);
+    return NULL;
+  }
+
+  // Spectrum of the zero-padded kernel
+
+  real *x = (real *)Sleef_malloc(sizeof(real) * (2*n+2));
+  real *y = (real *)Sleef_malloc(sizeof(real) * (2*n+2));
+
+  memset(x, 0, sizeof(real) * (2*n+2));
+  for(uint32_t i=0;i<klen;i++) {
+    uint32_t j = corr ? klen-1-i : i;
+    if (isReal) {
+      x[j] = kernel[i];
+    } else {
+      x[j*2+0] = kernel[i*2+0];
+      x[j*2+1] = corr ? -kernel[i*2+1] : kernel[i*2+1];
+    }
+  }
+
+  EXECUTE(p->instCF, x, y);
+
+  // Weights in the layout of applyWeights. The real postprocessing
+  // outputs the DC and Nyquist components, which are both real, as
+  // the first complex element, and element n/4 conjugated.
+
+  const real sc = (real)1.0 / n;
+  const uint32_t wn = isReal ? n : 2*n;
+  real *w = (real *)Sleef_malloc(sizeof(real) * 2 * wn);
+
+  for(uint32_t k=0;k<wn/2;k++) {
+    w[k*2+0] = w[k*2+1] = y[k*2+0] * sc;
+    w[wn+k*2+0] = w[wn+k*2+1] = y[k*2+1] * sc;
+  }
+
+  if (isReal) {
+    w[1] = y[n] * sc;
+    w[wn+0] = w[wn+1] = 0;
+    w[wn+n/2+0] = w[wn+n/2+1] = -y[n/2+1] * sc;
+    p->instCF->specTbl = w;
+  } else {
+    p->instCB->winTbl = w;
+  }
+
+  Sleef_free(y);
+  Sleef_free(x);
+
+  p->cvHistSize = sizeof(real) * c * (n - blen);
+  p->cvHist = Sleef_malloc(p->cvHistSize);
+  memset(p->cvHist, 0, p->cvHistSize);
+
+  p->cvBuf0 = allocBuffers(1, 2*n+2, mode);
+  p->cvBuf1 = allocBuffers(1, 2*n+2, mode);
+
+  return p;
+}
+
+static void executeConv(SleefDFT *p, const real *s, real *d, real *ws) {
+  const int n = p->cvLength, b = p->cvBlockLen, h = n - b;
+  const int c = (p->mode & SLEEF_MODE_REAL) != 0 ? 1 : 2;
+  real *hist = (real *)p->cvHist, *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws;
+    x1 = ws + wsRound(2*n+2);
+    subws = ws + 2 * wsRound(2*n+2);
+  } else {
+    x0 = (real *)p->cvBuf0[0];
+    x1 = (real *)p->cvBuf1[0];
+  }
+
+  memcpy(x0, hist, sizeof(real) * c * h);
+  memcpy(x0 + c*h, s, sizeof(real) * c * b);
+  memcpy(hist, x0 + c*b, sizeof(real) * c * h);
+
+  executeWS(p->instCF, x0, x1, subws);
+  executeWS(p->instCB, x1, x0, subws);
+
+  memcpy(d, x0 + c*h, sizeof(real) * c * b);
+}
+
+// Short-time Fourier transform
+
+// An STFT plan computes real forward transforms of frames of n samples
+// that start every hop samples in a ring buffer. The window is applied
+// by the first stage of the frame transform, so a frame is read from
+// the ring in place. It is only copied if it wraps around the end of
+// the ring, or if it is not aligned for the vector loads of the
+// kernels. Output frames that are not aligned are computed into a
+// buffer. The frames are spread across threads, each running a
+// single-threaded plan.
+//
+// Short frames are computed in blocks instead, as in a batch plan. Two
+// frames are taken as the real and imaginary parts of one complex
+// transform. The pairs of a block are gathered with the window
+// applied, so that element j of pair b is at j * block + b. One dft
+// kernel call then transforms the whole block, and the two spectra of
+// each pair are separated while they are written.
+
+static size_t stftBufLen(SleefDFT *p) {
+  return p->stIsa == -1 ? p->stLength + 2 : (size_t)2 * p->stLength << p->stLog2Block;
+}
+
+// Implementation of SleefDFT_*_init1dSTFT
+
+EXPORT SleefDFT *INITSTFT(uint32_t n, uint32_t hop, uint32_t ringLen, uint32_t odist, const real *window, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  const uint64_t unsupported = SLEEF_MODE_BACKWARD | SLEEF_MODE_DCT | SLEEF_MODE_DST |
+    SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT | SLEEF_MODE_CORRELATE;
+  const uint32_t specCount = (mode & SLEEF_MODE_ALT) != 0 ? n/2 : n/2+1;
+
+  if (n < 2 || (n & (n - 1)) != 0 || hop == 0 || ringLen < n || odist < specCount || (mode & unsupported) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported STFT : %u, %u, %u\n", (unsigned)n, (unsigned)hop, (unsigned)ringLen);
+    return NULL;
+  }
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICST;
+  p->mode = mode | SLEEF_MODE_REAL;
+  p->baseTypeID = BASETYPEID;
+  p->stLength = n;
+  p->stHop = hop;
+  p->stRingLen = ringLen;
+  p->stODist = odist;
+  p->stOutCount = specCount;
+  p->stNThread = Executor_slotCount();
+  p->stMT = (mode & SLEEF_MODE_NO_MT) == 0;
+
+  p->instFrame = INIT(n, NULL, NULL, mode | SLEEF_MODE_REAL | SLEEF_MODE_NO_MT);
+
+  if (p->instFrame == NULL || (window != NULL && SETWINDOW(p->instFrame, window) != 0)) {
+    if (p->instFrame != NULL) SleefDFT_dispose(p->instFrame);
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  p->stAlign = p->instFrame->log2len <= 1 ? 1 : 2 * p->instFrame->vecwidth * sizeof(real);
+
+  // The spectra of a pair are separated in the layout without
+  // SLEEF_MODE_ALT
+
+  p->stIsa = -1;
+  p->stLog2Block = 0;
+
+  if ((mode & SLEEF_MODE_ALT) == 0 && n >= 4 && ilog2(n) <= MAXBUTWIDTH) {
+    int bestPriority = -1;
+    for(int i=0;i<ISAMAX;i++) {
+      if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY)) {
+	bestPriority = (*GETINT[i])(GETINT_DFTPRIORITY);
+	p->stIsa = i;
+      }
+    }
+
+    if (p->stIsa != -1) {
+      int log2vw = 0;
+      while((1 << log2vw) < (*GETINT[p->stIsa])(GETINT_VECWIDTH)) log2vw++;
+      p->stLog2Block = log2vw + 2;
+    }
+  }
+
+  p->stBuf0 = allocBuffers(p->stNThread, stftBufLen(p), mode);
+  p->stBuf1 = allocBuffers(p->stNThread, stftBufLen(p), mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0 && p->stIsa != -1) {
+    printf("STFT : %u, %s blocks of %d pairs\n", (unsigned)n, (char *)(*GETPTR[p->stIsa])(0), 1 << p->stLog2Block);
+  }
+
+  return p;
+}
+
+static size_t stftWsSlice(SleefDFT *p) {
+  return 2 * wsRound(stftBufLen(p)) + wsSize(p->instFrame);
+}
+
+static void executeFrame(SleefDFT *p, const real *ring, uint32_t pos, uint32_t f, real *out, real *ws) {
+  const int tn = Executor_slot();
+  const uint32_t n = p->stLength, ringLen = p->stRingLen;
+  const uint32_t start = (uint32_t)(((uint64_t)pos + (uint64_t)f * p->stHop) % ringLen);
+
+  const real *src = ring + start;
+  real *dst = out + (size_t)f * p->stODist * 2;
+
+  int gather  = start + n > ringLen || ((uintptr_t)src % p->stAlign) != 0;
+  int scatter = ((uintptr_t)dst % p->stAlign) != 0;
+
+  real *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws + (p->stMT ? tn : 0) * stftWsSlice(p);
+    x1 = x0 + wsRound(stftBufLen(p));
+    subws = x1 + wsRound(stftBufLen(p));
+  } else {
+    x0 = (real *)p->stBuf0[tn];
+    x1 = (real *)p->stBuf1[tn];
+  }
+
+  if (gather) {
+    uint32_t m = MIN(n, ringLen - start);
+    memcpy(x0, src, sizeof(real) * m);
+    memcpy(x0 + m, ring, sizeof(real) * (n - m));
+  }
+
+  executeWS(p->instFrame, gather ? x0 : src, scatter ? x1 : dst, subws);
+
+  if (scatter) memcpy(dst, x1, sizeof(real) * 2 * p->stOutCount);
+}
+
+// Computes the frames f0 to f0 + 2 * block - 1 with one kernel call
+
+static void executeFrameBlock(SleefDFT *p, const real *ring, uint32_t pos, uint32_t f0, real *out, real *ws) {
+  const int tn = Executor_slot(), lb = p->stLog2Block, N = p->instFrame->log2len + 1;
+  const uint32_t n = p->stLength, h = n/2, ringLen = p->stRingLen, block = UINT32_C(1) << lb;
+  const real *win = (const real *)p->instFrame->winTbl;
+  real *x0, *x1;
+
+  if (ws != NULL) {
+    x0 = ws + (p->stMT ? tn : 0) * stftWsSlice(p);
+    x1 = x0 + wsRound(stftBufLen(p));
+  } else {
+    x0 = (real *)p->stBuf0[tn];
+    x1 = (real *)p->stBuf1[tn];
+  }
+
+  // Frame b is the real part of pair b/2 if b is even, and the
+  // imaginary part otherwise
+
+  for(uint32_t b=0;b<2*block;b++) {
+    const uint32_t start = (uint32_t)(((uint64_t)pos + (uint64_t)(f0 + b) * p->stHop) % ringLen);
+    const uint32_t m = MIN(n, ringLen - start);
+    for(uint32_t j=0;j<n;j++) {
+      const real v = j < m ? ring[start + j] : ring[j - m];
+      x0[(j << (lb + 1)) + b] = win == NULL ? v : v * win[j];
+    }
+  }
+
+  (*DFTF[0][p->stIsa][N])(x1, x0, lb);
+
+  // With Z the transform of a pair, the spectrum of its real part is
+  // (Z[k] + conj(Z[n-k])) / 2, and the one of its imaginary part is
+  // (Z[k] - conj(Z[n-k])) / 2i
+
+  for(uint32_t b=0;b<block;b++) {
+    real *da = out + (size_t)(f0 + 2*b) * p->stODist * 2, *dc = da + (size_t)p->stODist * 2;
+    for(uint32_t k=0;k<=h;k++) {
+      const real *z = &x1[((k << lb) + b)*2], *zm = &x1[((((n - k) & (n - 1)) << lb) + b)*2];
+      da[k*2+0] = (z[0] + zm[0]) * (real)0.5;
+      da[k*2+1] = (z[1] - zm[1]) * (real)0.5;
+      dc[k*2+0] = (z[1] + zm[1]) * (real)0.5;
+      dc[k*2+1] = (zm[0] - z[0]) * (real)0.5;
+    }
+  }
+}
+
+// Task t < nBlock is the t-th block, and the other tasks are the
+// remaining frames, one at a time
+
+typedef struct STFTArg {
+  SleefDFT *p;
+  const real *ring;
+  uint32_t pos, nBlock;
+  real *out, *ws;
+} STFTArg;
+
+static void stftTask(void *ptr, int t) {
+  STFTArg *a = (STFTArg *)ptr;
+  const int lb = a->p->stLog2Block + 1;
+  if ((uint32_t)t < a->nBlock) {
+    executeFrameBlock(a->p, a->ring, a->pos, (uint32_t)t << lb, a->out, a->ws);
+  } else {
+    executeFrame(a->p, a->ring, a->pos, (a->nBlock << lb) + (t - a->nBlock), a->out, a->ws);
+  }
+}
+
+static void executeSTFT(SleefDFT *p, const real *ring, uint32_t pos, uint32_t nframes, real *out, real *ws) {
+  const uint32_t nBlock = p->stIsa != -1 ? nframes >> (p->stLog2Block + 1) : 0;
+  const uint32_t nTask = nBlock + (nframes - (nBlock << (p->stLog2Block + 1)));
+
+  STFTArg a = { p, ring, pos, nBlock, out, ws };
+
+  if (p->stMT && nTask > 1) {
+    Executor_parallelFor(stftTask, &a, nTask, MIN(p->stNThread, Executor_threadCount()));
+    return;
+  }
+
+  for(uint32_t t=0;t<nTask;t++) stftTask(&a, t);
+}
+
+// Implementation of SleefDFT_*_init1dPruned
+
+// A pruned plan computes the bins k0 <= k < k0 + outCount (mod n) of a
+// complex transform of length n whose inputs are zero from nIn on.
+// The plan prunes the side that gives the shorter sub-transforms.
+//
+// Pruning the output, with m the smallest power of two >= outCount
+// and L = n/m, bin k0 + k is the sum over the phases p < L of
+// w^(p k) F_p[k], where F_p is the m-point transform of
+// x[L*q+p] w^((L*q+p) k0). A transform is run only for each phase
+// that has a non-zero input, and only the wanted bins are accumulated.
+// As in the six-step plan, the phases are processed in panels, so
+// that the interleaved inputs are accessed BS rows at a time.
+//
+// Pruning the input, with m the smallest power of two >= nIn and
+// L = n/m, bin k0 + p + L*q is F_p[q], where F_p is the m-point
+// transform of x[j] w^(j (k0 + p)) for j < m. This skips the first
+// log2(L) stages of a decimation-in-frequency transform, whose
+// butterflies only see zeros. The twiddles w^(j (k0 + p)) are kept in
+// a table of L*nIn values, at most n, so that each phase starts with
+// a vectorised multiplication. The transforms of a panel of phases are
+// written out transposed, so that the bins are stored BS at a time.
+
+static uint32_t prunedLength(uint32_t count) {
+  uint32_t m = 2;
+  while(m < count) m <<= 1;
+  return m;
+}
+
+EXPORT SleefDFT *INITPRUNED(uint32_t n, uint32_t nIn, uint32_t outStart, uint32_t outCount, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  const uint64_t unsupported = SLEEF_MODE_REAL | SLEEF_MODE_DCT | SLEEF_MODE_DST |
+    SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT | SLEEF_MODE_CORRELATE;
+
+  if (n < 2 || (n & (n - 1)) != 0 || nIn == 0 || nIn > n || outCount == 0 || outCount > n || outStart >= n || (mode & unsupported) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported pruned transform : %u, %u, %u, %u\n", (unsigned)n, (unsigned)nIn, (unsigned)outStart, (unsigned)outCount);
+    return NULL;
+  }
+
+  const int backward = ((mode & SLEEF_MODE_BACKWARD) != 0) != ((mode & SLEEF_MODE_ALT) != 0);
+  const int input = prunedLength(nIn) < prunedLength(outCount);
+  const uint32_t m = prunedLength(input ? nIn : outCount);
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICPR;
+  p->baseTypeID = BASETYPEID;
+  p->mode = mode;
+  p->prLength = n;
+  p->prInCount = nIn;
+  p->prOutStart = outStart;
+  p->prOutCount = outCount;
+  p->prSubLen = m;
+  p->prNThread = Executor_slotCount();
+  p->prMT = (mode & SLEEF_MODE_NO_MT) == 0;
+  p->prInput = input;
+
+  uint32_t panel = BS;
+  while (panel > 1 && (size_t)panel * m > LARGE_PANEL_SIZE) panel /= 2;
+  p->prPanel = MIN(panel, n / m);
+
+  p->instPR = INIT(m, NULL, NULL, (mode & ~(uint64_t)(SLEEF_MODE_BACKWARD | SLEEF_MODE_ALT | SLEEF_MODE_LARGE)) |
+		   SLEEF_MODE_NO_MT | (backward ? SLEEF_MODE_BACKWARD : 0));
+
+  if (p->instPR == NULL) {
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  real *lo, *hi;
+  p->prLog2Lo = (ilog2(n) + 1) / 2;
+  makeTwiddleTables(n, p->prLog2Lo, backward, &lo, &hi);
+  p->prTwLo = lo;
+  p->prTwHi = hi;
+
+  if (input) {
+    real *tw = (real *)Sleef_malloc(sizeof(real) * 2 * (size_t)(n / m) * nIn);
+    for(uint64_t ph=0;ph<n/m;ph++) {
+      for(uint64_t j=0;j<nIn;j++) {
+	real *t = &tw[(ph*nIn+j)*2];
+	t[0] = 1;
+	t[1] = 0;
+	twiddleAt(t, lo, hi, p->prLog2Lo, (j * (outStart + ph)) & (n - 1));
+      }
+    }
+    p->prTw = tw;
+  }
+
+  p->prBuf = allocBuffers(p->prNThread, 2 * m, mode);
+  p->prPanelBuf = allocBuffers(p->prNThread, 2 * (size_t)p->prPanel * m, mode);
+  if (!input) p->prAcc = allocBuffers(p->prNThread, 2 * outCount, mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) {
+    printf("Pruned %s : %u x %u, panel %u\n", input ? "input" : "output", (unsigned)(n / m), (unsigned)m, (unsigned)p->prPanel);
+  }
+
+  return p;
+}
+
+static size_t prunedAccSize(SleefDFT *p) {
+  return p->prInput ? 0 : wsRound(2 * p->prOutCount);
+}
+
+static size_t prunedWsSlice(SleefDFT *p) {
+  return wsRound(2 * p->prSubLen) + wsRound(2 * (size_t)p->prPanel * p->prSubLen) +
+    prunedAccSize(p) + wsSize(p->instPR);
+}
+
+// The buffers of the thread slot tn
+
+static void prunedBuffers(SleefDFT *p, real *ws, int tn, real **x, real **panel, real **acc, real **subws) {
+  if (ws != NULL) {
+    *x = ws + (p->prMT ? tn : 0) * prunedWsSlice(p);
+    *panel = *x + wsRound(2 * p->prSubLen);
+    *acc = *panel + wsRound(2 * (size_t)p->prPanel * p->prSubLen);
+    *subws = *acc + prunedAccSize(p);
+  } else {
+    *x = (real *)p->prBuf[tn];
+    *panel = (real *)p->prPanelBuf[tn];
+    *acc = p->prAcc == NULL ? NULL : (real *)p->prAcc[tn];
+    *subws = NULL;
+  }
+}
+
+typedef struct PrunedArg {
+  SleefDFT *p;
+  const real *s;
+  real *d, *ws;
+  uint32_t nBranch;
+} PrunedArg;
+
+static void prunedTask(void *ptr, int i) {
+  PrunedArg *a = (PrunedArg *)ptr;
+  SleefDFT *p = a->p;
+  const uint64_t m = p->prSubLen, L = p->prLength / m, nIn = p->prInCount, cnt = p->prOutCount;
+  const uint64_t k0 = p->prOutStart, mask = p->prLength - 1;
+  const uint64_t c0 = (uint64_t)i * p->prPanel, w = MIN(p->prPanel, a->nBranch - c0);
+  const real *lo = (const real *)p->prTwLo, *hi = (const real *)p->prTwHi;
+  const int log2lo = p->prLog2Lo;
+  real *x, *panel, *acc, *subws;
+
+  prunedBuffers(p, a->ws, Executor_slot(), &x, &panel, &acc, &subws);
+
+  // Phases c0 <= ph < c0 + w, whose inputs x[L*q+ph] are gathered in
+  // the rows of the panel. The bins are accumulated in the buffer of
+  // the slot.
+
+  for(uint64_t q0=0;q0<m;q0+=BS) {
+    for(uint64_t c=0;c<w;c++) {
+      for(uint64_t q=q0, j=q0*L+c0+c;q<q0+BS && q<m;q++, j+=L) {
+	if (j < nIn) {
+	  panel[(c*m+q)*2+0] = a->s[j*2+0];
+	  panel[(c*m+q)*2+1] = a->s[j*2+1];
+	  twiddleAt(&panel[(c*m+q)*2], lo, hi, log2lo, (j * k0) & mask);
+	} else {
+	  panel[(c*m+q)*2+0] = panel[(c*m+q)*2+1] = 0;
+	}
+      }
+    }
+  }
+
+  for(uint64_t c=0;c<w;c++) {
+    executeWS(p->instPR, &panel[c*m*2], x, subws);
+
+    for(uint64_t k=0;k<cnt;k++) {
+      twiddleAt(&x[k*2], lo, hi, log2lo, ((c0 + c) * k) & mask);
+      acc[k*2+0] += x[k*2+0];
+      acc[k*2+1] += x[k*2+1];
+    }
+  }
+}
+
+// Phases c0 <= ph < c0 + w of an input-pruned plan. The transform of
+// each phase is a row of the panel.
+
+static void prunedInputTask(void *ptr, int i) {
+  PrunedArg *a = (PrunedArg *)ptr;
+  SleefDFT *p = a->p;
+  const uint64_t m = p->prSubLen, L = p->prLength / m, nIn = p->prInCount, cnt = p->prOutCount;
+  const uint64_t c0 = (uint64_t)i * p->prPanel, w = MIN(p->prPanel, L - c0);
+  real *x, *panel, *acc, *subws;
+
+  prunedBuffers(p, a->ws, Executor_slot(), &x, &panel, &acc, &subws);
+
+  for(uint64_t c=0;c<w;c++) {
+    const real *tw = (const real *)p->prTw + (c0 + c) * nIn * 2, *s = a->s;
+    for(uint64_t j=0;j<nIn;j++) {
+      x[j*2+0] = s[j*2+0] * tw[j*2+0] - s[j*2+1] * tw[j*2+1];
+      x[j*2+1] = s[j*2+0] * tw[j*2+1] + s[j*2+1] * tw[j*2+0];
+    }
+    memset(&x[nIn*2], 0, sizeof(real) * 2 * (m - nIn));
+    executeWS(p->instPR, x, &panel[c*m*2], subws);
+  }
+
+  for(uint64_t q=0;q<m;q++) {
+    for(uint64_t c=0, b=c0+q*L;c<w && b<cnt;c++, b++) {
+      a->d[b*2+0] = panel[(c*m+q)*2+0];
+      a->d[b*2+1] = panel[(c*m+q)*2+1];
+    }
+  }
+}
+
+static void executePruned(SleefDFT *p, const real *s, real *d, real *ws) {
+  assert(s != d);
+
+  if (p->prInput) {
+    const int nth = p->prMT ? MIN(p->prNThread, Executor_threadCount()) : 1;
+    const uint32_t L = p->prLength / p->prSubLen;
+    PrunedArg a = { p, s, d, ws, L };
+    const int nTask = (L + p->prPanel - 1) / p->prPanel;
+
+    if (nth > 1 && nTask > 1) {
+      Executor_parallelFor(prunedInputTask, &a, nTask, nth);
+    } else {
+      for(int i=0;i<nTask;i++) prunedInputTask(&a, i);
+    }
+    return;
+  }
+
+  const int nth = p->prMT ? MIN(p->prNThread, Executor_threadCount()) : 1;
+  const uint32_t L = p->prLength / p->prSubLen, cnt = p->prOutCount;
+  const int nSlot = p->prMT || ws == NULL ? p->prNThread : 1;
+  real *x, *panel, *acc, *subws;
+
+  PrunedArg a = { p, s, d, ws, MIN(L, p->prInCount) };
+  const int nTask = (a.nBranch + p->prPanel - 1) / p->prPanel;
+
+  for(int t=0;t<nSlot;t++) {
+    prunedBuffers(p, ws, t, &x, &panel, &acc, &subws);
+    memset(acc, 0, sizeof(real) * 2 * cnt);
+  }
+
+  if (nth > 1 && nTask > 1) {
+    Executor_parallelFor(prunedTask, &a, nTask, nth);
+  } else {
+    for(int i=0;i<nTask;i++) prunedTask(&a, i);
+  }
+
+  memset(d, 0, sizeof(real) * 2 * cnt);
+  for(int t=0;t<nSlot;t++) {
+    prunedBuffers(p, ws, t, &x, &panel, &acc, &subws);
+    for(uint32_t k=0;k<2*cnt;k++) d[k] += acc[k];
+  }
+}
+
+// Goertzel evaluator
+
+// A Goertzel plan computes a few bins k of a transform of any length
+// n by the recurrence s[j] = 2 cos(t) s[j-1] - s[j-2] + x[j], where
+// e^(i t j) is the twiddle of bin k at sample j. The bin is then
+// e^(-i t) s[n-1] - s[n-2]. The error of this recurrence grows with
+// 1 / sin(t), so Reinsch's modification is run instead. With g = 1 if
+// cos(t) >= 0, and -1 otherwise,
+//
+//   d[j] = g d[j-1] + l s[j-1] + x[j], s[j] = g s[j-1] + d[j]
+//
+// where l = 2 cos(t) - 2 g is computed from the half angle, and the bin
+// is g d[n-1] + (l/2 - i sin(t)) s[n-1]. The recurrences of 2*VECWIDTH
+// bins are run in the lanes of a vector by the kernel of the best ISA,
+// two vectors at a time, and the bins are padded to a multiple of the
+// pair. The input is read in chunks that stay in the cache while all
+// pairs of a task are run over them.
+//
+// The error of a recurrence grows with the number of samples, so it is
+// restarted from a zero state every GOERTZEL_ANCHOR samples. The
+// partial bin at the end J of such a span weighs the sample j by
+// u^(J-j), where u is the twiddle of one sample, so it is multiplied by
+// u^(-J) = w^(k J mod n) and added to the bin in double precision.
+// w^m is the product of two entries of tables computed by SINCOSPI,
+// as in twiddleAt, but for any n. The coefficients are computed in
+// double precision too. The span is shorter in single precision,
+// where the error of a span of 2048 samples would exceed that of the
+// transform.
+//
+// A sliding window is advanced by one sample by adding the new sample
+// minus the old one to a bin and multiplying it by e^(-i t).
+
+#define GOERTZEL_CHUNK 2048
+
+// The buffer holds the states of the recurrences followed by the
+// bins in double precision
+
+static size_t goertzelBufLen(uint32_t padCount) {
+  return 4 * (size_t)padCount + 2 * (size_t)padCount * sizeof(double) / sizeof(real);
+}
+
+// Implementation of SleefDFT_*_init1dGoertzel
+
+EXPORT SleefDFT *INITGOERTZEL(uint32_t n, uint32_t nBins, const uint32_t *bins, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  const uint64_t unsupported = SLEEF_MODE_DCT | SLEEF_MODE_DST |
+    SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT | SLEEF_MODE_CORRELATE;
+  int valid = n != 0 && n <= INT32_MAX && nBins != 0 && bins != NULL && (mode & unsupported) == 0;
+
+  for(uint32_t b=0;valid && b<nBins;b++) valid = bins[b] < n;
+
+  if (!valid) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported Goertzel plan : %u, %u\n", (unsigned)n, (unsigned)nBins);
+    return NULL;
+  }
+
+  int bestPriority = -1, isa = -1;
+
+  for(int i=0;i<ISAMAX;i++) {
+    if (checkISAAvailability(i) && bestPriority < (*GETINT[i])(GETINT_DFTPRIORITY)) {
+      bestPriority = (*GETINT[i])(GETINT_DFTPRIORITY);
+      isa = i;
+    }
+  }
+
+  if (isa == -1) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("ISA not available\n");
+    return NULL;
+  }
+
+  const int backward = ((mode & SLEEF_MODE_BACKWARD) != 0) != ((mode & SLEEF_MODE_ALT) != 0);
+  const int vw = (*GETINT[isa])(GETINT_VECWIDTH);
+  const uint32_t padCount = (nBins + 4*vw - 1) / (4*vw) * (4*vw);
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICGZ;
+  p->baseTypeID = BASETYPEID;
+  p->mode = mode;
+  p->gzLength = n;
+  p->gzBinCount = nBins;
+  p->gzPadCount = padCount;
+  p->gzIsa = isa;
+  p->gzVecWidth = vw;
+  p->gzCplx = (mode & SLEEF_MODE_REAL) == 0;
+  p->gzNThread = Executor_slotCount();
+  p->gzMT = (mode & SLEEF_MODE_NO_MT) == 0;
+
+  // coef holds l of the 4*vw bins of a pair followed by their g
+
+  real *coef = (real *)Sleef_malloc(sizeof(real) * 2 * padCount);
+  real *sn = (real *)Sleef_malloc(sizeof(real) * nBins);
+  real *rot = (real *)Sleef_malloc(sizeof(real) * 4 * padCount);
+  uint32_t *bn = (uint32_t *)Sleef_malloc(sizeof(uint32_t) * nBins);
+  memset(rot, 0, sizeof(real) * 4 * padCount);
+
+  // tw holds w^m for 0 <= m < step followed by w^(step m) for
+  // 0 <= m <= n / step
+
+  uint32_t step = 1;
+  while ((uint64_t)step * step < n) step++;
+  double *tw = (double *)Sleef_malloc(sizeof(double) * 2 * (step + n / step + 1));
+
+  for(uint32_t m=0;m<step + n / step + 1;m++) {
+    const uint64_t e = m < step ? m : (uint64_t)(m - step) * step;
+    Sleef_double2 sc = Sleef_sincospi_u05((backward ? 2 : -2) * (double)e / n);
+    tw[m*2+0] = sc.y;
+    tw[m*2+1] = sc.x;
+  }
+
+  for(uint32_t b=0;b<padCount;b++) {
+    real *c = coef + b / (4*vw) * 8*vw + b % (4*vw);
+    c[0] = 0;
+    c[4*vw] = 1;
+    if (b >= nBins) continue;
+
+    const int64_t k = bins[b] > n/2 ? (int64_t)bins[b] - n : (int64_t)bins[b];
+    const double a = (backward ? 2 : -2) * (double)k / n;
+    Sleef_double2 sc = Sleef_sincospi_u05(a), sh = Sleef_sincospi_u05(a / 2);
+    c[0] = (real)(sc.y >= 0 ? -4 * sh.x * sh.x : 4 * sh.y * sh.y);
+    c[4*vw] = sc.y >= 0 ? 1 : -1;
+    sn[b] = (real)sc.x;
+    bn[b] = bins[b];
+    rot[b*2+0] = rot[b*2+1] = (real)sc.y;
+    rot[2*padCount + b*2+0] = rot[2*padCount + b*2+1] = (real)-sc.x;
+  }
+
+  p->gzCoef = coef;
+  p->gzSin = sn;
+  p->gzRot = rot;
+  p->gzBins = bn;
+  p->gzTw = tw;
+  p->gzTwStep = step;
+  if ((mode & SLEEF_MODE_NO_SCRATCH) == 0) p->gzBuf = Sleef_malloc(sizeof(real) * goertzelBufLen(padCount));
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) {
+    printf("Goertzel : %s %d bit %s, %u bins\n", (char *)(*GETPTR[isa])(0), (int)(vw * sizeof(real) * 16), BASETYPESTRING, (unsigned)nBins);
+  }
+
+  return p;
+}
+
+static size_t goertzelWsSize(SleefDFT *p) {
+  return wsRound(goertzelBufLen(p->gzPadCount));
+}
+
+// Adds the partial bins of the pair q, whose recurrences have run up
+// to the sample j, to acc, and clears their states
+
+static void goertzelAnchor(SleefDFT *p, real *st, double *acc, int q, uint64_t j) {
+  const uint32_t vw = p->gzVecWidth, n = p->gzLength, step = p->gzTwStep;
+  const uint32_t b0 = q * 4*vw, b1 = MIN(b0 + 4*vw, p->gzBinCount);
+  const real *coef = (const real *)p->gzCoef, *sn = (const real *)p->gzSin;
+  const uint32_t *bins = (const uint32_t *)p->gzBins;
+  const double *tw = (const double *)p->gzTw;
+  real *xq = st + (size_t)q * 16*vw;
+
+  for(uint32_t b=b0;b<b1;b++) {
+    const real *x = xq + (b - b0) / (2*vw) * 4*vw + b % (2*vw);
+    const real *c = coef + (size_t)q * 8*vw + (b - b0);
+    const double sr = x[0], dr = x[2*vw], si = p->gzCplx ? x[8*vw] : 0, di = p->gzCplx ? x[10*vw] : 0;
+    const double yr = c[4*vw] * dr + c[0] / 2 * sr + sn[b] * si;
+    const double yi = c[4*vw] * di + c[0] / 2 * si - sn[b] * sr;
+
+    const uint64_t m = bins[b] * j % n;
+    const double *tl = &tw[(m % step)*2], *th = &tw[(step + m / step)*2];
+    const double wr = th[0] * tl[0] - th[1] * tl[1], wi = th[0] * tl[1] + th[1] * tl[0];
+    acc[b*2+0] += yr * wr - yi * wi;
+    acc[b*2+1] += yr * wi + yi * wr;
+  }
+
+  memset(xq, 0, sizeof(real) * 16 * vw);
+}
+
+// Task i runs the pairs i * nPair / nTask <= q < (i+1) * nPair / nTask.
+// A pair is two vectors of the Goertzel kernel, or of the sliding
+// kernel, which holds half as many bins per vector.
+
+typedef struct GoertzelArg {
+  SleefDFT *p;
+  const real *s;
+  real *x;
+  uint32_t count;
+  int nPair, nTask;
+} GoertzelArg;
+
+static void goertzelTask(void *ptr, int i) {
+  GoertzelArg *a = (GoertzelArg *)ptr;
+  SleefDFT *p = a->p;
+  const int vw = p->gzVecWidth, q0 = i * a->nPair / a->nTask, q1 = (i+1) * a->nPair / a->nTask;
+  const int es = p->gzCplx ? 2 : 1;
+  double *acc = (double *)(a->x + 4 * (size_t)p->gzPadCount);
+
+  for(uint32_t j0=0;j0<p->gzLength;j0+=GOERTZEL_CHUNK) {
+    const int len = MIN(GOERTZEL_CHUNK, p->gzLength - j0);
+    for(int q=q0;q<q1;q++) {
+      for(int j1=0;j1<len;j1+=GOERTZEL_ANCHOR) {
+	const int len1 = MIN(GOERTZEL_ANCHOR, len - j1);
+	(*GOERTZEL[p->gzIsa])(a->x + (size_t)q * 16 * vw, (const real *)p->gzCoef + (size_t)q * 8 * vw, a->s + (size_t)(j0 + j1) * es, len1, p->gzCplx);
+	goertzelAnchor(p, a->x, acc, q, j0 + j1 + len1);
+      }
+    }
+  }
+}
+
+static void slideTask(void *ptr, int i) {
+  GoertzelArg *a = (GoertzelArg *)ptr;
+  SleefDFT *p = a->p;
+  const int vw = p->gzVecWidth, q0 = i * a->nPair / a->nTask, q1 = (i+1) * a->nPair / a->nTask;
+  const real *rc = (const real *)p->gzRot, *rs = rc + 2 * p->gzPadCount;
+
+  if (q0 == q1) return;
+
+  (*SLIDE[p->gzIsa])(a->x + (size_t)q0 * 4 * vw, rc + (size_t)q0 * 4 * vw, rs + (size_t)q0 * 4 * vw, (q1 - q0) * 2,
+		     a->s, p->gzLength, a->count, p->gzCplx);
+}
+
+static void goertzelRun(SleefDFT *p, void (*task)(void *, int), GoertzelArg *a) {
+  const int nth = p->gzMT ? MIN(p->gzNThread, Executor_threadCount()) : 1;
+  a->nTask = MIN(a->nPair, nth);
+
+  if (a->nTask > 1) {
+    Executor_parallelFor(task, a, a->nTask, a->nTask);
+  } else {
+    task(a, 0);
+  }
+}
+
+static void executeGoertzel(SleefDFT *p, const real *s, real *d, real *ws) {
+  const uint32_t vw = p->gzVecWidth;
+  real *st = ws != NULL ? ws : (real *)p->gzBuf;
+
+  memset(st, 0, sizeof(real) * goertzelBufLen(p->gzPadCount));
+
+  GoertzelArg a = { p, s, st, 0, p->gzPadCount / (4*vw), 1 };
+  goertzelRun(p, goertzelTask, &a);
+
+  const double *acc = (const double *)(st + 4 * (size_t)p->gzPadCount);
+  for(uint32_t k=0;k<2*p->gzBinCount;k++) d[k] = (real)acc[k];
+}
+
+static void executeSlide(SleefDFT *p, const real *in, uint32_t count, real *bins, real *ws) {
+  const uint32_t vw = p->gzVecWidth;
+  real *x = ws != NULL ? ws : (real *)p->gzBuf;
+
+  memcpy(x, bins, sizeof(real) * 2 * p->gzBinCount);
+  memset(x + 2 * p->gzBinCount, 0, sizeof(real) * 2 * (p->gzPadCount - p->gzBinCount));
+
+  for(uint32_t j0=0;j0<count;j0+=GOERTZEL_CHUNK) {
+    GoertzelArg a = { p, in + (size_t)j0 * (p->gzCplx ? 2 : 1), x, MIN(GOERTZEL_CHUNK, count - j0), p->gzPadCount / (2*vw), 1 };
+    goertzelRun(p, slideTask, &a);
+  }
+
+  memcpy(bins, x, sizeof(real) * 2 * p->gzBinCount);
+}
+
+// Chirp-z transform
+
+// A chirp-z plan computes m bins at the frequencies f0 + k df,
+// counted in cycles per sample, of n complex samples:
+//
+//   X[k] = sum_j x[j] exp(-2 pi i (f0 + k df) j)
+//
+// As in the Bluestein planner, 2 j k = j^2 + k^2 - (k-j)^2 turns the
+// sum into a convolution with the chirp exp(pi i df t^2), for
+// -(n-1) <= t < m. It is carried out with power-of-two plans of length
+// L >= n + m - 1, and the transform of the chirp is prescaled by 1/L.
+// The input is multiplied by exp(-pi i (2 f0 j + df j^2)) before the
+// convolution, and the output by exp(-pi i df k^2) after it.
+
+// Implementation of SleefDFT_*_init1dChirpZ
+
+EXPORT SleefDFT *INITCHIRPZ(uint32_t n, uint32_t m, real f0, real df, uint64_t mode) {
+  if (!realtimeMode(&mode)) return NULL;
+  const uint64_t unsupported = SLEEF_MODE_REAL | SLEEF_MODE_DCT | SLEEF_MODE_DST |
+    SLEEF_MODE_SPLIT_IN | SLEEF_MODE_SPLIT_OUT | SLEEF_MODE_CORRELATE;
+
+  if (n == 0 || m == 0 || (uint64_t)n + m - 1 > (UINT32_C(1) << 31) || !isfinite(f0) || !isfinite(df) || (mode & unsupported) != 0) {
+    if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Unsupported chirp-z transform : %u, %u\n", (unsigned)n, (unsigned)m);
+    return NULL;
+  }
+
+  uint32_t len = 2;
+  while(len < n + m - 1) len <<= 1;
+
+  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
+  p->magic = MAGICCZ;
+  p->baseTypeID = BASETYPEID;
+  p->mode = mode;
+  p->czLength = n;
+  p->czOutCount = m;
+  p->czLength2 = len;
+
+  uint64_t mode1D = mode & ~(uint64_t)(SLEEF_MODE_BACKWARD | SLEEF_MODE_ALT);
+
+  p->instCZF = INIT(len, NULL, NULL, mode1D);
+  p->instCZB = INIT(len, NULL, NULL, mode1D | SLEEF_MODE_BACKWARD);
+
+  if (p->instCZF == NULL || p->instCZB == NULL) {
+    if (p->instCZF != NULL) SleefDFT_dispose(p->instCZF);
+    if (p->instCZB != NULL) SleefDFT_dispose(p->instCZB);
+    p->magic = 0;
+    free(p);
+    return NULL;
+  }
+
+  const double sign = ((mode & SLEEF_MODE_BACKWARD) != 0) != ((mode & SLEEF_MODE_ALT) != 0) ? 1 : -1;
+
+  real *pre = (real *)Sleef_malloc(sizeof(real) * 2 * n);
+  for(uint32_t j=0;j<n;j++) chirpAt(&pre[j*2], sign * (phaseMod2(2 * (double)f0, j) + phaseMod2(df, (uint64_t)j * j)));
+  p->czPre = pre;
+
+  real *post = (real *)Sleef_malloc(sizeof(real) * 2 * m);
+  for(uint32_t k=0;k<m;k++) chirpAt(&post[k*2], sign * phaseMod2(df, (uint64_t)k * k));
+  p->czPost = post;
+
+  real *kernel = (real *)Sleef_malloc(sizeof(real) * 2 * len);
+  real *t = (real *)memset(Sleef_malloc(sizeof(real) * 2 * len), 0, sizeof(real) * 2 * len);
+  for(uint32_t k=0;k<m;k++) chirpAt(&t[k*2], -sign * phaseMod2(df, (uint64_t)k * k));
+  for(uint32_t j=1;j<n;j++) chirpAt(&t[(len-j)*2], -sign * phaseMod2(df, (uint64_t)j * j));
+  EXECUTE(p->instCZF, t, kernel);
+  for(uint32_t k=0;k<2*len;k++) kernel[k] *= (real)1.0 / len;
+  Sleef_free(t);
+  p->czKernel = kernel;
+
+  p->czNThread = Executor_slotCount();
+
+  p->czBuf0 = allocBuffers(p->czNThread, 2 * len, mode);
+  p->czBuf1 = allocBuffers(p->czNThread, 2 * len, mode);
+
+  if ((mode & SLEEF_MODE_VERBOSE) != 0) printf("Chirp-z : %u -> %u, %u\n", (unsigned)n, (unsigned)len, (unsigned)m);
+
+  return p;
+}
+
+static void executeChirpZ(SleefDFT *p, const real *s, real *d, real *ws) {
+  const uint32_t n = p->czLength, m = p->czOutCount, len = p->czLength2;
+  const real *pre = (const real *)p->czPre, *post = (const real *)p->czPost, *kernel = (const real *)p->czKernel;
+  real *x0, *x1, *subws = NULL;
+
+  if (ws != NULL) {
+    x0 = ws;
+    x1 = ws + wsRound(2 * len);
+    subws = ws + 2 * wsRound(2 * len);
+  } else {
+    const int tn = Executor_slot();
+    x0 = (real *)p->czBuf0[tn];
+    x1 = (real *)p->czBuf1[tn];
+  }
+
+  for(uint32_t j=0;j<n;j++) {
+    real xr = s[j*2+0], xi = s[j*2+1];
+    x0[j*2+0] = xr * pre[j*2+0] - xi * pre[j*2+1];
+    x0[j*2+1] = xr * pre[j*2+1] + xi * pre[j*2+0];
+  }
+  memset(&x0[n*2], 0, sizeof(real) * 2 * (len - n));
+
+  executeWS(p->instCZF, x0, x1, subws);
+
+  for(uint32_t k=0;k<len;k++) {
+    real xr = x1[k*2+0], xi = x1[k*2+1];
+    x1[k*2+0] = xr * kernel[k*2+0] - xi * kernel[k*2+1];
+    x1[k*2+1] = xr * kernel[k*2+1] + xi * kernel[k*2+0];
+  }
+
+  executeWS(p->instCZB, x1, x0, subws);
+
+  for(uint32_t k=0;k<m;k++) {
+    real xr = x0[k*2+0], xi = x0[k*2+1];
+    d[k*2+0] = xr * post[k*2+0] - xi * post[k*2+1];
+    d[k*2+1] = xr * post[k*2+1] + xi * post[k*2+0];
+  }
+}
+
+// Workspace size in reals
+
+static size_t wsSize(SleefDFT *p) {
+  switch(p->magic) {
+  case MAGIC:
+    return p->log2len <= 1 ? 0 : 2 * wsRound(2 << p->log2len);
+  case MAGIC2D:
+    return wsRound(2 * (size_t)p->hlen * p->vlen) +
+      ((p->mode3 & SLEEF_MODE3_MT2D) != 0 ? p->tNThread : 1) * ws2DSlice(p);
+  case MAGICMR:
+    return 2 * wsRound(2 * p->length) + (p->instSub == NULL ? 0 : wsSize(p->instSub));
+  case MAGICBS:
+    return 2 * wsRound(2 * p->bsLength2) + MAX(wsSize(p->instF), wsSize(p->instB));
+  case MAGICRR:
+    return 2 * wsRound(p->rrLength + 2) + wsSize(p->instReal);
+  case MAGICBT:
+    return (p->btMT ? p->btNThread : 1) * batchWsSlice(p);
+  case MAGICND:
+    return ndWsShared(p) + (p->ndMT ? p->ndNThread : 1) * ndWsSlice(p);
+  case MAGICR2D:
+    return real2DWsShared(p) + (p->r2MT ? p->r2NThread : 1) * real2DWsSlice(p);
+  case MAGICSP:
+    return splitWsShared(p) + wsSize(p->instSplit);
+  case MAGICFM:
+    return formatWsShared(p) + wsSize(p->instFormat);
+  case MAGICCV:
+    return 2 * wsRound(2 * p->cvLength + 2) + MAX(wsSize(p->instCF), wsSize(p->instCB));
+  case MAGICST:
+    return (p->stMT ? p->stNThread : 1) * stftWsSlice(p);
+  case MAGICLG:
+    return (p->lgMT ? p->lgNThread : 1) * largeWsSlice(p);
+  case MAGICPR:
+    return (p->prMT ? p->prNThread : 1) * prunedWsSlice(p);
+  case MAGICGZ:
+    return goertzelWsSize(p);
+  case MAGICCZ:
+    return 2 * wsRound(2 * p->czLength2) + MAX(wsSize(p->instCZF), wsSize(p->instCZB));
+  }
+  return 0;
+}
+
+// Implementation of SleefDFT_*_getWorkspaceSize
+
+EXPORT size_t WSSIZE(SleefDFT *p) {
+  return sizeof(real) * wsSize(p);
+}
+
+// Implementation of SleefDFT_*_execute
+
+// Transforms of length 1 or 2, and real transforms of length 2 or 4
 
-  p->x0 = malloc(sizeof(real *) * p->nThread);
-  p->x1 = malloc(sizeof(real *) * p->nThread);
+// Multiplies n reals by the two planes of weights in the same way as
+// loadiow in vectortype.h, or by the plane of a real window
 
-  for(int i=0;i<p->nThread;i++) {
-    p->x0[i] = (real *)Sleef_malloc(sizeof(real) * 2 * n);
-    p->x1[i] = (real *)Sleef_malloc(sizeof(real) * 2 * n);
+static void applyWeights(real *d, const real *s, const real *w, const int winReal, const int n) {
+  if (winReal) {
+    for(int i=0;i<n;i++) d[i] = s[i] * w[i];
+    return;
   }
-  
-  if ((mode & SLEEF_MODE_REAL) != 0) {
-    p->rtCoef0 = (real *)Sleef_malloc(sizeof(real) * n);
-    p->rtCoef1 = (real *)Sleef_malloc(sizeof(real) * n);
 
-    if ((mode & SLEEF_MODE_BACKWARD) == 0) {
-      for(uint32_t i=0;i<n/2;i++) {
-	sc_t sc = SINCOSPI(i*((real)-1.0/n));
-	((real *)p->rtCoef0)[i*2+0] = ((real *)p->rtCoef0)[i*2+1] = (real)0.5 - (real)0.5 * sc.x;
-	((real *)p->rtCoef1)[i*2+0] = ((real *)p->rtCoef1)[i*2+1] = (real)0.5*sc.y;
+  const real *wi = w + n;
+  for(int i=0;i<n;i+=2) {
+    real xr = s[i+0], xi = s[i+1];
+    d[i+0] = xr * w[i+0] - xi * wi[i+0];
+    d[i+1] = xi * w[i+1] + xr * wi[i+1];
+  }
+}
+
+static void executeTiny(SleefDFT *p, const real *s, real *d) {
+  if ((p->mode & SLEEF_MODE_REAL) == 0) {
+    real r0 = s[0] + s[2];
+    real r1 = s[1] + s[3];
+    real r2 = s[0] - s[2];
+    real r3 = s[1] - s[3];
+    d[0] = r0; d[1] = r1; d[2] = r2; d[3] = r3;
+  } else {
+    if ((p->mode & SLEEF_MODE_ALT) == 0) {
+      if (p->log2len == 1) {
+	if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
+	  real r0 = s[0] + s[2] + (s[1] + s[3]);
+	  real r1 = s[0] + s[2] - (s[1] + s[3]);
+	  real r2 = s[0] - s[2];
+	  real r3 = s[3] - s[1];
+	  d[0] = r0; d[1] = 0; d[2] = r2; d[3] = r3; d[4] = r1; d[5] = 0;
+	} else {
+	  real r0 = (s[0] + s[4])*(real)0.5 + s[2];
+	  real r1 = (s[0] - s[4])*(real)0.5 - s[3];
+	  real r2 = (s[0] + s[4])*(real)0.5 - s[2];
+	  real r3 = (s[0] - s[4])*(real)0.5 + s[3];
+	  d[0] = r0*2; d[1] = r1*2; d[2] = r2*2; d[3] = r3*2;
+	}
+      } else {
+	if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
+	  real r0 = s[0] + s[1];
+	  real r1 = s[0] - s[1];
+	  d[0] = r0; d[1] = 0; d[2] = r1; d[3] = 0;
+	} else {
+	  real r0 = s[0] + s[2];
+	  real r1 = s[0] - s[2];
+	  d[0] = r0; d[1] = r1;
+	}
       }
     } else {
-      for(uint32_t i=0;i<n/2;i++) {
-	sc_t sc = SINCOSPI(i*((real)-1.0/n));
-	((real *)p->rtCoef0)[i*2+0] = ((real *)p->rtCoef0)[i*2+1] = (real)0.5 + (real)0.5 * sc.x;
-	((real *)p->rtCoef1)[i*2+0] = ((real *)p->rtCoef1)[i*2+1] = (real)0.5*sc.y;
+      if (p->log2len == 1) {
+	if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
+	  real r0 = s[0] + s[2] + (s[1] + s[3]);
+	  real r1 = s[0] + s[2] - (s[1] + s[3]);
+	  real r2 = s[0] - s[2];
+	  real r3 = s[1] - s[3];
+	  d[0] = r0; d[1] = r1; d[2] = r2; d[3] = r3;
+	} else {
+	  real r0 = (s[0] + s[1])*(real)0.5 + s[2];
+	  real r1 = (s[0] - s[1])*(real)0.5 + s[3];
+	  real r2 = (s[0] + s[1])*(real)0.5 - s[2];
+	  real r3 = (s[0] - s[1])*(real)0.5 - s[3];
+	  d[0] = r0; d[1] = r1; d[2] = r2; d[3] = r3;
+	}
+      } else {
+	real c = ((p->mode & SLEEF_MODE_BACKWARD) != 0) ? (real)0.5 : (real)1.0;
+	real r0 = s[0] + s[1];
+	real r1 = s[0] - s[1];
+	d[0] = r0 * c; d[1] = r1 * c;
       }
     }
   }
+}
 
-  // Measure
-  
-  int sign = (mode & SLEEF_MODE_BACKWARD) != 0 ? -1 : 1;
-  
-  p->vecwidth = (*GETINT[p->isa])(GETINT_VECWIDTH);
-  p->log2vecwidth = ilog2(p->vecwidth);
+// The path measured by the background planner is used once it is ready
 
-  for(int i=1;i<=MAXBUTWIDTH;i++) {
-    ((real ***)p->tbl)[i] = makeTable(sign, p->vecwidth, p->log2len, i, constK[i]);
+static SleefDFT *activePath(SleefDFT *p) {
+#ifdef ENABLE_PTHREAD
+  if (p->planner != NULL) {
+    SleefDFT *r = __atomic_load_n(&p->planner->path, __ATOMIC_ACQUIRE);
+    if (r != NULL) return r;
   }
+#endif
+  return p;
+}
 
-  if (!measure(p, (mode & SLEEF_MODE_DEBUG))) {
-    // Fall back to the first ISA
-    freeTables(p);
-    p->isa = 0;
+// Returns 1 if executeIO can run the plan
 
-    p->vecwidth = (*GETINT[p->isa])(GETINT_VECWIDTH);
-    p->log2vecwidth = ilog2(p->vecwidth);
+static int ioAvailable(SleefDFT *p) {
+  return p->magic == MAGIC && (p->mode & SLEEF_MODE_REAL) == 0 && p->log2len > 1 && p->winTbl == NULL;
+}
 
-    for(int i=1;i<=MAXBUTWIDTH;i++) {
-      ((real ***)p->tbl)[i] = makeTable(sign, p->vecwidth, p->log2len, i, constK[i]);
-    }
+// Runs the butterfly stages of a plan like executeWS, except that the
+// first stage reads the input in io and the last stage writes the
+// output in io, so that neither side is converted in a separate pass.
+// A side in FORMAT_REAL is the interleaved array in s0 or d0. The
+// intermediate stages alternate between the two buffers of the
+// calling thread.
 
-    for(int level = p->log2len;level >= 1;) {
-      int N = ABS(p->bestPath[level]);
-      if (level == N) { level -= N; continue; }
+static void executeIO(SleefDFT *p, const KernelIO *io, real *ws) {
+  assert(ioAvailable(p));
 
-      int i1 = 0;
-      for(int i0=0;i0 < (1 << (p->log2len-N));i0+=p->vecwidth, i1++) {
-	p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
-      }
-      for(;i1 < (1 << p->log2len) + 8;i1++) p->perm[level][i1] = 0;
+  const int tn = Executor_slot();
+  real *t[] = { ws == NULL ? p->x0[tn] : ws, ws == NULL ? p->x1[tn] : ws + wsRound(2 << p->log2len) };
+  SleefDFT *path = activePath(p);
+  const real scale = p->hasScale ? (real)p->outScale : 1;
 
-      level -= N;
-    }  
+  const real *lb = (const real *)io->s0;
+  int nb = 0;
 
-    if (!measure(p, (mode & SLEEF_MODE_DEBUG))) {
-      if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("Suitable ISA not found. This should not happen.\n");
-      return NULL;
-    }
-  }
-  
   for(int level = p->log2len;level >= 1;) {
-    int N = ABS(p->bestPath[level]);
-    if (level == N) { level -= N; continue; }
-
-    int i1 = 0;
-    for(int i0=0;i0 < (1 << (p->log2len-N));i0+=p->vecwidth, i1++) {
-      p->perm[level][i1] = 2*perm(p->log2len, i0, p->log2len-level, p->log2len-(level-N));
-    }
-    for(;i1 < (1 << p->log2len) + 8;i1++) p->perm[level][i1] = 0;
-
+    const int N = ABS(path->bestPath[level]), config = path->bestPathConfig[level];
+    const int first = level == (int)p->log2len, last = level == N;
+    const int conv = (first && io->fmtIn != FORMAT_REAL) || (last && io->fmtOut != FORMAT_REAL);
+    dispatchFused(path, N, last ? (real *)io->d0 : t[nb], lb, level, config, NULL, 0, last && p->hasScale ? &scale : NULL, conv ? io : NULL);
     level -= N;
-  }  
-  
-  if ((p->mode & SLEEF_MODE_VERBOSE) != 0) printf("ISA : %s %d bit %s\n", (char *)(*GETPTR[p->isa])(0), (int)(GETINT[p->isa](GETINT_VECWIDTH) * sizeof(real) * 16), BASETYPESTRING);
-
-  return p;
+    lb = t[nb];
+    nb ^= 1;
+  }
 }
 
-// Implementation of SleefDFT_*_init2d
-
-EXPORT SleefDFT *INIT2D(uint32_t vlen, uint32_t hlen, const real *in, real *out, uint64_t mode) {
-  SleefDFT *p = (SleefDFT *)calloc(1, sizeof(SleefDFT));
-  p->magic = MAGIC2D;
-  p->mode = mode;
-  p->baseTypeID = BASETYPEID;
-  p->in = in;
-  p->out = out;
-  p->hlen = hlen;
-  p->log2hlen = ilog2(hlen);
-  p->vlen = vlen;
-  p->log2vlen = ilog2(vlen);
-  
-  uint64_t mode1D = mode;
-  mode1D |= SLEEF_MODE_NO_MT;
+static void executeWS(SleefDFT *p, const real *s, real *d, real *ws) {
+  if (p->magic == MAGICMR) {
+    executeMixedRadix(p, s, d, ws);
+    return;
+  }
 
-  if ((mode & SLEEF_MODE_NO_MT) == 0) p->mode3 |= SLEEF_MODE3_MT2D;
-  
-  p->instH = p->instV = INIT(hlen, NULL, NULL, mode1D);
-  if (hlen != vlen) p->instV = INIT(vlen, NULL, NULL, mode1D);
+  if (p->magic == MAGICBS) {
+    executeBluestein(p, s, d, ws);
+    return;
+  }
 
-  p->tBuf = (void *)Sleef_malloc(sizeof(real)*2*hlen*vlen);
+  if (p->magic == MAGICRR) {
+    executeR2R(p, s, d, ws);
+    return;
+  }
 
-  measureTranspose(p);
-  
-  return p;
-}
+  if (p->magic == MAGICBT) {
+    executeBatch(p, s, d, ws);
+    return;
+  }
 
-// Implementation of SleefDFT_*_execute
+  if (p->magic == MAGICND) {
+    executeND(p, s, d, ws);
+    return;
+  }
 
-EXPORT void EXECUTE(SleefDFT *p, const real *s0, real *d0) {
-  assert(p != NULL && (p->magic == MAGIC || p->magic == MAGIC2D));
+  if (p->magic == MAGICR2D) {
+    executeReal2D(p, s, d, ws);
+    return;
+  }
 
-  const real *s = s0 == NULL ? p->in : s0;
-  real *d = d0 == NULL ? p->out : d0;
+  if (p->magic == MAGICSP) {
+    executeSplit(p, s, s + p->spTotal, d, d + p->spTotal, ws);
+    return;
+  }
 
-  if (p->magic == MAGIC2D) {
-  // S -> T -> D -> T -> D
-
-    real *tBuf = (real *)(p->tBuf);
-
-#ifdef _OPENMP
-    if ((p->mode3 & SLEEF_MODE3_MT2D) != 0 &&
-	(((p->mode & SLEEF_MODE_DEBUG) == 0 && p->tmMT < p->tmNoMT) ||
-	 ((p->mode & SLEEF_MODE_DEBUG) != 0 && (rand() & 1))))
-      {
-	int y=0;
-#pragma omp parallel for
-	for(y=0;y<p->vlen;y++) {
-	  EXECUTE(p->instH, &s[p->hlen*2*y], &tBuf[p->hlen*2*y]);
-	}
+  if (p->magic == MAGICFM) {
+    executeFormat(p, s, d, ws);
+    return;
+  }
 
-	transposeMT(d, tBuf, p->log2vlen, p->log2hlen);
+  if (p->magic == MAGICCV) {
+    executeConv(p, s, d, ws);
+    return;
+  }
 
-#pragma omp parallel for
-	for(y=0;y<p->hlen;y++) {
-	  EXECUTE(p->instV, &d[p->vlen*2*y], &tBuf[p->vlen*2*y]);
-	}
+  if (p->magic == MAGICLG) {
+    executeLarge(p, s, d, ws);
+    return;
+  }
 
-	transposeMT(d, tBuf, p->log2hlen, p->log2vlen);
-      } else
-#endif
-      {
-	for(int y=0;y<p->vlen;y++) {
-	  EXECUTE(p->instH, &s[p->hlen*2*y], &tBuf[p->hlen*2*y]);
-	}
+  if (p->magic == MAGICPR) {
+    executePruned(p, s, d, ws);
+    return;
+  }
 
-	transpose(d, tBuf, p->log2vlen, p->log2hlen);
+  if (p->magic == MAGICGZ) {
+    executeGoertzel(p, s, d, ws);
+    return;
+  }
 
-	for(int y=0;y<p->hlen;y++) {
-	  EXECUTE(p->instV, &d[p->vlen*2*y], &tBuf[p->vlen*2*y]);
-	}
+  if (p->magic == MAGICCZ) {
+    executeChirpZ(p, s, d, ws);
+    return;
+  }
 
-	transpose(d, tBuf, p->log2hlen, p->log2vlen);
-      }
+  if (p->magic == MAGICST) {
+    executeSTFT(p, s, 0, (p->stRingLen - p->stLength) / p->stHop + 1, d, ws);
+    return;
+  }
 
+  if (p->magic == MAGIC2D) {
+    execute2D(p, s, d, ws, strategy2D(p));
     return;
   }
   
+  const real scale = p->hasScale ? (real)p->outScale : 1;
+
   if (p->log2len <= 1) {
-    if ((p->mode & SLEEF_MODE_REAL) == 0) {
-      real r0 = s[0] + s[2];
-      real r1 = s[1] + s[3];
-      real r2 = s[0] - s[2];
-      real r3 = s[1] - s[3];
-      d[0] = r0; d[1] = r1; d[2] = r2; d[3] = r3;
-    } else {
-      if ((p->mode & SLEEF_MODE_ALT) == 0) {
-	if (p->log2len == 1) {
-	  if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
-	    real r0 = s[0] + s[2] + (s[1] + s[3]);
-	    real r1 = s[0] + s[2] - (s[1] + s[3]);
-	    real r2 = s[0] - s[2];
-	    real r3 = s[3] - s[1];
-	    d[0] = r0; d[1] = 0; d[2] = r2; d[3] = r3; d[4] = r1; d[5] = 0;
-	  } else {
-	    real r0 = (s[0] + s[4])*(real)0.5 + s[2];
-	    real r1 = (s[0] - s[4])*(real)0.5 - s[3];
-	    real r2 = (s[0] + s[4])*(real)0.5 - s[2];
-	    real r3 = (s[0] - s[4])*(real)0.5 + s[3];
-	    d[0] = r0*2; d[1] = r1*2; d[2] = r2*2; d[3] = r3*2;
-	  }
-	} else {
-	  if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
-	    real r0 = s[0] + s[1];
-	    real r1 = s[0] - s[1];
-	    d[0] = r0; d[1] = 0; d[2] = r1; d[3] = 0;
-	  } else {
-	    real r0 = s[0] + s[2];
-	    real r1 = s[0] - s[2];
-	    d[0] = r0; d[1] = r1;
-	  }
-	}
-      } else {
-	if (p->log2len == 1) {
-	  if ((p->mode & SLEEF_MODE_BACKWARD) == 0) {
-	    real r0 = s[0] + s[2] + (s[1] + s[3]);
-	    real r1 = s[0] + s[2] - (s[1] + s[3]);
-	    real r2 = s[0] - s[2];
-	    real r3 = s[1] - s[3];
-	    d[0] = r0; d[1] = r1; d[2] = r2; d[3] = r3;
-	  } else {
-	    real r0 = (s[0] + s[1])*(real)0.5 + s[2];
-	    real r1 = (s[0] - s[1])*(real)0.5 + s[3];
-	    real r2 = (s[0] + s[1])*(real)0.5 - s[2];
-	    real r3 = (s[0] - s[1])*(real)0.5 - s[3];
-	    d[0] = r0; d[1] = r1; d[2] = r2; d[3] = r3;
-	  }
-	} else {
-	  real c = ((p->mode & SLEEF_MODE_BACKWARD) != 0) ? (real)0.5 : (real)1.0;
-	  real r0 = s[0] + s[1];
-	  real r1 = s[0] - s[1];
-	  d[0] = r0 * c; d[1] = r1 * c;
-	}
-      }
+    real sw[4];
+
+    if (p->winTbl != NULL) {
+      applyWeights(sw, s, (const real *)p->winTbl, p->winReal, 2 << p->log2len);
+      s = sw;
+    }
+
+    executeTiny(p, s, d);
+
+    if (p->hasScale) {
+      const int n = (2 << p->log2len) +
+	((p->mode & (SLEEF_MODE_REAL | SLEEF_MODE_BACKWARD | SLEEF_MODE_ALT)) == SLEEF_MODE_REAL ? 2 : 0);
+      for(int i=0;i<n;i++) d[i] *= scale;
     }
     return;
   }
 
   //
 
-#ifdef _OPENMP
-  const int tn = omp_get_thread_num();
-  real *t[] = { p->x1[tn], p->x0[tn], d };
-#else
-  real *t[] = { p->x1[0], p->x0[0], d };
-#endif
-  
-  const real *lb = s;
+  const int tn = Executor_slot();
+  real *t[] = { ws == NULL ? p->x1[tn] : ws + wsRound(2 << p->log2len), ws == NULL ? p->x0[tn] : ws, d };
+  SleefDFT *path = activePath(p);
+
   int nb = 0;
 
-  if ((p->mode & SLEEF_MODE_REAL) != 0 && (p->pathLen & 1) == 0 &&
+  if ((p->mode & SLEEF_MODE_REAL) != 0 && (path->pathLen & 1) == 0 &&
       ((p->mode & SLEEF_MODE_BACKWARD) != 0) != ((p->mode & SLEEF_MODE_ALT) != 0)) nb = -1;
-  if ((p->mode & SLEEF_MODE_REAL) == 0 && (p->pathLen & 1) == 1) nb = -1;
+  if ((p->mode & SLEEF_MODE_REAL) == 0 && (path->pathLen & 1) == 1) nb = -1;
+
+  // The input weights are applied by the first butterfly stage. If
+  // the first stage is the only stage, they are applied into the
+  // buffer that the first stage does not write. SETWINDOW rejects
+  // weights for the plans that start with the real preprocessing.
+
+  const real *win = (const real *)p->winTbl;
+
+  if (win != NULL && ABS(path->bestPath[p->log2len]) == (int)p->log2len) {
+    real *sw = t[(nb+1) ^ 1];
+    applyWeights(sw, s, win, p->winReal, 2 << p->log2len);
+    s = sw;
+    win = NULL;
+  }
+
+  const real *lb = s;
+
+  // The real preprocessing multiplies the half spectrum by the input
+  // weights in specTbl, in the same layout as the output weights of
+  // the real postprocessing.
   
   if ((p->mode & SLEEF_MODE_REAL) != 0 &&
       ((p->mode & SLEEF_MODE_BACKWARD) != 0) != ((p->mode & SLEEF_MODE_ALT) != 0)) {
-    (*REALSUB1[p->isa])(t[nb+1], s, p->log2len, p->rtCoef0, p->rtCoef1, (p->mode & SLEEF_MODE_ALT) == 0);
-    if ((p-> mode & SLEEF_MODE_ALT) == 0) t[nb+1][(1 << p->log2len)+1] = -s[(1 << p->log2len)+1] * 2;
+    (*REALSUB1[p->isa])(t[nb+1], s, p->log2len, p->rtCoef0, p->rtCoef1, (p->mode & SLEEF_MODE_ALT) == 0, (const real *)p->specTbl);
+    if ((p-> mode & SLEEF_MODE_ALT) == 0) t[nb+1][(1 << p->log2len)+1] = -t[nb+1][(1 << p->log2len)+1];
     lb = t[nb+1];
     nb = (nb + 1) & 1;
   }
 
+  // The scale factor is applied by the last butterfly stage, or by the
+  // real postprocessing if there is one. The real postprocessing also
+  // applies the output weights.
+
+  const int post = (p->mode & SLEEF_MODE_REAL) != 0 &&
+    ((p->mode & SLEEF_MODE_BACKWARD) == 0) != ((p->mode & SLEEF_MODE_ALT) != 0);
+
   for(int level = p->log2len;level >= 1;) {
-    int N = ABS(p->bestPath[level]), config = p->bestPathConfig[level];
-    dispatch(p, N, t[nb+1], lb, level, config);
+    int N = ABS(path->bestPath[level]), config = path->bestPathConfig[level];
+    dispatchFused(path, N, t[nb+1], lb, level, config, level == (int)p->log2len ? win : NULL, p->winReal,
+		  level == N && !post && p->hasScale ? &scale : NULL, NULL);
     level -= N;
     lb = t[nb+1];
     nb = (nb + 1) & 1;
   }
 
-  if ((p->mode & SLEEF_MODE_REAL) != 0 && 
-      ((p->mode & SLEEF_MODE_BACKWARD) == 0) != ((p->mode & SLEEF_MODE_ALT) != 0)) {
-    (*REALSUB0[p->isa])(d, lb, p->log2len, p->rtCoef0, p->rtCoef1);
+  if (post) {
+    (*REALSUB0[p->isa])(d, lb, p->log2len, p->rtCoef0, p->rtCoef1, scale, (const real *)p->specTbl);
     if ((p->mode & SLEEF_MODE_ALT) == 0) {
       d[(1 << p->log2len)+1] = -d[(1 << p->log2len)+1];
       d[(2 << p->log2len)+0] =  d[1];
@@ -1439,3 +4988,210 @@ EXPORT void EXECUTE(SleefDFT *p, const real *s0, real *d0) {
     }
   }
 }
+
+#define EXECUTE_ASSERT(p)						\
+  assert(p != NULL && (p->magic == MAGIC || p->magic == MAGIC2D || p->magic == MAGICMR || p->magic == MAGICBS || \
+		       p->magic == MAGICBT || p->magic == MAGICND || p->magic == MAGICR2D || p->magic == MAGICRR || \
+		       p->magic == MAGICSP || p->magic == MAGICCV || p->magic == MAGICST || \
+		       p->magic == MAGICLG || p->magic == MAGICPR || p->magic == MAGICGZ || \
+		       p->magic == MAGICCZ || p->magic == MAGICFM))
+
+EXPORT void EXECUTE(SleefDFT *p, const real *s0, real *d0) {
+  EXECUTE_ASSERT(p);
+
+  const real *s = s0 == NULL ? p->in : s0;
+  real *d = d0 == NULL ? p->out : d0;
+
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    real *ws = (real *)Sleef_malloc(sizeof(real) * (wsSize(p) + WS_ALIGN));
+    executeWS(p, s, d, ws);
+    Sleef_free(ws);
+    return;
+  }
+
+  executeWS(p, s, d, NULL);
+}
+
+// Implementation of SleefDFT_*_execute_ws
+
+EXPORT void EXECUTEWS(SleefDFT *p, const real *s0, real *d0, void *ws) {
+  EXECUTE_ASSERT(p);
+
+  if (ws == NULL) {
+    EXECUTE(p, s0, d0);
+    return;
+  }
+
+  executeWS(p, s0 == NULL ? p->in : s0, d0 == NULL ? p->out : d0, (real *)ws);
+}
+
+// Implementation of SleefDFT_*_execute_split
+
+EXPORT void EXECUTESPLIT(SleefDFT *p, const real *sRe, const real *sIm, real *dRe, real *dIm) {
+  assert(p != NULL && p->magic == MAGICSP);
+
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    real *ws = (real *)Sleef_malloc(sizeof(real) * (wsSize(p) + WS_ALIGN));
+    executeSplit(p, sRe, sIm, dRe, dIm, ws);
+    Sleef_free(ws);
+    return;
+  }
+
+  executeSplit(p, sRe, sIm, dRe, dIm, NULL);
+}
+
+// Implementation of SleefDFT_*_execute_fixed
+
+EXPORT int EXECUTEFIXED(SleefDFT *p, const void *s0, void *d0) {
+  assert(p != NULL && p->magic == MAGICFM);
+
+  const void *s = s0 == NULL ? p->in : s0;
+  void *d = d0 == NULL ? p->out : d0;
+
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    real *ws = (real *)Sleef_malloc(sizeof(real) * (wsSize(p) + WS_ALIGN));
+    int e = executeFormat(p, s, d, ws);
+    Sleef_free(ws);
+    return e;
+  }
+
+  return executeFormat(p, s, d, NULL);
+}
+
+// Implementation of SleefDFT_*_execute_half
+
+EXPORT void EXECUTEHALF(SleefDFT *p, const void *s0, void *d0) {
+  EXECUTEFIXED(p, s0, d0);
+}
+
+// Implementation of SleefDFT_*_execute_stft
+
+EXPORT void EXECUTESTFT(SleefDFT *p, const real *ring, uint32_t pos, uint32_t nframes, real *out) {
+  assert(p != NULL && p->magic == MAGICST);
+
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    real *ws = (real *)Sleef_malloc(sizeof(real) * (wsSize(p) + WS_ALIGN));
+    executeSTFT(p, ring, pos, nframes, out, ws);
+    Sleef_free(ws);
+    return;
+  }
+
+  executeSTFT(p, ring, pos, nframes, out, NULL);
+}
+
+// Implementation of SleefDFT_*_execute_slide
+
+EXPORT void EXECUTESLIDE(SleefDFT *p, const real *in, uint32_t count, real *bins) {
+  assert(p != NULL && p->magic == MAGICGZ);
+
+  if ((p->mode & SLEEF_MODE_NO_SCRATCH) != 0) {
+    real *ws = (real *)Sleef_malloc(sizeof(real) * (wsSize(p) + WS_ALIGN));
+    executeSlide(p, in, count, bins, ws);
+    Sleef_free(ws);
+    return;
+  }
+
+  executeSlide(p, in, count, bins, NULL);
+}
+
+// Implementation of SleefDFT_*_setScale
+
+EXPORT int SETSCALE(SleefDFT *p, real scale) {
+  EXECUTE_ASSERT(p);
+
+  if (p->magic == MAGICSP) return SETSCALE(p->instSplit, scale);
+  if (p->magic == MAGICFM) return SETSCALE(p->instFormat, scale);
+
+  if (p->magic == MAGIC2D) {
+    if (p->instV == p->instH) {
+      if (scale == 1) return 0;
+      p->instV = INIT(p->vlen, NULL, NULL, p->mode | SLEEF_MODE_NO_MT);
+      if (p->instV == NULL) { p->instV = p->instH; return -1; }
+    }
+    return SETSCALE(p->instV, scale);
+  }
+
+  // The last pass of an N-D transform is along the first axis. Its
+  // plan is split off if another axis shares it.
+
+  if (p->magic == MAGICND) {
+    int shared = 0;
+    for(int a=1;a<p->ndRank;a++) if (p->ndInst[a] == p->ndInst[0]) shared = 1;
+    if (shared) {
+      if (scale == 1) return 0;
+      SleefDFT *q = INIT(p->ndLen[0], NULL, NULL, p->mode | SLEEF_MODE_NO_MT);
+      if (q == NULL) return -1;
+      p->ndInst[0] = q;
+    }
+    return SETSCALE(p->ndInst[0], scale);
+  }
+
+  if (p->magic == MAGICBT) return SETSCALE(p->instBatch, scale);
+  if (p->magic == MAGICBS) return SETSCALE(p->instB, scale);
+  if (p->magic == MAGICRR) return SETSCALE(p->instReal, scale);
+
+  // A mixed-radix plan of a prime length has no sub-plan, and scales
+  // its input while gathering it
+
+  if (p->magic == MAGICMR) {
+    if (p->instSub != NULL) return SETSCALE(p->instSub, scale);
+    p->mrScale = scale;
+    p->mrHasScale = scale != 1;
+    return 0;
+  }
+
+  if (p->magic != MAGIC) return -1;
+
+  p->outScale = scale;
+  p->hasScale = scale != 1;
+
+  return 0;
+}
+
+// Implementation of SleefDFT_*_setWindow
+
+EXPORT int SETWINDOW(SleefDFT *p, const real *window) {
+  EXECUTE_ASSERT(p);
+
+  if (p->magic == MAGICSP) {
+    // The stages of a 1D transform with weights do not read the planes
+    // themselves, so the planes are interleaved into buffers
+    int ret = SETWINDOW(p->instSplit, window);
+    if (ret == 0 && window != NULL && splitDirect(p)) allocSplitBuffers(p);
+    return ret;
+  }
+  if (p->magic == MAGICFM) {
+    int ret = SETWINDOW(p->instFormat, window);
+    if (ret == 0 && window != NULL && formatDirect(p)) allocFormatBuffer(p);
+    return ret;
+  }
+
+  if (p->magic != MAGIC) return -1;
+
+  // Tiny plans keep the mode as given, while the others have the
+  // direction flipped by SLEEF_MODE_ALT
+
+  const int isReal = (p->mode & SLEEF_MODE_REAL) != 0;
+  const int backward = p->log2len <= 1 ? (p->mode & SLEEF_MODE_BACKWARD) != 0 :
+    ((p->mode & SLEEF_MODE_BACKWARD) != 0) != ((p->mode & SLEEF_MODE_ALT) != 0);
+
+  if (isReal && backward) return -1;
+
+  Sleef_free(p->winTbl);
+  p->winTbl = NULL;
+
+  if (window == NULL) return 0;
+
+  // The weights are one plane, duplicated for the real and imaginary
+  // parts of a complex plan
+
+  const int n = 2 << p->log2len;
+  real *w = (real *)Sleef_malloc(sizeof(real) * n);
+
+  for(int i=0;i<n;i++) w[i] = isReal ? window[i] : window[i >> 1];
+
+  p->winTbl = w;
+  p->winReal = 1;
+
+  return 0;
+}
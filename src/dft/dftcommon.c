@@ -17,6 +17,31 @@
 #include <omp.h>
 #endif
 
+#ifdef ENABLE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#if !(defined(__MINGW32__) || defined(__MINGW64__) || defined(_MSC_VER))
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#define ENABLE_MMAP
+#endif
+
+#if defined(__linux__)
+#include <malloc.h>
+#define ENABLE_MLOCK
+#define blockSize(ptr) malloc_usable_size(ptr)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define ENABLE_MLOCK
+#define blockSize(ptr) malloc_size(ptr)
+#endif
+
 #include "misc.h"
 #include "sleef.h"
 
@@ -33,7 +58,49 @@
 #define MAGIC2D_FLOAT 0x22360679
 #define MAGIC2D_DOUBLE 0x17320508
 
-const char *configStr[] = { "ST", "ST stream", "MT", "MT stream" };
+#define MAGICMR_FLOAT 0x16180339
+#define MAGICMR_DOUBLE 0x14142135
+
+#define MAGICBS_FLOAT 0x26457513
+#define MAGICBS_DOUBLE 0x22912878
+
+#define MAGICRR_FLOAT 0x53851648
+#define MAGICRR_DOUBLE 0x47958315
+
+#define MAGICBT_FLOAT 0x24494897
+#define MAGICBT_DOUBLE 0x23606797
+
+#define MAGICND_FLOAT 0x36055512
+#define MAGICND_DOUBLE 0x33166247
+
+#define MAGICR2D_FLOAT 0x43588989
+#define MAGICR2D_DOUBLE 0x41231056
+
+#define MAGICSP_FLOAT 0x60827625
+#define MAGICSP_DOUBLE 0x55677643
+
+#define MAGICCV_FLOAT 0x64807406
+#define MAGICCV_DOUBLE 0x57735026
+
+#define MAGICST_FLOAT 0x68556546
+#define MAGICST_DOUBLE 0x62996052
+
+#define MAGICLG_FLOAT 0x79336154
+#define MAGICLG_DOUBLE 0x72710986
+
+#define MAGICPR_FLOAT 0x86602540
+#define MAGICPR_DOUBLE 0x69314718
+
+#define MAGICGZ_FLOAT 0x47712125
+#define MAGICGZ_DOUBLE 0x30102999
+
+#define MAGICCZ_FLOAT 0x17099759
+#define MAGICCZ_DOUBLE 0x14422495
+
+#define MAGICFM_FLOAT 0x23025850
+#define MAGICFM_DOUBLE 0x12599210
+
+const char *configStr[] = { "ST", "ST stream", "MT", "MT stream", "ST stockham", "ST stream stockham", "MT stockham", "MT stream stockham" };
 
 static int parsePathStr(char *p, int *path, int *config, int pathLenMax, int log2len) {
   int pathLen = 0, l2l = 0;
@@ -57,7 +124,7 @@ static int parsePathStr(char *p, int *path, int *config, int pathLenMax, int log
     if (*p != '(') continue;
 
     int c;
-    for(c=3;c>=0;c--) if (strncmp(p+1, configStr[c], strlen(configStr[c])) == 0) break;
+    for(c=PATHCONFIGMAX-1;c>=0;c--) if (strncmp(p+1, configStr[c], strlen(configStr[c])) == 0) break;
     if (c == -1) return -3;
     p += strlen(configStr[c]) + 1;
     if (*p != ')') return -4;
@@ -71,9 +138,98 @@ static int parsePathStr(char *p, int *path, int *config, int pathLenMax, int log
   return pathLen;
 }
 
+// Background planner
+
+static void disposeRefined(SleefDFT *q) {
+  for(int level = q->log2len;level >= 1;level--) {
+    TableCache_release(q->perm[level]);
+  }
+  free(q->perm);
+  freeTables(q);
+  free(q);
+}
+
+// Waits for the background planner of the plan to finish. The plan
+// keeps running on the refined copy if the planner published it, and
+// p itself is not modified, since executes that loaded the estimated
+// path may still be running on it. If cancel is set, the planner is
+// stopped and the refined copy is freed, which is only done when no
+// execute can be running, i.e. by SleefDFT_dispose and
+// SleefDFT_setPath.
+static void finishPlanner(SleefDFT *p, int cancel) {
+  AsyncPlanner *a = p->planner;
+  if (a == NULL) return;
+
+  if (cancel) a->cancel = 1;
+#ifdef ENABLE_PTHREAD
+  if (!a->joined) pthread_join(a->thread, NULL);
+#endif
+  a->joined = 1;
+
+  if (!cancel) return;
+
+  disposeRefined(a->refined);
+  free(a);
+  p->planner = NULL;
+}
+
+EXPORT void SleefDFT_waitPlan(SleefDFT *p) {
+  if (p == NULL) return;
+
+  if (p->magic == MAGIC_FLOAT || p->magic == MAGIC_DOUBLE) {
+    if (p->log2len > 1) finishPlanner(p, 0);
+  } else if (p->magic == MAGIC2D_FLOAT || p->magic == MAGIC2D_DOUBLE) {
+    SleefDFT_waitPlan(p->instH);
+    if (p->instV != p->instH) SleefDFT_waitPlan(p->instV);
+  } else if (p->magic == MAGICMR_FLOAT || p->magic == MAGICMR_DOUBLE) {
+    SleefDFT_waitPlan(p->instSub);
+  } else if (p->magic == MAGICBS_FLOAT || p->magic == MAGICBS_DOUBLE) {
+    SleefDFT_waitPlan(p->instF);
+    SleefDFT_waitPlan(p->instB);
+  } else if (p->magic == MAGICRR_FLOAT || p->magic == MAGICRR_DOUBLE) {
+    SleefDFT_waitPlan(p->instReal);
+  } else if (p->magic == MAGICBT_FLOAT || p->magic == MAGICBT_DOUBLE) {
+    SleefDFT_waitPlan(p->instBatch);
+  } else if (p->magic == MAGICND_FLOAT || p->magic == MAGICND_DOUBLE) {
+    for(int a=0;a<p->ndRank;a++) {
+      int shared = 0;
+      for(int b=0;b<a;b++) if (p->ndInst[b] == p->ndInst[a]) shared = 1;
+      if (!shared) SleefDFT_waitPlan(p->ndInst[a]);
+    }
+  } else if (p->magic == MAGICR2D_FLOAT || p->magic == MAGICR2D_DOUBLE) {
+    SleefDFT_waitPlan(p->instRow);
+    SleefDFT_waitPlan(p->instCol);
+  } else if (p->magic == MAGICSP_FLOAT || p->magic == MAGICSP_DOUBLE) {
+    SleefDFT_waitPlan(p->instSplit);
+  } else if (p->magic == MAGICFM_FLOAT || p->magic == MAGICFM_DOUBLE) {
+    SleefDFT_waitPlan(p->instFormat);
+  } else if (p->magic == MAGICCV_FLOAT || p->magic == MAGICCV_DOUBLE) {
+    SleefDFT_waitPlan(p->instCF);
+    SleefDFT_waitPlan(p->instCB);
+  } else if (p->magic == MAGICST_FLOAT || p->magic == MAGICST_DOUBLE) {
+    SleefDFT_waitPlan(p->instFrame);
+  } else if (p->magic == MAGICLG_FLOAT || p->magic == MAGICLG_DOUBLE) {
+    SleefDFT_waitPlan(p->instL1);
+    if (p->instL2 != p->instL1) SleefDFT_waitPlan(p->instL2);
+  } else if (p->magic == MAGICPR_FLOAT || p->magic == MAGICPR_DOUBLE) {
+    SleefDFT_waitPlan(p->instPR);
+  } else if (p->magic == MAGICCZ_FLOAT || p->magic == MAGICCZ_DOUBLE) {
+    SleefDFT_waitPlan(p->instCZF);
+    SleefDFT_waitPlan(p->instCZB);
+  }
+}
+
+EXPORT void SleefDFT_resetStream(SleefDFT *p) {
+  assert(p != NULL && (p->magic == MAGICCV_FLOAT || p->magic == MAGICCV_DOUBLE));
+
+  memset(p->cvHist, 0, p->cvHistSize);
+}
+
 EXPORT void SleefDFT_setPath(SleefDFT *p, char *pathStr) {
   assert(p != NULL && (p->magic == MAGIC_FLOAT || p->magic == MAGIC_DOUBLE));
 
+  finishPlanner(p, 1);
+
   int path[32], config[32];
   int pathLen = parsePathStr(pathStr, path, config, 31, p->log2len);
 
@@ -94,6 +250,8 @@ EXPORT void SleefDFT_setPath(SleefDFT *p, char *pathStr) {
   p->pathLen = 0;
   for(int j = p->log2len;j >= 0;j--) if (p->bestPath[j] != 0) p->pathLen++;
 
+  if (p->magic == MAGIC_DOUBLE) bindPathTables_double(p); else bindPathTables_float(p);
+
   if ((p->mode & SLEEF_MODE_VERBOSE) != 0) {
     printf("Set path : ");
     for(int j = p->log2len;j >= 0;j--) if (p->bestPath[j] != 0) printf("%d(%s) ", p->bestPath[j], configStr[p->bestPathConfig[j]]);
@@ -101,34 +259,717 @@ EXPORT void SleefDFT_setPath(SleefDFT *p, char *pathStr) {
   }
 }
 
+// Table cache
+
+// Twiddle factor and permutation tables depend only on a few plan
+// parameters, so plans borrow them from this process-wide cache.  A
+// table is freed when the last plan referring to it releases it.
+// Tables in a binary plan file are registered with a reference held
+// by the mapping, and are never freed.
+
+typedef struct TableCacheEntry {
+  uint64_t key;
+  void *ptr;
+  size_t size;
+  int refCount;
+  struct TableCacheEntry *next;
+} TableCacheEntry;
+
+static TableCacheEntry *tableCache = NULL;
+#if defined(_OPENMP)
+static omp_lock_t tableCacheLock;
+static int tableCacheLockInitialized = 0;
+#elif defined(ENABLE_PTHREAD)
+static pthread_mutex_t tableCacheLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lockTableCache() {
+#if defined(_OPENMP)
+#pragma omp critical
+  {
+    if (!tableCacheLockInitialized) {
+      tableCacheLockInitialized = 1;
+      omp_init_lock(&tableCacheLock);
+    }
+  }
+  omp_set_lock(&tableCacheLock);
+#elif defined(ENABLE_PTHREAD)
+  pthread_mutex_lock(&tableCacheLock);
+#endif
+}
+
+static void unlockTableCache() {
+#if defined(_OPENMP)
+  omp_unset_lock(&tableCacheLock);
+#elif defined(ENABLE_PTHREAD)
+  pthread_mutex_unlock(&tableCacheLock);
+#endif
+}
+
+#define TBLCATBIT 1
+#define TBLBASETYPEIDBIT 2
+#define TBLDIRBIT 1
+#define TBLLOG2LENBIT 6
+#define TBLLOG2VECWIDTHBIT 4
+#define TBLNBIT 4
+#define TBLLEVELBIT 6
+
+uint64_t TableCache_keyTwiddle(int baseTypeID, int log2len, int sign, int log2vecwidth, int N, int level) {
+  uint64_t k = 0;
+  k = (k << TBLLEVELBIT) | (level & ~(~(uint64_t)0 << TBLLEVELBIT));
+  k = (k << TBLNBIT) | (N & ~(~(uint64_t)0 << TBLNBIT));
+  k = (k << TBLLOG2VECWIDTHBIT) | (log2vecwidth & ~(~(uint64_t)0 << TBLLOG2VECWIDTHBIT));
+  k = (k << TBLLOG2LENBIT) | (log2len & ~(~(uint64_t)0 << TBLLOG2LENBIT));
+  k = (k << TBLDIRBIT) | (sign < 0);
+  k = (k << TBLBASETYPEIDBIT) | (baseTypeID & ~(~(uint64_t)0 << TBLBASETYPEIDBIT));
+  k = (k << TBLCATBIT) | 0;
+  return k;
+}
+
+// Permutation tables do not depend on the base type or the direction
+uint64_t TableCache_keyPerm(int log2len, int log2vecwidth, int N, int level) {
+  uint64_t k = 0;
+  k = (k << TBLLEVELBIT) | (level & ~(~(uint64_t)0 << TBLLEVELBIT));
+  k = (k << TBLNBIT) | (N & ~(~(uint64_t)0 << TBLNBIT));
+  k = (k << TBLLOG2VECWIDTHBIT) | (log2vecwidth & ~(~(uint64_t)0 << TBLLOG2VECWIDTHBIT));
+  k = (k << TBLLOG2LENBIT) | (log2len & ~(~(uint64_t)0 << TBLLOG2LENBIT));
+  k = (k << (TBLDIRBIT + TBLBASETYPEIDBIT));
+  k = (k << TBLCATBIT) | 1;
+  return k;
+}
+
+// Returns the size in bytes of the table that the key describes, or 0
+// if the key cannot have been produced by the two functions above
+static uint64_t TableCache_keySize(uint64_t key) {
+  static const int constK[] = { 0, 2, 6, 14, 38, 94, 230, 542, 1254 };
+  int cat = key & ~(~(uint64_t)0 << TBLCATBIT);
+  key >>= TBLCATBIT;
+  int baseTypeID = key & ~(~(uint64_t)0 << TBLBASETYPEIDBIT);
+  key >>= TBLBASETYPEIDBIT + TBLDIRBIT;
+  int log2len = key & ~(~(uint64_t)0 << TBLLOG2LENBIT);
+  key >>= TBLLOG2LENBIT + TBLLOG2VECWIDTHBIT;
+  int N = key & ~(~(uint64_t)0 << TBLNBIT);
+  key >>= TBLNBIT;
+  int level = key & ~(~(uint64_t)0 << TBLLEVELBIT);
+  key >>= TBLLEVELBIT;
+
+  if (key != 0 || log2len > MAXLOG2LEN || N < 1 || N >= (int)(sizeof(constK)/sizeof(constK[0])) ||
+      level < N || level > log2len) return 0;
+
+  if (cat == 1) return sizeof(uint32_t) * ((UINT64_C(1) << log2len) + 8);
+
+  uint64_t s = baseTypeID == 1 ? sizeof(double) : baseTypeID == 2 ? sizeof(float) : 0;
+  return s * (level == log2len ? ((uint64_t)constK[N] << (log2len-N))*2 : (uint64_t)constK[N] << (level-N));
+}
+
+// Returns nonzero if the contents of a table read from a file agree
+// with its key. Permutation tables hold the offsets at which the
+// kernels store, so they are compared with a regenerated table. A key
+// must have passed TableCache_keySize.
+static int TableCache_validContents(uint64_t key, const void *ptr, uint64_t size) {
+  if ((key & ~(~(uint64_t)0 << TBLCATBIT)) != 1) return 1;
+  key >>= TBLCATBIT + TBLBASETYPEIDBIT + TBLDIRBIT;
+  int log2len = key & ~(~(uint64_t)0 << TBLLOG2LENBIT);
+  key >>= TBLLOG2LENBIT;
+  int log2vecwidth = key & ~(~(uint64_t)0 << TBLLOG2VECWIDTHBIT);
+  key >>= TBLLOG2VECWIDTHBIT;
+  int N = key & ~(~(uint64_t)0 << TBLNBIT);
+  key >>= TBLNBIT;
+  int level = key & ~(~(uint64_t)0 << TBLLEVELBIT);
+
+  uint32_t *t = makePermTable(log2len, log2vecwidth, N, level);
+  int ret = memcmp(t, ptr, size) == 0;
+  Sleef_free(t);
+  return ret;
+}
+
+// Returns the table registered with the key and increments its
+// reference count, or NULL if there is no such table
+void *TableCache_acquire(uint64_t key) {
+  void *ret = NULL;
+  lockTableCache();
+  for(TableCacheEntry *e = tableCache;e != NULL;e = e->next) {
+    if (e->key == key) {
+      e->refCount++;
+      ret = e->ptr;
+      break;
+    }
+  }
+  unlockTableCache();
+  return ret;
+}
+
+// Registers a table of size bytes allocated with Sleef_malloc. If
+// another plan has registered the same table in the meantime, ptr is
+// freed and the registered one is returned instead.
+void *TableCache_insert(uint64_t key, void *ptr, size_t size) {
+  lockTableCache();
+  for(TableCacheEntry *e = tableCache;e != NULL;e = e->next) {
+    if (e->key == key) {
+      e->refCount++;
+      unlockTableCache();
+      Sleef_free(ptr);
+      return e->ptr;
+    }
+  }
+  TableCacheEntry *e = (TableCacheEntry *)malloc(sizeof(TableCacheEntry));
+  e->key = key;
+  e->ptr = ptr;
+  e->size = size;
+  e->refCount = 1;
+  e->next = tableCache;
+  tableCache = e;
+  unlockTableCache();
+  return ptr;
+}
+
+void TableCache_release(void *ptr) {
+  if (ptr == NULL) return;
+  lockTableCache();
+  for(TableCacheEntry **pe = &tableCache;*pe != NULL;pe = &(*pe)->next) {
+    TableCacheEntry *e = *pe;
+    if (e->ptr != ptr) continue;
+    if (--e->refCount == 0) {
+      *pe = e->next;
+      Sleef_free(e->ptr);
+      free(e);
+    }
+    unlockTableCache();
+    return;
+  }
+  unlockTableCache();
+  assert(0);
+}
+
+// Threading backends
+
+// Parallel regions of plans are run as tasks numbered from 0. A task
+// uses the per-thread buffers of its number, and the MT kernels called
+// from it process the chunk of the loop set with KernelChunk_set.
+// Tasks are run with OpenMP unless SleefDFT_setThreadPool or
+// SleefDFT_setExecutor selects another backend. A region started from
+// within a task runs its tasks in the calling thread. The backend is
+// published as a single pointer, so that a region always sees a
+// consistent function, argument and thread count. It must not be
+// replaced while a plan is being executed.
+
+#if defined(_MSC_VER)
+#define THREADLOCAL __declspec(thread)
+#else
+#define THREADLOCAL __thread
+#endif
+
+static THREADLOCAL int taskSlot = -1;
+static THREADLOCAL int chunkIndex = 0, chunkCount = 1;
+
+typedef struct Executor {
+  void (*func)(void (*)(void *, int), void *, int, void *);
+  void *arg;
+  int nThread;
+} Executor;
+
+static Executor *executor = NULL;
+
+static Executor *currentExecutor() { return __atomic_load_n(&executor, __ATOMIC_ACQUIRE); }
+
+void KernelChunk_set(int index, int count) {
+  chunkIndex = index;
+  chunkCount = count;
+}
+
+int KernelChunk_begin(int k) { return (int)((int64_t)k * chunkIndex / chunkCount); }
+int KernelChunk_end(int k) { return (int)((int64_t)k * (chunkIndex + 1) / chunkCount); }
+
+// Number of threads the tasks are spread over
+int Executor_threadCount() {
+  Executor *e = currentExecutor();
+  if (e != NULL) return e->nThread;
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// Number of per-thread buffers a plan needs. Plans may also be
+// executed concurrently from the threads of an OpenMP team.
+int Executor_slotCount() {
+  int n = Executor_threadCount();
+#ifdef _OPENMP
+  n = MAX(n, omp_get_max_threads());
+#endif
+  return n;
+}
+
+int Executor_slot() {
+  if (taskSlot >= 0) return taskSlot;
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+typedef struct TaskWrapper {
+  void (*task)(void *, int);
+  void *arg;
+} TaskWrapper;
+
+static void runTask(void *ptr, int t) {
+  TaskWrapper *w = (TaskWrapper *)ptr;
+  int slot = taskSlot;
+  taskSlot = t;
+  (*w->task)(w->arg, t);
+  taskSlot = slot;
+}
+
+void Executor_run(void (*task)(void *, int), void *arg, int nTask) {
+  Executor *e = currentExecutor();
+  int nested = taskSlot >= 0;
+#ifdef _OPENMP
+  if (e == NULL && omp_in_parallel()) nested = 1;
+#endif
+
+  if (nTask <= 1 || nested) {
+    for(int t=0;t<nTask;t++) (*task)(arg, t);
+    return;
+  }
+
+  TaskWrapper w = { task, arg };
+
+  if (e != NULL) {
+    (*e->func)(runTask, &w, nTask, e->arg);
+    return;
+  }
+
+#ifdef _OPENMP
+  int t=0;
+#pragma omp parallel for
+  for(t=0;t<nTask;t++) runTask(&w, t);
+#else
+  for(int t=0;t<nTask;t++) runTask(&w, t);
+#endif
+}
+
+typedef struct ParallelFor {
+  void (*body)(void *, int);
+  void *arg;
+  int n, nTask;
+} ParallelFor;
+
+static void parallelForTask(void *ptr, int t) {
+  ParallelFor *f = (ParallelFor *)ptr;
+  const int i1 = (int)((int64_t)f->n * (t + 1) / f->nTask);
+  for(int i=(int)((int64_t)f->n * t / f->nTask);i<i1;i++) (*f->body)(f->arg, i);
+}
+
+// Runs body(arg, i) for 0 <= i < n, split evenly into nTask tasks
+void Executor_parallelFor(void (*body)(void *, int), void *arg, int n, int nTask) {
+  ParallelFor f = { body, arg, n, MAX(MIN(nTask, n), 1) };
+  Executor_run(parallelForTask, &f, f.nTask);
+}
+
+// Built-in thread pool
+
+// The pool runs the tasks on persistent threads. Idle threads take
+// the next task from a shared counter, so that threads which finish
+// early pick up the remaining work. The threads spin for a while
+// after finishing a region, and then sleep until the next one. They
+// do not spin if there are more threads than processors.
+
+#ifdef ENABLE_PTHREAD
+#define POOL_SPIN (1 << 16)
+
+typedef struct ThreadPool {
+  int nWorker, spin;
+  pthread_t *thread;
+  pthread_mutex_t mutex, submitMutex;
+  pthread_cond_t cond;
+  void (*task)(void *, int);
+  void *arg;
+  int nTask, sleeping, quit;
+  volatile int next, finished;
+  volatile uint64_t generation;
+} ThreadPool;
+
+static ThreadPool *threadPool = NULL;
+
+static void poolWork(ThreadPool *pool) {
+  for(;;) {
+    int t = __atomic_fetch_add(&pool->next, 1, __ATOMIC_ACQ_REL);
+    if (t >= pool->nTask) break;
+    (*pool->task)(pool->arg, t);
+  }
+}
+
+static void *poolWorker(void *ptr) {
+  ThreadPool *pool = (ThreadPool *)ptr;
+  uint64_t seen = 0;
+
+  for(;;) {
+    for(int i=0;i<pool->spin && __atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE) == seen;i++) ;
+
+    if (__atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE) == seen) {
+      pthread_mutex_lock(&pool->mutex);
+      pool->sleeping++;
+      while(pool->generation == seen && !pool->quit) pthread_cond_wait(&pool->cond, &pool->mutex);
+      pool->sleeping--;
+      pthread_mutex_unlock(&pool->mutex);
+    }
+
+    if (pool->quit) return NULL;
+
+    // A new region is not started before every worker finishes the
+    // current one, so the generation advances by one at a time
+    seen++;
+    poolWork(pool);
+    __atomic_add_fetch(&pool->finished, 1, __ATOMIC_RELEASE);
+  }
+}
+
+static void poolRun(void (*task)(void *, int), void *arg, int nTask, void *ptr) {
+  ThreadPool *pool = (ThreadPool *)ptr;
+
+  pthread_mutex_lock(&pool->submitMutex);
+
+  pool->task = task;
+  pool->arg = arg;
+  pool->nTask = nTask;
+  pool->next = 0;
+  pool->finished = 0;
+  __atomic_add_fetch(&pool->generation, 1, __ATOMIC_RELEASE);
+
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->sleeping > 0) pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  poolWork(pool);
+
+  for(int i=0;__atomic_load_n(&pool->finished, __ATOMIC_ACQUIRE) != pool->nWorker;) {
+    if (i < pool->spin) i++; else sched_yield();
+  }
+
+  pthread_mutex_unlock(&pool->submitMutex);
+}
+
+static void stopThreadPool() {
+  ThreadPool *pool = threadPool;
+  if (pool == NULL) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->quit = 1;
+  __atomic_add_fetch(&pool->generation, 1, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for(int i=0;i<pool->nWorker;i++) pthread_join(pool->thread[i], NULL);
+
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_mutex_destroy(&pool->submitMutex);
+  free(pool->thread);
+  free(pool);
+  threadPool = NULL;
+}
+#endif
+
+// Serializes the functions below. The pool is a pthread backend, so
+// it is guarded with a pthread mutex whether or not OpenMP is enabled.
+#ifdef ENABLE_PTHREAD
+static pthread_mutex_t executorLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lockExecutor() {
+#ifdef ENABLE_PTHREAD
+  pthread_mutex_lock(&executorLock);
+#endif
+}
+
+static void unlockExecutor() {
+#ifdef ENABLE_PTHREAD
+  pthread_mutex_unlock(&executorLock);
+#endif
+}
+
+// Publishes a new backend and frees the previous one. Regions that
+// are not running anymore cannot refer to the previous one.
+static void publishExecutor(void (*func)(void (*)(void *, int), void *, int, void *), void *arg, int nThread) {
+  Executor *e = NULL;
+  if (func != NULL) {
+    e = (Executor *)malloc(sizeof(Executor));
+    e->func = func;
+    e->arg = arg;
+    e->nThread = MAX(nThread, 1);
+  }
+  free(__atomic_exchange_n(&executor, e, __ATOMIC_ACQ_REL));
+}
+
+EXPORT int SleefDFT_setThreadPool(int nThread) {
+#ifdef ENABLE_PTHREAD
+  lockExecutor();
+  publishExecutor(NULL, NULL, 1);
+  stopThreadPool();
+
+  if (nThread <= 0) {
+    unlockExecutor();
+    return 0;
+  }
+
+  ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+  pool->thread = (pthread_t *)malloc(sizeof(pthread_t) * nThread);
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_mutex_init(&pool->submitMutex, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+  pool->spin = POOL_SPIN;
+#ifdef _SC_NPROCESSORS_ONLN
+  if (nThread > sysconf(_SC_NPROCESSORS_ONLN)) pool->spin = 0;
+#endif
+
+  // The calling thread also runs tasks, so nThread-1 workers are
+  // started
+  for(pool->nWorker=0;pool->nWorker<nThread-1;pool->nWorker++) {
+    if (pthread_create(&pool->thread[pool->nWorker], NULL, poolWorker, pool) != 0) break;
+  }
+
+  threadPool = pool;
+  publishExecutor(poolRun, pool, pool->nWorker + 1);
+  unlockExecutor();
+
+  return pool->nWorker + 1;
+#else
+  return nThread <= 0 ? 0 : -1;
+#endif
+}
+
+EXPORT void SleefDFT_setExecutor(void (*run)(void (*task)(void *, int), void *taskArg, int nTask, void *arg), void *arg, int nThread) {
+  lockExecutor();
+  publishExecutor(run, arg, nThread);
+#ifdef ENABLE_PTHREAD
+  stopThreadPool();
+#endif
+  unlockExecutor();
+}
+
 void freeTables(SleefDFT *p) {
   for(int N=1;N<=MAXBUTWIDTH;N++) {
+    if (p->tbl[N] == NULL) continue;
     for(uint32_t level=N;level<=p->log2len;level++) {
-      Sleef_free(p->tbl[N][level]);
+      TableCache_release(p->tbl[N][level]);
     }
     free(p->tbl[N]);
     p->tbl[N] = NULL;
   }
 }
 
+static void freeBuffers(void **buf, int nThread) {
+  if (buf == NULL) return;
+  for(int i=0;i<nThread;i++) Sleef_free(buf[i]);
+  free(buf);
+}
+
+#ifdef ENABLE_MLOCK
+static int lockPlan(SleefDFT *p, int lock);
+#endif
+
 EXPORT void SleefDFT_dispose(SleefDFT *p) {
+#ifdef ENABLE_MLOCK
+  if (p != NULL && p->memLocked) lockPlan(p, 0);
+#endif
+
   if (p != NULL && (p->magic == MAGIC2D_FLOAT || p->magic == MAGIC2D_DOUBLE)) {
     Sleef_free(p->tBuf);
+    freeBuffers(p->tPanel, p->tNThread);
     SleefDFT_dispose(p->instH);
-    if (p->hlen != p->vlen) SleefDFT_dispose(p->instV);
+    if (p->instV != p->instH) SleefDFT_dispose(p->instV);
   
     p->magic = 0;
     free(p);
     return;
   }
 
+  if (p != NULL && (p->magic == MAGICMR_FLOAT || p->magic == MAGICMR_DOUBLE)) {
+    freeBuffers(p->mrBuf0, p->mrNThread);
+    freeBuffers(p->mrBuf1, p->mrNThread);
+    Sleef_free(p->mrTbl);
+    Sleef_free(p->mrCoef);
+    if (p->instSub != NULL) SleefDFT_dispose(p->instSub);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICBS_FLOAT || p->magic == MAGICBS_DOUBLE)) {
+    freeBuffers(p->bsBuf0, p->bsNThread);
+    freeBuffers(p->bsBuf1, p->bsNThread);
+    Sleef_free(p->bsChirp);
+    Sleef_free(p->bsKernel);
+    SleefDFT_dispose(p->instF);
+    SleefDFT_dispose(p->instB);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICR2D_FLOAT || p->magic == MAGICR2D_DOUBLE)) {
+    freeBuffers(p->r2Line0, p->r2NThread);
+    freeBuffers(p->r2Line1, p->r2NThread);
+    if (p->r2Buf != NULL) Sleef_free(p->r2Buf);
+    SleefDFT_dispose(p->instRow);
+    SleefDFT_dispose(p->instCol);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICND_FLOAT || p->magic == MAGICND_DOUBLE)) {
+    freeBuffers(p->ndLine0, p->ndNThread);
+    freeBuffers(p->ndLine1, p->ndNThread);
+    if (p->ndBuf != NULL) Sleef_free(p->ndBuf);
+
+    for(int a=0;a<p->ndRank;a++) {
+      int shared = 0;
+      for(int b=0;b<a;b++) if (p->ndInst[b] == p->ndInst[a]) shared = 1;
+      if (!shared) SleefDFT_dispose(p->ndInst[a]);
+    }
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICRR_FLOAT || p->magic == MAGICRR_DOUBLE)) {
+    freeBuffers(p->rrBuf0, p->rrNThread);
+    freeBuffers(p->rrBuf1, p->rrNThread);
+    Sleef_free(p->rrTbl);
+    SleefDFT_dispose(p->instReal);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICSP_FLOAT || p->magic == MAGICSP_DOUBLE)) {
+    freeBuffers(p->spLine, p->spNThread);
+    Sleef_free(p->spBuf0);
+    Sleef_free(p->spBuf1);
+    SleefDFT_dispose(p->instSplit);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICFM_FLOAT || p->magic == MAGICFM_DOUBLE)) {
+    freeBuffers(p->fmLine, p->fmNThread);
+    Sleef_free(p->fmBuf);
+    SleefDFT_dispose(p->instFormat);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICCV_FLOAT || p->magic == MAGICCV_DOUBLE)) {
+    freeBuffers(p->cvBuf0, 1);
+    freeBuffers(p->cvBuf1, 1);
+    Sleef_free(p->cvHist);
+    SleefDFT_dispose(p->instCF);
+    SleefDFT_dispose(p->instCB);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICLG_FLOAT || p->magic == MAGICLG_DOUBLE)) {
+    freeBuffers(p->lgBuf, p->lgNThread);
+    Sleef_free(p->lgTwLo);
+    Sleef_free(p->lgTwHi);
+    if (p->instL2 != p->instL1) SleefDFT_dispose(p->instL2);
+    SleefDFT_dispose(p->instL1);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICCZ_FLOAT || p->magic == MAGICCZ_DOUBLE)) {
+    freeBuffers(p->czBuf0, p->czNThread);
+    freeBuffers(p->czBuf1, p->czNThread);
+    Sleef_free(p->czPre);
+    Sleef_free(p->czPost);
+    Sleef_free(p->czKernel);
+    SleefDFT_dispose(p->instCZF);
+    SleefDFT_dispose(p->instCZB);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICGZ_FLOAT || p->magic == MAGICGZ_DOUBLE)) {
+    Sleef_free(p->gzCoef);
+    Sleef_free(p->gzSin);
+    Sleef_free(p->gzRot);
+    Sleef_free(p->gzBins);
+    Sleef_free(p->gzTw);
+    Sleef_free(p->gzBuf);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICPR_FLOAT || p->magic == MAGICPR_DOUBLE)) {
+    freeBuffers(p->prBuf, p->prNThread);
+    freeBuffers(p->prPanelBuf, p->prNThread);
+    freeBuffers(p->prAcc, p->prNThread);
+    Sleef_free(p->prTwLo);
+    Sleef_free(p->prTwHi);
+    Sleef_free(p->prTw);
+    SleefDFT_dispose(p->instPR);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICST_FLOAT || p->magic == MAGICST_DOUBLE)) {
+    freeBuffers(p->stBuf0, p->stNThread);
+    freeBuffers(p->stBuf1, p->stNThread);
+    SleefDFT_dispose(p->instFrame);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
+  if (p != NULL && (p->magic == MAGICBT_FLOAT || p->magic == MAGICBT_DOUBLE)) {
+    freeBuffers(p->btBuf0, p->btNThread);
+    freeBuffers(p->btBuf1, p->btNThread);
+    SleefDFT_dispose(p->instBatch);
+
+    p->magic = 0;
+    free(p);
+    return;
+  }
+
   assert(p != NULL && (p->magic == MAGIC_FLOAT || p->magic == MAGIC_DOUBLE));
 
+  Sleef_free(p->winTbl);
+  Sleef_free(p->specTbl);
+  p->winTbl = p->specTbl = NULL;
+
   if (p->log2len <= 1) {
     p->magic = 0;
     free(p);
     return;
   }
+
+  finishPlanner(p, 1);
   
   if ((p->mode & SLEEF_MODE_REAL) != 0) {
     Sleef_free(p->rtCoef1);
@@ -137,17 +978,149 @@ EXPORT void SleefDFT_dispose(SleefDFT *p) {
   }
   
   for(int level = p->log2len;level >= 1;level--) {
-    Sleef_free(p->perm[level]);
+    TableCache_release(p->perm[level]);
   }
   free(p->perm);
   p->perm = NULL;
 
+  freeBuffers(p->x0, p->nThread);
+  freeBuffers(p->x1, p->nThread);
+  p->x0 = p->x1 = NULL;
+
   freeTables(p);
 
   p->magic = 0;
   free(p);
 }
 
+// Locking the memory of a plan
+
+#ifdef ENABLE_MLOCK
+// The functions below lock a block if lock is 1, and unlock it if lock
+// is 0. Locks do not nest, so only the pages that lie entirely inside
+// a block are unlocked. The others may hold a locked neighbour.
+static int lockBlock(const void *ptr, size_t size, int lock) {
+  if (ptr == NULL || size == 0) return 1;
+  if (lock) return mlock(ptr, size) == 0;
+
+  const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+  const uintptr_t b = ((uintptr_t)ptr + page - 1) & ~(page - 1), e = ((uintptr_t)ptr + size) & ~(page - 1);
+  return e <= b || munlock((const void *)b, e - b) == 0;
+}
+
+static int lockHeap(const void *ptr, int lock) {
+  return ptr == NULL ? 1 : lockBlock(ptr, blockSize((void *)ptr), lock);
+}
+
+static int lockBuffers(void **buf, int nThread, int lock) {
+  if (buf == NULL) return 1;
+  int ok = lockHeap(buf, lock);
+  for(int i=0;i<nThread;i++) ok &= lockHeap(buf[i], lock);
+  return ok;
+}
+
+// A registered table may lie in a mapped plan file rather than on the
+// heap. It is only unlocked if no other plan holds it.
+static int lockTable(void *ptr, int lock) {
+  if (ptr == NULL) return 1;
+  int ok = 1;
+  lockTableCache();
+  for(TableCacheEntry *e = tableCache;e != NULL;e = e->next) {
+    if (e->ptr == ptr) {
+      if (lock || e->refCount == 1) ok = lockBlock(ptr, e->size, lock);
+      break;
+    }
+  }
+  unlockTableCache();
+  return ok;
+}
+
+// Walks the plan in the same way as SleefDFT_dispose
+static int lockPlan(SleefDFT *p, int lock) {
+  if (p == NULL) return 1;
+  int ok = lockHeap(p, lock);
+
+  if (p->magic == MAGIC2D_FLOAT || p->magic == MAGIC2D_DOUBLE) {
+    ok &= lockHeap(p->tBuf, lock) & lockBuffers(p->tPanel, p->tNThread, lock) & lockPlan(p->instH, lock);
+    if (p->instV != p->instH) ok &= lockPlan(p->instV, lock);
+  } else if (p->magic == MAGICMR_FLOAT || p->magic == MAGICMR_DOUBLE) {
+    ok &= lockBuffers(p->mrBuf0, p->mrNThread, lock) & lockBuffers(p->mrBuf1, p->mrNThread, lock);
+    ok &= lockHeap(p->mrTbl, lock) & lockHeap(p->mrCoef, lock) & lockPlan(p->instSub, lock);
+  } else if (p->magic == MAGICBS_FLOAT || p->magic == MAGICBS_DOUBLE) {
+    ok &= lockBuffers(p->bsBuf0, p->bsNThread, lock) & lockBuffers(p->bsBuf1, p->bsNThread, lock);
+    ok &= lockHeap(p->bsChirp, lock) & lockHeap(p->bsKernel, lock) & lockPlan(p->instF, lock) & lockPlan(p->instB, lock);
+  } else if (p->magic == MAGICR2D_FLOAT || p->magic == MAGICR2D_DOUBLE) {
+    ok &= lockBuffers(p->r2Line0, p->r2NThread, lock) & lockBuffers(p->r2Line1, p->r2NThread, lock);
+    ok &= lockHeap(p->r2Buf, lock) & lockPlan(p->instRow, lock) & lockPlan(p->instCol, lock);
+  } else if (p->magic == MAGICND_FLOAT || p->magic == MAGICND_DOUBLE) {
+    ok &= lockBuffers(p->ndLine0, p->ndNThread, lock) & lockBuffers(p->ndLine1, p->ndNThread, lock) & lockHeap(p->ndBuf, lock);
+    for(int a=0;a<p->ndRank;a++) {
+      int shared = 0;
+      for(int b=0;b<a;b++) if (p->ndInst[b] == p->ndInst[a]) shared = 1;
+      if (!shared) ok &= lockPlan(p->ndInst[a], lock);
+    }
+  } else if (p->magic == MAGICRR_FLOAT || p->magic == MAGICRR_DOUBLE) {
+    ok &= lockBuffers(p->rrBuf0, p->rrNThread, lock) & lockBuffers(p->rrBuf1, p->rrNThread, lock);
+    ok &= lockHeap(p->rrTbl, lock) & lockPlan(p->instReal, lock);
+  } else if (p->magic == MAGICSP_FLOAT || p->magic == MAGICSP_DOUBLE) {
+    ok &= lockBuffers(p->spLine, p->spNThread, lock) & lockHeap(p->spBuf0, lock) & lockHeap(p->spBuf1, lock) & lockPlan(p->instSplit, lock);
+  } else if (p->magic == MAGICFM_FLOAT || p->magic == MAGICFM_DOUBLE) {
+    ok &= lockBuffers(p->fmLine, p->fmNThread, lock) & lockHeap(p->fmBuf, lock) & lockPlan(p->instFormat, lock);
+  } else if (p->magic == MAGICCV_FLOAT || p->magic == MAGICCV_DOUBLE) {
+    ok &= lockBuffers(p->cvBuf0, 1, lock) & lockBuffers(p->cvBuf1, 1, lock) & lockHeap(p->cvHist, lock);
+    ok &= lockPlan(p->instCF, lock) & lockPlan(p->instCB, lock);
+  } else if (p->magic == MAGICLG_FLOAT || p->magic == MAGICLG_DOUBLE) {
+    ok &= lockBuffers(p->lgBuf, p->lgNThread, lock) & lockHeap(p->lgTwLo, lock) & lockHeap(p->lgTwHi, lock) & lockPlan(p->instL1, lock);
+    if (p->instL2 != p->instL1) ok &= lockPlan(p->instL2, lock);
+  } else if (p->magic == MAGICCZ_FLOAT || p->magic == MAGICCZ_DOUBLE) {
+    ok &= lockBuffers(p->czBuf0, p->czNThread, lock) & lockBuffers(p->czBuf1, p->czNThread, lock);
+    ok &= lockHeap(p->czPre, lock) & lockHeap(p->czPost, lock) & lockHeap(p->czKernel, lock);
+    ok &= lockPlan(p->instCZF, lock) & lockPlan(p->instCZB, lock);
+  } else if (p->magic == MAGICGZ_FLOAT || p->magic == MAGICGZ_DOUBLE) {
+    ok &= lockHeap(p->gzCoef, lock) & lockHeap(p->gzSin, lock) & lockHeap(p->gzRot, lock) & lockHeap(p->gzBins, lock) & lockHeap(p->gzTw, lock) & lockHeap(p->gzBuf, lock);
+  } else if (p->magic == MAGICPR_FLOAT || p->magic == MAGICPR_DOUBLE) {
+    ok &= lockBuffers(p->prBuf, p->prNThread, lock) & lockBuffers(p->prPanelBuf, p->prNThread, lock) & lockBuffers(p->prAcc, p->prNThread, lock);
+    ok &= lockHeap(p->prTwLo, lock) & lockHeap(p->prTwHi, lock) & lockHeap(p->prTw, lock) & lockPlan(p->instPR, lock);
+  } else if (p->magic == MAGICST_FLOAT || p->magic == MAGICST_DOUBLE) {
+    ok &= lockBuffers(p->stBuf0, p->stNThread, lock) & lockBuffers(p->stBuf1, p->stNThread, lock) & lockPlan(p->instFrame, lock);
+  } else if (p->magic == MAGICBT_FLOAT || p->magic == MAGICBT_DOUBLE) {
+    ok &= lockBuffers(p->btBuf0, p->btNThread, lock) & lockBuffers(p->btBuf1, p->btNThread, lock) & lockPlan(p->instBatch, lock);
+  } else {
+    ok &= lockHeap(p->winTbl, lock) & lockHeap(p->specTbl, lock);
+    if (p->log2len <= 1) return ok;
+
+    if (p->planner != NULL && p->planner->refined != p) ok &= lockHeap(p->planner, lock) & lockPlan(p->planner->refined, lock);
+
+    ok &= lockHeap(p->rtCoef0, lock) & lockHeap(p->rtCoef1, lock);
+    ok &= lockHeap(p->perm, lock) & lockBuffers(p->x0, p->nThread, lock) & lockBuffers(p->x1, p->nThread, lock);
+    for(uint32_t level=1;level<=p->log2len;level++) ok &= lockTable(p->perm[level], lock);
+
+    for(int N=1;N<=MAXBUTWIDTH;N++) {
+      if (p->tbl[N] == NULL) continue;
+      ok &= lockHeap(p->tbl[N], lock);
+      for(uint32_t level=N;level<=p->log2len;level++) ok &= lockTable(p->tbl[N][level], lock);
+    }
+  }
+
+  return ok;
+}
+#endif
+
+// Pages are locked, and thereby faulted in, for every table and buffer
+// the plan executes with. SleefDFT_dispose unlocks the pages that only
+// the plan uses. The pages of tables held by other plans and the pages
+// at the ends of a block stay locked until the memory is unmapped.
+EXPORT int SleefDFT_lockMemory(SleefDFT *p) {
+  if (p == NULL) return -1;
+  SleefDFT_waitPlan(p);
+#ifdef ENABLE_MLOCK
+  p->memLocked = 1;
+  return lockPlan(p, 1) ? 0 : -1;
+#else
+  return -1;
+#endif
+}
+
 uint32_t ilog2(uint32_t q) {
   static const uint32_t tab[] = {0,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4};
   uint32_t r = 0,qq;
@@ -162,6 +1135,33 @@ uint32_t ilog2(uint32_t q) {
   return r + tab[qq] * 4 + tab[q >> (tab[qq] * 4)] - 1;
 }
 
+uint32_t perm(int nbits, uint32_t k, int s, int d) {
+  s = MIN(MAX(s, 0), nbits);
+  d = MIN(MAX(d, 0), nbits);
+  uint32_t r;
+  r = (((k & 0xaaaaaaaa) >> 1) | ((k & 0x55555555) << 1));
+  r = (((r & 0xcccccccc) >> 2) | ((r & 0x33333333) << 2));
+  r = (((r & 0xf0f0f0f0) >> 4) | ((r & 0x0f0f0f0f) << 4));
+  r = (((r & 0xff00ff00) >> 8) | ((r & 0x00ff00ff) << 8));
+  r = ((r >> 16) | (r << 16)) >> (32-nbits);
+
+  return (((r << s) | (k & ~(-1 << s))) & ~(-1 << d)) |
+    ((((k >> s) | (r & (-1 << (nbits-s)))) << d) & ~(-1 << nbits));
+}
+
+// Returns the permutation table of the butterflies of width 2^N at
+// the level, allocated with Sleef_malloc. The table has 2^log2len + 8
+// entries, which are offsets of the vectors in the output.
+uint32_t *makePermTable(int log2len, int log2vecwidth, int N, int level) {
+  uint32_t *t = (uint32_t *)Sleef_malloc(sizeof(uint32_t) * ((1 << log2len) + 8));
+  int i1 = 0;
+  for(int i0=0;i0 < (1 << (log2len-N));i0+=(1 << log2vecwidth), i1++) {
+    t[i1] = 2*perm(log2len, i0, log2len-level, log2len-(level-N));
+  }
+  for(;i1 < (1 << log2len) + 8;i1++) t[i1] = 0;
+  return t;
+}
+
 //
 
 char *dftPlanFilePath = NULL;
@@ -169,13 +1169,16 @@ char *archID = NULL;
 uint64_t planMode = SLEEF_PLAN_REFERTOENVVAR;
 ArrayMap *planMap = NULL;
 int planFilePathSet = 0, planFileLoaded = 0;
-#ifdef _OPENMP
+uint64_t planTimeLimit = 0;
+#if defined(_OPENMP)
 omp_lock_t planMapLock;
 int planMapLockInitialized = 0;
+#elif defined(ENABLE_PTHREAD)
+static pthread_mutex_t planMapLock = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
 static void initPlanMapLock() {
-#ifdef _OPENMP
+#if defined(_OPENMP)
 #pragma omp critical
   {
     if (!planMapLockInitialized) {
@@ -186,6 +1189,25 @@ static void initPlanMapLock() {
 #endif
 }
 
+// The plan map is guarded by an OpenMP lock, or by a mutex if the
+// library is built with the thread pool backend instead of OpenMP
+
+static void lockPlanMap() {
+#if defined(_OPENMP)
+  omp_set_lock(&planMapLock);
+#elif defined(ENABLE_PTHREAD)
+  pthread_mutex_lock(&planMapLock);
+#endif
+}
+
+static void unlockPlanMap() {
+#if defined(_OPENMP)
+  omp_unset_lock(&planMapLock);
+#elif defined(ENABLE_PTHREAD)
+  pthread_mutex_unlock(&planMapLock);
+#endif
+}
+
 static void planMap_clear() {
   if (planMap != NULL) ArrayMap_dispose(planMap);
   planMap = NULL;
@@ -217,6 +1239,10 @@ EXPORT void SleefDFT_setPlanFilePath(const char *path, const char *arch, uint64_
   planFilePathSet = 1;
 }
 
+EXPORT void SleefDFT_setPlanTimeLimit(uint64_t milliseconds) {
+  planTimeLimit = milliseconds;
+}
+
 static void loadPlanFromFile() {
   if (planFilePathSet == 0 && (planMode & SLEEF_PLAN_REFERTOENVVAR) != 0) {
     char *s = getenv(ENVVAR);
@@ -241,6 +1267,254 @@ static void savePlanToFile() {
   }
 }
 
+// In-memory plans
+
+static const char *getArchID() {
+  return archID != NULL ? archID : Sleef_getCpuIdString();
+}
+
+EXPORT size_t SleefDFT_exportPlans(char **buf) {
+  initPlanMapLock();
+
+  lockPlanMap();
+  if (!planFileLoaded) loadPlanFromFile();
+
+  *buf = ArrayMap_saveToString(planMap, getArchID(), PLANFILEID);
+
+  unlockPlanMap();
+  return strlen(*buf);
+}
+
+EXPORT int SleefDFT_importPlans(const char *buf) {
+  initPlanMapLock();
+
+  lockPlanMap();
+  if (!planFileLoaded) loadPlanFromFile();
+
+  int n = ArrayMap_loadFromString(planMap, buf, getArchID(), PLANFILEID);
+  if (n > 0) savePlanToFile();
+
+  unlockPlanMap();
+  return n;
+}
+
+// Binary plan files
+
+// A binary plan file starts with PLANFILEID and the arch ID on a
+// line, padded with zeros to TABLEFILEALIGN bytes.  A
+// TableFileHeader, the index of the tables, the tables themselves and
+// the plans in the text format follow.  Each table starts at a
+// multiple of TABLEFILEALIGN bytes, so that plans can use it directly
+// from the mapped file.
+
+#define TABLEFILEALIGN 256
+#define TABLEFILEMAGIC 0x5346445442303031ULL
+
+typedef struct TableFileHeader {
+  uint64_t magic, nTables, planOffset, planSize;
+} TableFileHeader;
+
+typedef struct TableFileEntry {
+  uint64_t key, offset, size;
+} TableFileEntry;
+
+static uint64_t alignTableFile(uint64_t x) {
+  return (x + TABLEFILEALIGN - 1) & ~(uint64_t)(TABLEFILEALIGN - 1);
+}
+
+static int writeZeros(FILE *fp, uint64_t n) {
+  static const char zeros[TABLEFILEALIGN];
+  return n == 0 || fwrite(zeros, 1, n, fp) == n;
+}
+
+EXPORT int SleefDFT_saveBinaryPlanFile(const char *path) {
+  char *plans;
+  size_t planSize = SleefDFT_exportPlans(&plans) + 1;
+
+  size_t idLen = strlen(PLANFILEID) + strlen(getArchID()) + 1;
+  char *id = (char *)malloc(idLen + 1);
+  sprintf(id, "%s%s\n", PLANFILEID, getArchID());
+
+  lockTableCache();
+
+  TableFileHeader h = { TABLEFILEMAGIC, 0, 0, planSize };
+  for(TableCacheEntry *e = tableCache;e != NULL;e = e->next) h.nTables++;
+
+  TableFileEntry *index = (TableFileEntry *)calloc(h.nTables + 1, sizeof(TableFileEntry));
+  uint64_t offset = alignTableFile(alignTableFile(idLen) + sizeof(TableFileHeader) + sizeof(TableFileEntry) * h.nTables);
+  int i = 0;
+  for(TableCacheEntry *e = tableCache;e != NULL;e = e->next, i++) {
+    index[i].key = e->key;
+    index[i].offset = offset;
+    index[i].size = e->size;
+    offset = alignTableFile(offset + e->size);
+  }
+  h.planOffset = offset;
+
+  // The file is written under a unique name in the same directory and
+  // then renamed, so that other processes never map a partially
+  // written file, and two processes saving at once do not write into
+  // the same file
+  char *tmpPath = (char *)malloc(strlen(path) + 10);
+#ifdef ENABLE_MMAP
+  sprintf(tmpPath, "%s.XXXXXX", path);
+  int fd = mkstemp(tmpPath);
+  if (fd >= 0) fchmod(fd, 0644);
+  FILE *fp = fd < 0 ? NULL : fdopen(fd, "wb");
+  if (fp == NULL && fd >= 0) close(fd);
+#else
+  sprintf(tmpPath, "%s.tmp", path);
+  FILE *fp = fopen(tmpPath, "wb");
+#endif
+
+  int ok = 0, created = fp != NULL;
+  if (created) {
+    ok = fwrite(id, 1, idLen, fp) == idLen && writeZeros(fp, alignTableFile(idLen) - idLen) &&
+      fwrite(&h, sizeof(h), 1, fp) == 1 &&
+      (h.nTables == 0 || fwrite(index, sizeof(TableFileEntry), h.nTables, fp) == h.nTables);
+    uint64_t pos = alignTableFile(idLen) + sizeof(TableFileHeader) + sizeof(TableFileEntry) * h.nTables;
+    i = 0;
+    for(TableCacheEntry *e = tableCache;ok && e != NULL;e = e->next, i++) {
+      ok = writeZeros(fp, index[i].offset - pos) && fwrite(e->ptr, 1, e->size, fp) == e->size;
+      pos = index[i].offset + e->size;
+    }
+    ok = ok && writeZeros(fp, h.planOffset - pos) && fwrite(plans, 1, planSize, fp) == planSize;
+    ok = fclose(fp) == 0 && ok;
+  }
+
+  unlockTableCache();
+
+  if (ok) {
+#if defined(__MINGW32__) || defined(__MINGW64__) || defined(_MSC_VER)
+    remove(path);
+#endif
+    ok = rename(tmpPath, path) == 0;
+  }
+  if (!ok && created) remove(tmpPath);
+
+  free(tmpPath);
+  free(index);
+  free(id);
+  free(plans);
+
+  return ok ? (int)h.nTables : -1;
+}
+
+EXPORT int SleefDFT_loadBinaryPlanFile(const char *path) {
+#ifdef ENABLE_MMAP
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return -1; }
+  uint64_t fileSize = (uint64_t)st.st_size;
+
+  // The mapping is shared with every other process that maps the same
+  // file, and is kept until the process exits unless every table in it
+  // is already cached
+  char *base = (char *)mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) return -1;
+
+  size_t idLen = strlen(PLANFILEID) + strlen(getArchID()) + 1;
+  uint64_t indexOffset = alignTableFile(idLen) + sizeof(TableFileHeader);
+  int valid = indexOffset <= fileSize &&
+    strncmp(base, PLANFILEID, strlen(PLANFILEID)) == 0 &&
+    strncmp(base + strlen(PLANFILEID), getArchID(), strlen(getArchID())) == 0 &&
+    base[idLen-1] == '\n';
+
+  TableFileHeader h;
+  if (valid) {
+    memcpy(&h, base + alignTableFile(idLen), sizeof(h));
+    valid = h.magic == TABLEFILEMAGIC && h.nTables <= (fileSize - indexOffset) / sizeof(TableFileEntry) &&
+      h.planSize >= 1 && h.planOffset <= fileSize && h.planSize <= fileSize - h.planOffset &&
+      base[h.planOffset + h.planSize - 1] == '\0';
+  }
+
+  const TableFileEntry *index = (const TableFileEntry *)(base + indexOffset);
+  for(uint64_t i=0;valid && i<h.nTables;i++) {
+    valid = index[i].offset % TABLEFILEALIGN == 0 && index[i].offset <= fileSize &&
+      index[i].size <= fileSize - index[i].offset && index[i].size == TableCache_keySize(index[i].key) &&
+      TableCache_validContents(index[i].key, base + index[i].offset, index[i].size);
+  }
+
+  if (!valid || SleefDFT_importPlans(base + h.planOffset) < 0) {
+    munmap(base, fileSize);
+    return -1;
+  }
+
+  int n = 0;
+  lockTableCache();
+  for(uint64_t i=0;i<h.nTables;i++) {
+    TableCacheEntry *e;
+    for(e = tableCache;e != NULL;e = e->next) if (e->key == index[i].key) break;
+    if (e != NULL) continue;
+
+    e = (TableCacheEntry *)malloc(sizeof(TableCacheEntry));
+    e->key = index[i].key;
+    e->ptr = base + index[i].offset;
+    e->size = index[i].size;
+    e->refCount = 1;
+    e->next = tableCache;
+    tableCache = e;
+    n++;
+  }
+  unlockTableCache();
+
+  if (n == 0) munmap(base, fileSize);
+
+  return n;
+#else
+  return -1;
+#endif
+}
+
+// Executes a six-step plan on files. The output file is created or
+// truncated, and both files are mapped, so that only the panels being
+// transformed need to be resident.
+
+EXPORT int SleefDFT_executeFile(SleefDFT *p, const char *inPath, const char *outPath) {
+  assert(p != NULL && (p->magic == MAGICLG_FLOAT || p->magic == MAGICLG_DOUBLE));
+
+#ifdef ENABLE_MMAP
+  const size_t size = (size_t)p->lgLength * 2 * (p->magic == MAGICLG_DOUBLE ? sizeof(double) : sizeof(float));
+
+  int fdIn = open(inPath, O_RDONLY);
+  if (fdIn < 0) return -1;
+
+  struct stat st;
+  if (fstat(fdIn, &st) != 0 || (uint64_t)st.st_size < size) { close(fdIn); return -1; }
+
+  int fdOut = open(outPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fdOut < 0) { close(fdIn); return -1; }
+
+  if (ftruncate(fdOut, (off_t)size) != 0) { close(fdIn); close(fdOut); return -1; }
+
+  void *in = mmap(NULL, size, PROT_READ, MAP_SHARED, fdIn, 0);
+  void *out = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fdOut, 0);
+  close(fdIn);
+  close(fdOut);
+
+  int ret = -1;
+
+  if (in != MAP_FAILED && out != MAP_FAILED) {
+    if (p->magic == MAGICLG_DOUBLE) {
+      SleefDFT_double_execute(p, (const double *)in, (double *)out);
+    } else {
+      SleefDFT_float_execute(p, (const float *)in, (float *)out);
+    }
+    ret = msync(out, size, MS_SYNC) == 0 ? 0 : -1;
+  }
+
+  if (in != MAP_FAILED) munmap(in, size);
+  if (out != MAP_FAILED) munmap(out, size);
+
+  return ret;
+#else
+  return -1;
+#endif
+}
+
 #define CATBIT 8
 #define BASETYPEIDBIT 2
 #define LOG2LENBIT 8
@@ -276,6 +1550,21 @@ static uint64_t keyTrans(int baseTypeID, int hlen, int vlen, int transConfig) {
   return k;
 }
 
+#define NDRANKBIT 4
+#define NDLOG2LENBIT 5
+#define NDCONFIGBIT 2
+
+static uint64_t keyND(int baseTypeID, int rank, const uint32_t *log2len, int ndConfig) {
+  int cat = 5;
+  uint64_t k = 0;
+  k = (k << NDCONFIGBIT) | (ndConfig & ~(~(uint64_t)0 << NDCONFIGBIT));
+  for(int a=0;a<rank;a++) k = (k << NDLOG2LENBIT) | (log2len[a] & ~(~(uint64_t)0 << NDLOG2LENBIT));
+  k = (k << NDRANKBIT) | (rank & ~(~(uint64_t)0 << NDRANKBIT));
+  k = (k << BASETYPEIDBIT) | (baseTypeID & ~(~(uint64_t)0 << BASETYPEIDBIT));
+  k = (k << CATBIT) | (cat & ~(~(uint64_t)0 << CATBIT));
+  return k;
+}
+
 static uint64_t keyPath(int baseTypeID, int log2len, int dir, int level, int config) {
   dir = (dir & SLEEF_MODE_BACKWARD) == 0;
   int cat = 3;
@@ -322,16 +1611,12 @@ int PlanManager_loadMeasurementResultsP(SleefDFT *p, int pathCat) {
 
   initPlanMapLock();
 
-#ifdef _OPENMP
-  omp_set_lock(&planMapLock);
-#endif
+  lockPlanMap();
   if (!planFileLoaded) loadPlanFromFile();
 
   int stat = planMap_getU64(keyButStat(p->baseTypeID, p->log2len, p->mode, pathCat+10));
   if (stat == 0) {
-#ifdef _OPENMP
-    omp_unset_lock(&planMapLock);
-#endif
+    unlockPlanMap();
     return 0;
   }
 
@@ -340,15 +1625,24 @@ int PlanManager_loadMeasurementResultsP(SleefDFT *p, int pathCat) {
   for(int j = p->log2len;j >= 0;j--) {
     p->bestPath[j] = planMap_getU64(keyPath(p->baseTypeID, p->log2len, p->mode, j, pathCat));
     p->bestPathConfig[j] = planMap_getU64(keyPathConfig(p->baseTypeID, p->log2len, p->mode, j, pathCat));
-    if (p->bestPath[j] > MAXBUTWIDTH) ret = 0;
+    if (p->bestPath[j] > MAXBUTWIDTH || p->bestPath[j] < 0) ret = 0;
+    if (p->bestPathConfig[j] >= PATHCONFIGMAX || p->bestPathConfig[j] < 0) ret = 0;
+  }
+
+  // Imported plans may be inconsistent, so check that the path covers
+  // every level exactly
+
+  int level = p->log2len;
+  while(ret && level > 0) {
+    if (p->bestPath[level] == 0) ret = 0;
+    level -= p->bestPath[level];
   }
+  if (level != 0) ret = 0;
 
   p->pathLen = 0;
   for(int j = p->log2len;j >= 0;j--) if (p->bestPath[j] != 0) p->pathLen++;
   
-#ifdef _OPENMP
-  omp_unset_lock(&planMapLock);
-#endif
+  unlockPlanMap();
   return ret;
 }
 
@@ -357,15 +1651,11 @@ void PlanManager_saveMeasurementResultsP(SleefDFT *p, int pathCat) {
 
   initPlanMapLock();
 
-#ifdef _OPENMP
-  omp_set_lock(&planMapLock);
-#endif
+  lockPlanMap();
   if (!planFileLoaded) loadPlanFromFile();
 
   if (planMap_getU64(keyButStat(p->baseTypeID, p->log2len, p->mode, pathCat+10)) != 0) {
-#ifdef _OPENMP
-    omp_unset_lock(&planMapLock);
-#endif
+    unlockPlanMap();
     return;
   }
   
@@ -378,9 +1668,7 @@ void PlanManager_saveMeasurementResultsP(SleefDFT *p, int pathCat) {
 
   if ((planMode & SLEEF_PLAN_READONLY) == 0) savePlanToFile();
 
-#ifdef _OPENMP
-  omp_unset_lock(&planMapLock);
-#endif
+  unlockPlanMap();
 }
 
 int PlanManager_loadMeasurementResultsT(SleefDFT *p) {
@@ -388,18 +1676,16 @@ int PlanManager_loadMeasurementResultsT(SleefDFT *p) {
 
   initPlanMapLock();
 
-#ifdef _OPENMP
-  omp_set_lock(&planMapLock);
-#endif
+  lockPlanMap();
   if (!planFileLoaded) loadPlanFromFile();
 
   p->tmNoMT = planMap_getU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 0));
   p->tmMT   = planMap_getU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 1));
+  p->tmSep   = planMap_getU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 2));
+  p->tmPanel = planMap_getU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 3));
   
-#ifdef _OPENMP
-  omp_unset_lock(&planMapLock);
-#endif
-  return p->tmNoMT != 0;
+  unlockPlanMap();
+  return p->tmNoMT != 0 && p->tmSep != 0;
 }
 
 void PlanManager_saveMeasurementResultsT(SleefDFT *p) {
@@ -407,17 +1693,46 @@ void PlanManager_saveMeasurementResultsT(SleefDFT *p) {
 
   initPlanMapLock();
 
-#ifdef _OPENMP
-  omp_set_lock(&planMapLock);
-#endif
+  lockPlanMap();
   if (!planFileLoaded) loadPlanFromFile();
 
   planMap_putU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 0), p->tmNoMT);
   planMap_putU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 1), p->tmMT  );
+  planMap_putU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 2), p->tmSep  );
+  planMap_putU64(keyTrans(p->baseTypeID, p->log2hlen, p->log2vlen, 3), p->tmPanel);
   
   if ((planMode & SLEEF_PLAN_READONLY) == 0) savePlanToFile();
 
-#ifdef _OPENMP
-  omp_unset_lock(&planMapLock);
-#endif
+  unlockPlanMap();
+}
+
+int PlanManager_loadMeasurementResultsN(SleefDFT *p) {
+  assert(p != NULL && (p->magic == MAGICND_FLOAT || p->magic == MAGICND_DOUBLE));
+
+  initPlanMapLock();
+
+  lockPlanMap();
+  if (!planFileLoaded) loadPlanFromFile();
+
+  p->ndTm[0] = planMap_getU64(keyND(p->baseTypeID, p->ndRank, p->ndLog2Len, 0));
+  p->ndTm[1] = planMap_getU64(keyND(p->baseTypeID, p->ndRank, p->ndLog2Len, 1));
+
+  unlockPlanMap();
+  return p->ndTm[0] != 0 && p->ndTm[1] != 0;
+}
+
+void PlanManager_saveMeasurementResultsN(SleefDFT *p) {
+  assert(p != NULL && (p->magic == MAGICND_FLOAT || p->magic == MAGICND_DOUBLE));
+
+  initPlanMapLock();
+
+  lockPlanMap();
+  if (!planFileLoaded) loadPlanFromFile();
+
+  planMap_putU64(keyND(p->baseTypeID, p->ndRank, p->ndLog2Len, 0), p->ndTm[0]);
+  planMap_putU64(keyND(p->baseTypeID, p->ndRank, p->ndLog2Len, 1), p->ndTm[1]);
+
+  if ((planMode & SLEEF_PLAN_READONLY) == 0) savePlanToFile();
+
+  unlockPlanMap();
 }
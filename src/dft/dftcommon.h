@@ -7,7 +7,14 @@
 #define CONFIG_STREAM 1
 #define CONFIG_MT 2
 
+// A stage with this config bit runs a Stockham kernel, which computes
+// its output offsets instead of reading them from a permutation
+// table. The kernel tables are indexed by the other bits.
+#define CONFIG_STOCKHAM 4
+#define PATHCONFIGMAX (CONFIGMAX*2)
+
 #define MAXLOG2LEN 32
+#define MAXNDRANK 8
 
 typedef struct SleefDFT {
   uint32_t magic;
@@ -15,6 +22,7 @@ typedef struct SleefDFT {
   int baseTypeID;
   const void *in;
   void *out;
+  int memLocked;
   
   union {
     struct {
@@ -32,36 +40,197 @@ typedef struct SleefDFT {
       int vecwidth, log2vecwidth;
       int nThread;
   
-      uint64_t tm[CONFIGMAX][(MAXBUTWIDTH+1)*32];
+      uint64_t tm[PATHCONFIGMAX][(MAXBUTWIDTH+1)*32];
       uint64_t bestTime;
       int16_t bestPath[32], bestPathConfig[32], pathLen;
+
+      uint64_t planDeadline;
+      struct AsyncPlanner *planner;
+
+      void *winTbl, *specTbl;
+      double outScale;
+      int hasScale, winReal;
     };
 
     struct {
       int32_t hlen, vlen;
       int32_t log2hlen, log2vlen;
-      uint64_t tmNoMT, tmMT;
+      uint64_t tmNoMT, tmMT, tmSep, tmPanel;
       struct SleefDFT *instH, *instV;
-      void *tBuf;
+      void *tBuf, **tPanel;
+      int tNThread;
+    };
+
+    struct {
+      uint32_t length;
+      int radix, mrIsa, mrConfig, mrNThread, mrVec;
+      struct SleefDFT *instSub;
+      void *mrTbl, *mrCoef;
+      void **mrBuf0, **mrBuf1;
+      double mrScale;
+      int mrHasScale;
+    };
+
+    struct {
+      uint32_t bsLength, bsLength2;
+      int bsNThread;
+      struct SleefDFT *instF, *instB;
+      void *bsChirp, *bsKernel;
+      void **bsBuf0, **bsBuf1;
+    };
+
+    struct {
+      uint32_t rrLength;
+      int rrNThread;
+      struct SleefDFT *instReal;
+      void *rrTbl;
+      void **rrBuf0, **rrBuf1;
+    };
+
+    struct {
+      uint32_t btLength, howmany, istride, idist, ostride, odist;
+      int btInSize, btInCount, btOutSize, btOutCount;
+      int btNThread, btMT, btIsa, btLog2Block;
+      struct SleefDFT *instBatch;
+      void **btBuf0, **btBuf1;
+    };
+
+    struct {
+      int ndRank, ndPow2, ndMT, ndNThread, ndPitch;
+      uint32_t ndLen[MAXNDRANK], ndLog2Len[MAXNDRANK], ndTotal;
+      uint64_t ndTm[2];
+      struct SleefDFT *ndInst[MAXNDRANK];
+      void *ndBuf;
+      void **ndLine0, **ndLine1;
+    };
+
+    struct {
+      int32_t r2hlen, r2vlen, r2hc;
+      int r2NThread, r2MT, r2Pitch;
+      struct SleefDFT *instRow, *instCol;
+      void *r2Buf;
+      void **r2Line0, **r2Line1;
+    };
+
+    struct {
+      uint32_t spTotal;
+      int spNThread;
+      struct SleefDFT *instSplit;
+      void *spBuf0, *spBuf1;
+      void **spLine;
+    };
+
+    struct {
+      uint32_t fmTotal;
+      int fmNThread, fmIn, fmOut;
+      struct SleefDFT *instFormat;
+      void *fmBuf;
+      void **fmLine;
+    };
+
+    struct {
+      uint32_t cvLength, cvKernelLen, cvBlockLen;
+      size_t cvHistSize;
+      struct SleefDFT *instCF, *instCB;
+      void *cvHist;
+      void **cvBuf0, **cvBuf1;
+    };
+
+    struct {
+      uint32_t stLength, stHop, stRingLen, stODist, stOutCount;
+      int stNThread, stMT, stIsa, stLog2Block;
+      size_t stAlign;
+      struct SleefDFT *instFrame;
+      void **stBuf0, **stBuf1;
+    };
+
+    struct {
+      uint32_t lgLength, lgLen1, lgLen2, lgPanel;
+      int lgNThread, lgMT, lgLog2Lo, lgIsa;
+      struct SleefDFT *instL1, *instL2;
+      void *lgTwLo, *lgTwHi;
+      void **lgBuf;
+    };
+
+    struct {
+      uint32_t prLength, prInCount, prOutStart, prOutCount, prSubLen, prPanel;
+      int prNThread, prMT, prLog2Lo, prInput;
+      struct SleefDFT *instPR;
+      void *prTwLo, *prTwHi, *prTw;
+      void **prBuf, **prPanelBuf, **prAcc;
+    };
+
+    struct {
+      uint32_t gzLength, gzBinCount, gzPadCount, gzTwStep;
+      int gzIsa, gzVecWidth, gzCplx, gzNThread, gzMT;
+      void *gzCoef, *gzSin, *gzRot, *gzBins, *gzTw, *gzBuf;
+    };
+
+    struct {
+      uint32_t czLength, czOutCount, czLength2;
+      int czNThread;
+      struct SleefDFT *instCZF, *instCZB;
+      void *czPre, *czPost, *czKernel;
+      void **czBuf0, **czBuf1;
     };
   };
 } SleefDFT;
 
 #define SLEEF_MODE2_MT1D       (1 << 0)
+#define SLEEF_MODE2_DEFER      (1 << 1)
+#define SLEEF_MODE2_REFINE     (1 << 2)
 #define SLEEF_MODE3_MT2D       (1 << 0)
 
+#define SLEEF_MODE_FORMAT_IN  (SLEEF_MODE_FP16_IN  | SLEEF_MODE_BF16_IN  | SLEEF_MODE_INT16_IN  | SLEEF_MODE_INT32_IN)
+#define SLEEF_MODE_FORMAT_OUT (SLEEF_MODE_FP16_OUT | SLEEF_MODE_BF16_OUT | SLEEF_MODE_INT16_OUT | SLEEF_MODE_INT32_OUT)
+
 #define PLANFILEID "SLEEFDFT0\n"
 #define ENVVAR "SLEEFDFTPLAN"
 
 #define SLEEF_MODE_MEASUREBITS (3 << 20)
 
+uint64_t TableCache_keyTwiddle(int baseTypeID, int log2len, int sign, int log2vecwidth, int N, int level);
+uint64_t TableCache_keyPerm(int log2len, int log2vecwidth, int N, int level);
+void *TableCache_acquire(uint64_t key);
+void *TableCache_insert(uint64_t key, void *ptr, size_t size);
+void TableCache_release(void *ptr);
+
+void KernelChunk_set(int index, int count);
+int KernelChunk_begin(int k);
+int KernelChunk_end(int k);
+int Executor_threadCount();
+int Executor_slotCount();
+int Executor_slot();
+void Executor_run(void (*task)(void *, int), void *arg, int nTask);
+void Executor_parallelFor(void (*body)(void *, int), void *arg, int n, int nTask);
+
+// State of a plan whose path is being measured in the background.
+// The measurement runs on refined, a private copy of the plan, which
+// is published to path by a single atomic store once it can be used.
+// Executes load path, and run on the refined copy from then on, so
+// the copy is kept until the plan is disposed.
+
+typedef struct AsyncPlanner {
+#ifdef ENABLE_PTHREAD
+  pthread_t thread;
+#endif
+  SleefDFT *refined, *path;
+  volatile int cancel, joined;
+} AsyncPlanner;
+
 void freeTables(SleefDFT *p);
+void bindPathTables_double(SleefDFT *p);
+void bindPathTables_float(SleefDFT *p);
 uint32_t ilog2(uint32_t q);
+uint32_t perm(int nbits, uint32_t k, int s, int d);
+uint32_t *makePermTable(int log2len, int log2vecwidth, int N, int level);
 
 //int PlanManager_loadMeasurementResultsB(SleefDFT *p);
 //void PlanManager_saveMeasurementResultsB(SleefDFT *p, int butStat);
 int PlanManager_loadMeasurementResultsT(SleefDFT *p);
 void PlanManager_saveMeasurementResultsT(SleefDFT *p);
+int PlanManager_loadMeasurementResultsN(SleefDFT *p);
+void PlanManager_saveMeasurementResultsN(SleefDFT *p);
 int PlanManager_loadMeasurementResultsP(SleefDFT *p, int pathCat);
 void PlanManager_saveMeasurementResultsP(SleefDFT *p, int pathCat);
 
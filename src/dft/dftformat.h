@@ -0,0 +1,57 @@
+//   Copyright Naoki Shibata and contributors 2010 - 2021.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// Formats of the input and output of a plan, and the conversions of
+// the 16-bit floating-point formats. This file is included by dft.c
+// and by the kernels through vectortype.h.
+
+#ifndef __DFTFORMAT_H__
+#define __DFTFORMAT_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#define FORMAT_REAL  0
+#define FORMAT_FP16  1
+#define FORMAT_BF16  2
+#define FORMAT_INT16 3
+#define FORMAT_INT32 4
+#define FORMAT_SPLIT 5
+
+// A binary16 or bfloat16 value is kept in a uint16_t. Conversions to
+// these formats round to nearest even and keep NaNs quiet. The cases
+// are selected without branches, so that a loop over a vector of
+// values is vectorised by the compiler.
+
+static INLINE float bitsToFloat(uint32_t u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+static INLINE uint32_t floatToBits(float f) { uint32_t u; memcpy(&u, &f, sizeof(u)); return u; }
+
+static INLINE float fp16ToFloat(uint16_t h) {
+  const uint32_t s = (uint32_t)(h & 0x8000) << 16, m = h & 0x7fff;
+  const uint32_t special = (m << 13) | 0x7f800000, normal = (m << 13) + 0x38000000;
+  const uint32_t subnormal = floatToBits((float)(int32_t)m * 0x1p-24f);
+  return bitsToFloat(s | (m >= 0x7c00 ? special : m < 0x400 ? subnormal : normal));
+}
+
+static INLINE uint16_t floatToFp16(float f) {
+  const uint32_t u = floatToBits(f), s = (u >> 16) & 0x8000, x = u & 0x7fffffff;
+  const uint32_t nan = 0x7e00 | ((x >> 13) & 0x3ff);
+
+  // Below 2^-14 the result is subnormal. Adding 0.5 moves the value
+  // into a binade whose ulp is the ulp of a subnormal half.
+  const uint32_t subnormal = floatToBits(bitsToFloat(x) + 0.5f) - 0x3f000000;
+  const uint32_t normal = (x + 0xfff + ((x >> 13) & 1) - 0x38000000) >> 13;
+
+  return (uint16_t)(s | (x > 0x7f800000 ? nan : x >= 0x477ff000 ? 0x7c00 : x < 0x38800000 ? subnormal : normal));
+}
+
+static INLINE float bf16ToFloat(uint16_t h) { return bitsToFloat((uint32_t)h << 16); }
+
+static INLINE uint16_t floatToBf16(float f) {
+  const uint32_t x = floatToBits(f);
+  return (uint16_t)((x & 0x7fffffff) > 0x7f800000 ? (x >> 16) | 0x40 : (x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+#endif
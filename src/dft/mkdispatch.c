@@ -12,6 +12,29 @@
 #error ENABLE_STREAM not defined
 #endif
 
+// Prints a table of the kernels prefix%d<dir>_<config>_<isa>, where
+// dir is f or b. If fwd2 is set, the backward table takes the forward
+// radix-2 kernel, as there is no backward one.
+static void printButTable(const char *basetype, const char *prefix, char dir, const char *args, int maxbutwidth, int enable_stream, int argc, char **argv, int isastart, int fwd2) {
+  printf("void (*%s%c_%s[CONFIGMAX][ISAMAX][MAXBUTWIDTH+1])(%s) = {\n", prefix, dir, basetype, args);
+  for(int config=0;config<4;config++) {
+    printf("  {\n");
+    for(int k=isastart;k<argc;k++) {
+      printf("    {NULL, ");
+      for(int i=1;i<=maxbutwidth;i++) {
+	if (enable_stream || (config & 1) == 0) {
+	  printf("%s%d%c_%d_%s, ", prefix, 1 << i, fwd2 && i == 1 ? 'f' : dir, config, argv[k]);
+	} else {
+	  printf("NULL, ");
+	}
+      }
+      printf("},\n");
+    }
+    printf("},\n");
+  }
+  printf("};\n\n");
+}
+
 int main(int argc, char **argv) {
   if (argc < 3) {
     fprintf(stderr, "Usage : %s <basetype> <unrollmax> <unrollmax2> <maxbutwidth> <isa> ...\n", argv[0]);
@@ -49,10 +72,25 @@ int main(int argc, char **argv) {
 	printf("void tbut%db_%d_%s(real *, uint32_t *, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
 	printf("void but%df_%d_%s(real *, uint32_t *, const int, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
 	printf("void but%db_%d_%s(real *, uint32_t *, const int, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void sbut%df_%d_%s(real *, uint32_t *, const int, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void sbut%db_%d_%s(real *, uint32_t *, const int, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void stbut%df_%d_%s(real *, uint32_t *, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void stbut%db_%d_%s(real *, uint32_t *, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void iotbut%df_%d_%s(real *, uint32_t *, const void *, const void *, const int, const int, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void iotbut%db_%d_%s(real *, uint32_t *, const void *, const void *, const int, const int, const real *, const int, const real *, const int);\n", 1 << j, config, argv[k]);
+	printf("void iodft%df_%d_%s(void *, void *, const int, const void *, const void *, const int, const int, const real);\n", 1 << j, config, argv[k]);
+	printf("void iodft%db_%d_%s(void *, void *, const int, const void *, const void *, const int, const int, const real);\n", 1 << j, config, argv[k]);
+      }
+      for(int r=3;r<=7;r+=2) {
+	printf("void mrbut%df_%d_%s(real *, const real *, const int, const real *);\n", r, config, argv[k]);
+	printf("void mrbut%db_%d_%s(real *, const real *, const int, const real *);\n", r, config, argv[k]);
       }
     }
-    printf("void realSub0_%s(real *, const real *, const int, const real *, const real *);\n", argv[k]);
-    printf("void realSub1_%s(real *, const real *, const int, const real *, const real *, const int);\n", argv[k]);
+    printf("void realSub0_%s(real *, const real *, const int, const real *, const real *, const real, const real *);\n", argv[k]);
+    printf("void realSub1_%s(real *, const real *, const int, const real *, const real *, const int, const real *);\n", argv[k]);
+    printf("void goertzel_%s(real *, const real *, const real *, const int, const int);\n", argv[k]);
+    printf("void twiddleRow_%s(real *, const real *, const real *, const int, const uint64_t, const int);\n", argv[k]);
+    printf("void slide_%s(real *, const real *, const real *, const int, const real *, const int, const int, const int);\n", argv[k]);
     printf("int getInt_%s(int);\n", argv[k]);
     printf("const void *getPtr_%s(int);\n", argv[k]);
   }
@@ -171,16 +209,86 @@ int main(int argc, char **argv) {
   }
   printf("};\n\n");
 
+  // Stockham kernels, which take no permutation table
+
+  const char *butArgs = "real *, uint32_t *, const int, const real *, const int, const real *, const int";
+  const char *tbutArgs = "real *, uint32_t *, const real *, const int, const real *, const int";
+
+  printButTable(basetype, "sbut", 'f', butArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+  printButTable(basetype, "sbut", 'b', butArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+  printButTable(basetype, "stbut", 'f', tbutArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+  printButTable(basetype, "stbut", 'b', tbutArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+
+  // Kernels for the first and last stages of plans with weights, a
+  // scale factor, or other input and output formats
+
+  const char *iotbutArgs = "real *, uint32_t *, const void *, const void *, const int, const int, const real *, const int, const real *, const int";
+  const char *iodftArgs = "void *, void *, const int, const void *, const void *, const int, const int, const real";
+  printButTable(basetype, "iotbut", 'f', iotbutArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+  printButTable(basetype, "iotbut", 'b', iotbutArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+  printButTable(basetype, "iodft", 'f', iodftArgs, maxbutwidth, enable_stream, argc, argv, isastart, 0);
+  printButTable(basetype, "iodft", 'b', iodftArgs, maxbutwidth, enable_stream, argc, argv, isastart, 1);
+
+  printf("void (*mrbutf_%s[CONFIGMAX][ISAMAX][8])(real *, const real *, const int, const real *) = {\n", basetype);
+  for(int config=0;config<4;config++) {
+    printf("  {\n");
+    for(int k=isastart;k<argc;k++) {
+      printf("    {NULL, NULL, NULL, ");
+      for(int r=3;r<=7;r+=2) {
+	if (enable_stream || (config & 1) == 0) {
+	  printf("mrbut%df_%d_%s, ", r, config, argv[k]);
+	} else {
+	  printf("NULL, ");
+	}
+	if (r != 7) printf("NULL, ");
+      }
+      printf("},\n");
+    }
+    printf("},\n");
+  }
+  printf("};\n\n");
+
+  printf("void (*mrbutb_%s[CONFIGMAX][ISAMAX][8])(real *, const real *, const int, const real *) = {\n", basetype);
+  for(int config=0;config<4;config++) {
+    printf("  {\n");
+    for(int k=isastart;k<argc;k++) {
+      printf("    {NULL, NULL, NULL, ");
+      for(int r=3;r<=7;r+=2) {
+	if (enable_stream || (config & 1) == 0) {
+	  printf("mrbut%db_%d_%s, ", r, config, argv[k]);
+	} else {
+	  printf("NULL, ");
+	}
+	if (r != 7) printf("NULL, ");
+      }
+      printf("},\n");
+    }
+    printf("},\n");
+  }
+  printf("};\n\n");
+
   //
 
-  printf("void (*realSub0_%s[ISAMAX])(real *, const real *, const int, const real *, const real *) = {\n  ", basetype);
+  printf("void (*realSub0_%s[ISAMAX])(real *, const real *, const int, const real *, const real *, const real, const real *) = {\n  ", basetype);
   for(int k=isastart;k<argc;k++) printf("realSub0_%s, ", argv[k]);
   printf("\n};\n\n");
 
-  printf("void (*realSub1_%s[ISAMAX])(real *, const real *, const int, const real *, const real *, const int) = {\n  ", basetype);
+  printf("void (*realSub1_%s[ISAMAX])(real *, const real *, const int, const real *, const real *, const int, const real *) = {\n  ", basetype);
   for(int k=isastart;k<argc;k++) printf("realSub1_%s, ", argv[k]);
   printf("\n};\n\n");
 
+  printf("void (*goertzel_%s[ISAMAX])(real *, const real *, const real *, const int, const int) = {\n  ", basetype);
+  for(int k=isastart;k<argc;k++) printf("goertzel_%s, ", argv[k]);
+  printf("\n};\n\n");
+
+  printf("void (*slide_%s[ISAMAX])(real *, const real *, const real *, const int, const real *, const int, const int, const int) = {\n  ", basetype);
+  for(int k=isastart;k<argc;k++) printf("slide_%s, ", argv[k]);
+  printf("\n};\n\n");
+
+  printf("void (*twiddleRow_%s[ISAMAX])(real *, const real *, const real *, const int, const uint64_t, const int) = {\n  ", basetype);
+  for(int k=isastart;k<argc;k++) printf("twiddleRow_%s, ", argv[k]);
+  printf("\n};\n\n");
+
   printf("int (*getInt_%s[16])(int) = {\n  ", basetype);
   for(int k=isastart;k<argc;k++) printf("getInt_%s, ", argv[k]);
   for(int k=0;k<16-(argc-isastart);k++) printf("NULL, ");
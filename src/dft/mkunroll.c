@@ -37,6 +37,92 @@ char *replaceAll(const char *in, const char *pat, const char *replace) {
   return str;
 }
 
+// The first stage of a plan whose input has weights or is not an
+// interleaved array of reals is computed by a copy of the tbut kernel
+// that reads the input with loadiow, see vectortype.h. The weights are
+// two planes of the input size, or one plane if winReal is set, and
+// win0 is NULL if there are none. The copy computes the output offsets
+// of a Stockham kernel if q is NULL. The last stage of a plan with a
+// scale factor or another output format is computed by a copy of the
+// dft kernel that writes the output with storeio. The dft copy also
+// reads its input with loadio, so that it can be the only stage.
+
+char *ioTbutVariant(const char *func) {
+  char str[256];
+  int radix = atoi(func + strlen("ALIGNED(8192) void tbut")), log2radix = 0;
+  while((1 << log2radix) < radix) log2radix++;
+
+  char *s0 = replaceAll(func, "ALIGNED(8192) void tbut", "ALIGNED(8192) void iotbut");
+  char *s1 = replaceAll(s0, "const real *RESTRICT in0, const int inShift", "const void *in0, const void *in1, const int ifmt, const int inShift");
+  char *s2 = replaceAll(s1, "const int K) {\n", "const int K, const real *win0, const int winReal) {\n");
+  sprintf(str, "    const real *win = win0 == NULL ? NULL : win0 + i0*2, *wim = win0 == NULL || winReal ? NULL : win0 + (%d << inShift) + i0*2;\n", radix*2);
+  char *s3 = replaceAll(s2, "    const real *in = in0 + i0*2;\n", str);
+  char *s4 = replaceAll(s3, "load(in, ", "loadiow(in0, in1, ifmt, win, wim, i0, ");
+  sprintf(str, "real *out = q != NULL ? out0 + q[i] : out0 + (i0 << %d);", log2radix + 1);
+  char *s5 = replaceAll(s4, "real *out = out0 + q[i];", str);
+  free(s0); free(s1); free(s2); free(s3); free(s4);
+  return s5;
+}
+
+char *ioDftVariant(const char *func) {
+  char *s0 = replaceAll(func, "ALIGNED(8192) void dft", "ALIGNED(8192) void iodft");
+  char *s1 = replaceAll(s0, "(real *RESTRICT out0, const real *RESTRICT in0, const int shift) {\n",
+			"(void *out0, void *out1, const int ofmt, const void *in0, const void *in1, const int ifmt, const int shift, const real scale) {\n"
+			"  const real2 vscale = loadc(scale);\n");
+  char *s2 = replaceAll(s1, "    real *out = out0 + i0*2;\n", "");
+  char *s3 = replaceAll(s2, "    const real *in = in0 + i0*2;\n", "");
+  char *s4 = replaceAll(s3, "load(in, ", "loadio(in0, in1, ifmt, i0, ");
+  char *s5 = replaceAll(s4, "store(out, ", "storeio(vscale, out0, out1, ofmt, i0, ");
+  char *s6 = replaceAll(s5, "stream(out, ", "streamio(vscale, out0, out1, ofmt, i0, ");
+  free(s0); free(s1); free(s2); free(s3); free(s4); free(s5);
+  return s6;
+}
+
+// A Stockham kernel computes the output offset q[i] of a but or tbut
+// kernel instead of loading it from the permutation table. The
+// offset of the vector at i0 is i0 with log2(radix) zero bits inserted
+// at bit outShift, and outShift is 0 for the first stage. The table
+// argument is kept, so that the kernels have the same signatures.
+
+char *stockhamVariant(const char *func, const char *name) {
+  char str[256], pat[64], rep[64];
+  sprintf(pat, "ALIGNED(8192) void %s", name);
+  sprintf(rep, "ALIGNED(8192) void s%s", name);
+  int radix = atoi(strstr(func, pat) + strlen(pat)), log2radix = 0;
+  while((1 << log2radix) < radix) log2radix++;
+
+  if (strcmp(name, "but") == 0) {
+    sprintf(str, "real *out = out0 + ((((i0 >> outShift) << (outShift + %d)) | (i0 & ((1 << outShift) - 1))) << 1);", log2radix);
+  } else {
+    sprintf(str, "real *out = out0 + (i0 << %d);", log2radix + 1);
+  }
+
+  char *s0 = replaceAll(func, pat, rep);
+  char *s1 = replaceAll(s0, "real *out = out0 + q[i];", str);
+  free(s0);
+  return s1;
+}
+
+void emitVariants(FILE *fp, const char *func) {
+  char *v[2] = { NULL, NULL };
+
+  if (strncmp(func, "ALIGNED(8192) void dft", 22) == 0) {
+    v[0] = ioDftVariant(func);
+  } else if (strncmp(func, "ALIGNED(8192) void tbut", 23) == 0) {
+    v[0] = stockhamVariant(func, "tbut");
+    v[1] = ioTbutVariant(func);
+  } else {
+    v[0] = stockhamVariant(func, "but");
+  }
+
+  for(int i=0;i<2;i++) {
+    if (v[i] == NULL) continue;
+    fputs("\n", fp);
+    fputs(v[i], fp);
+    free(v[i]);
+  }
+}
+
 #define LEN 1024
 char line[LEN+10];
 
@@ -65,6 +151,11 @@ int main(int argc, char **argv) {
       fputs("#include \"vectortype.h\"\n\n", fpout);
       fprintf(fpout, "extern %s ctbl_%s[];\n", baseType, baseType);
       fprintf(fpout, "#define ctbl ctbl_%s\n\n", baseType);
+      fputs("int KernelChunk_begin(int k);\n", fpout);
+      fputs("int KernelChunk_end(int k);\n\n", fpout);
+
+      char *func = NULL;
+      size_t funcLen = 0, funcCap = 0;
 
       for(;;) {
 	if (fgets(line, LEN, fpin) == NULL) break;
@@ -85,6 +176,13 @@ int main(int argc, char **argv) {
 	  char *s0 = replaceAll(s, "#pragma", "//");
 	  free(s);
 	  s = s0;
+	} else {
+	  // MT kernels process the chunk of the loop assigned to the
+	  // calling task of the threading backend
+	  char *s0 = replaceAll(s, "#pragma omp parallel for", "  const int iEnd = KernelChunk_end(k);");
+	  char *s1 = replaceAll(s0, "for(i=0;i < k;i++) {", "for(i=KernelChunk_begin(k);i < iEnd;i++) {");
+	  free(s); free(s0);
+	  s = s1;
 	}
 
 	if (config == 0) {
@@ -94,6 +192,29 @@ int main(int argc, char **argv) {
 	}
 	
 	fputs(s, fpout);
+
+	// A kernel ends with a closing brace at the start of a line
+
+	if (func == NULL && (strncmp(s, "ALIGNED(8192) void dft", 22) == 0 || strncmp(s, "ALIGNED(8192) void tbut", 23) == 0 ||
+			     strncmp(s, "ALIGNED(8192) void but", 22) == 0)) {
+	  funcCap = 1 << 16;
+	  func = malloc(funcCap);
+	  funcLen = 0;
+	}
+
+	if (func != NULL) {
+	  size_t len = strlen(s);
+	  while (funcLen + len + 1 > funcCap) func = realloc(func, funcCap *= 2);
+	  memcpy(func + funcLen, s, len + 1);
+	  funcLen += len;
+
+	  if (strcmp(s, "}\n") == 0) {
+	    emitVariants(fpout, func);
+	    free(func);
+	    func = NULL;
+	  }
+	}
+
 	free(s);
       }
     
@@ -7,6 +7,7 @@
 #define __VECTORTYPE_H__
 
 #include <math.h>
+#include <string.h>
 #include "sleef.h"
 
 #ifdef ENABLE_SSE2
@@ -63,6 +64,7 @@
 
 #define IMPORT_IS_EXPORT
 #include "sleefdft.h"
+#include "dftformat.h"
 
 #if BASETYPEID == 1
 #define LOG2VECWIDTH (LOG2VECTLENDP-1)
@@ -138,4 +140,139 @@ static INLINE void prefetch(real *ptr, int offset) { vprefetch_v_p(&ptr[2*offset
 #error No BASETYPEID specified
 #endif
 
+// Interleaving and deinterleaving of VECWIDTH elements of a split
+// array. With __builtin_shufflevector, two half-width vectors are
+// combined in registers, and otherwise the elements go through memory.
+
+#if defined(__has_builtin) && !defined(ENABLE_SVE) && !defined(ENABLE_PUREC)
+#if __has_builtin(__builtin_shufflevector) && VECWIDTH >= 2 && VECWIDTH <= 8
+#define ENABLE_SHUFFLEVECTOR
+#endif
+#endif
+
+#ifdef ENABLE_SHUFFLEVECTOR
+typedef real halfvec_t __attribute__((vector_size(sizeof(real)*VECWIDTH)));
+typedef real fullvec_t __attribute__((vector_size(sizeof(real)*VECWIDTH*2)));
+
+#if VECWIDTH == 2
+#define SHUFFLE_ZIP 0, 2, 1, 3
+#define SHUFFLE_EVEN 0, 2
+#define SHUFFLE_ODD 1, 3
+#elif VECWIDTH == 4
+#define SHUFFLE_ZIP 0, 4, 1, 5, 2, 6, 3, 7
+#define SHUFFLE_EVEN 0, 2, 4, 6
+#define SHUFFLE_ODD 1, 3, 5, 7
+#else
+#define SHUFFLE_ZIP 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15
+#define SHUFFLE_EVEN 0, 2, 4, 6, 8, 10, 12, 14
+#define SHUFFLE_ODD 1, 3, 5, 7, 9, 11, 13, 15
+#endif
+#endif
+
+static INLINE real2 zipPlanes(const real *re, const real *im) {
+#ifdef ENABLE_SHUFFLEVECTOR
+  halfvec_t a, b;
+  memcpy(&a, re, sizeof(a));
+  memcpy(&b, im, sizeof(b));
+  return (real2)__builtin_shufflevector(a, b, SHUFFLE_ZIP);
+#else
+  real t[VECWIDTH*2];
+  for(int j=0;j<VECWIDTH;j++) {
+    t[j*2+0] = re[j];
+    t[j*2+1] = im[j];
+  }
+  return loadu(t, 0);
+#endif
+}
+
+static INLINE void unzipPlanes(real *re, real *im, real2 v) {
+#ifdef ENABLE_SHUFFLEVECTOR
+  fullvec_t w = (fullvec_t)v;
+  halfvec_t a = __builtin_shufflevector(w, w, SHUFFLE_EVEN), b = __builtin_shufflevector(w, w, SHUFFLE_ODD);
+  memcpy(re, &a, sizeof(a));
+  memcpy(im, &b, sizeof(b));
+#else
+  real t[VECWIDTH*2];
+  storeu(t, 0, v);
+  for(int j=0;j<VECWIDTH;j++) {
+    re[j] = t[j*2+0];
+    im[j] = t[j*2+1];
+  }
+#endif
+}
+
+// Loads and stores of the iotbut and iodft kernel variants, which
+// read the input or write the output of a plan in another format, or
+// with weights or a scale factor. A
+// vector holds the elements i0+offset to i0+offset+VECWIDTH-1. In
+// FORMAT_REAL, p0 is an interleaved array of reals. In FORMAT_SPLIT,
+// p0 and p1 are the planes of real and imaginary parts. In FORMAT_FP16
+// and FORMAT_BF16, p0 is an interleaved array of 16-bit values, which
+// are converted through a temporary array. A fixed-point input is
+// converted in the same way. A fixed-point output is stored as reals
+// in p0, since its exponent is only known after the transform, and
+// p1 holds the largest magnitude seen in each lane. A lane that sees
+// a value that is not finite holds infinity.
+
+static INLINE real2 loadio(const void *p0, const void *p1, int fmt, int i0, int offset) {
+  const int o = i0 + offset;
+  if (fmt == FORMAT_REAL) return load((const real *)p0, o);
+  if (fmt == FORMAT_SPLIT) return zipPlanes((const real *)p0 + o, (const real *)p1 + o);
+
+  const uint16_t *h = (const uint16_t *)p0 + o*2;
+  real t[VECWIDTH*2];
+  if (fmt == FORMAT_FP16) {
+    for(int j=0;j<VECWIDTH*2;j++) t[j] = fp16ToFloat(h[j]);
+  } else if (fmt == FORMAT_BF16) {
+    for(int j=0;j<VECWIDTH*2;j++) t[j] = bf16ToFloat(h[j]);
+  } else if (fmt == FORMAT_INT16) {
+    for(int j=0;j<VECWIDTH*2;j++) t[j] = (real)((const int16_t *)p0)[o*2+j];
+  } else {
+    for(int j=0;j<VECWIDTH*2;j++) t[j] = (real)((const int32_t *)p0)[o*2+j];
+  }
+  return loadu(t, 0);
+}
+
+static INLINE void storeio(real2 c, void *p0, void *p1, int fmt, int i0, int offset, real2 v) {
+  const int o = i0 + offset;
+  v = times(v, c);
+  if (fmt == FORMAT_REAL) { store((real *)p0, o, v); return; }
+  if (fmt == FORMAT_SPLIT) { unzipPlanes((real *)p0 + o, (real *)p1 + o, v); return; }
+
+  uint16_t *h = (uint16_t *)p0 + o*2;
+  real t[VECWIDTH*2];
+  storeu(t, 0, v);
+  if (fmt == FORMAT_INT16 || fmt == FORMAT_INT32) {
+    real *m = (real *)p1;
+    store((real *)p0, o, v);
+    for(int j=0;j<VECWIDTH*2;j++) {
+      const real a = t[j] < 0 ? -t[j] : t[j];
+      m[j] = a - a == 0 ? (a > m[j] ? a : m[j]) : INFINITY;
+    }
+  } else if (fmt == FORMAT_FP16) {
+    for(int j=0;j<VECWIDTH*2;j++) h[j] = floatToFp16((float)t[j]);
+  } else {
+    for(int j=0;j<VECWIDTH*2;j++) h[j] = floatToBf16((float)t[j]);
+  }
+}
+
+// A weighted load is v * w - reverse(v) * wi on real lanes and v * w +
+// reverse(v) * wi on imaginary lanes, which is a complex
+// multiplication if w and wi hold the duplicated real and imaginary
+// parts. A real window takes only the plane w, and wi is NULL. Without
+// weights, w is NULL. A streamed store bypasses the cache only in
+// FORMAT_REAL.
+
+static INLINE real2 loadiow(const void *p0, const void *p1, int fmt, const real *w, const real *wi, int i0, int offset) {
+  real2 v = loadio(p0, p1, fmt, i0, offset);
+  if (w == NULL) return v;
+  if (wi == NULL) return times(v, load(w, offset));
+  return timesminusplus(v, load(w, offset), times(reverse(v), load(wi, offset)));
+}
+
+static INLINE void streamio(real2 c, void *p0, void *p1, int fmt, int i0, int offset, real2 v) {
+  if (fmt == FORMAT_REAL) { stream((real *)p0, i0 + offset, times(v, c)); return; }
+  storeio(c, p0, p1, fmt, i0, offset, v);
+}
+
 #endif